@@ -25,7 +25,7 @@ int main(int argc, char *argv[])
     
     // variables for calculating and applying an imbalance factor
     double p2p_lat_s_time = 0.0, lat_t_total = 0.0, p2p_latency = 0.0;
-    double imbalance_factor = 0.0, im_s_time = 0.0, im_f_time = 0.0; 
+    double arrival = 0.0, exit_time = 0.0;
     MPI_Status lat_req_stat;
 
     set_header(HEADER);
@@ -42,8 +42,6 @@ int main(int argc, char *argv[])
     MPI_CHECK(MPI_Init(&argc, &argv));
     MPI_CHECK(MPI_Comm_rank(MPI_COMM_WORLD, &rank));
     MPI_CHECK(MPI_Comm_size(MPI_COMM_WORLD, &numprocs));
-    
-    srand((int)MPI_Wtime() + rank);
 
     switch (po_ret) {
         case PO_BAD_USAGE:
@@ -80,11 +78,6 @@ int main(int argc, char *argv[])
         options.max_message_size = options.max_mem_limit;
     }
 
-    options.min_message_size /= sizeof(float);
-    if (options.min_message_size < MIN_MESSAGE_SIZE) {
-        options.min_message_size = MIN_MESSAGE_SIZE;
-    }
-
     bufsize = sizeof(float)*(options.max_message_size/sizeof(float));
     if (allocate_memory_coll((void**)&sendbuf, bufsize, options.accel)) {
         fprintf(stderr, "Could Not Allocate Memory [rank %d]\n", rank);
@@ -99,15 +92,38 @@ int main(int argc, char *argv[])
     }
     set_buffer(recvbuf, options.accel, 0, bufsize);
 
+    if (allocate_latency_samples()) {
+        fprintf(stderr, "Could Not Allocate Memory [rank %d]\n", rank);
+        MPI_CHECK(MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE));
+    }
+
+    if (allocate_skew_samples()) {
+        fprintf(stderr, "Could Not Allocate Memory [rank %d]\n", rank);
+        MPI_CHECK(MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE));
+    }
+
+    if (init_arrival_pattern(rank, numprocs)) {
+        MPI_CHECK(MPI_Finalize());
+        exit(EXIT_FAILURE);
+    }
+    init_delay();
+    sync_clocks(MPI_COMM_WORLD);
+
     print_preamble(rank);
     if (rank == 0)printf("# BK OSU Allreduce MIF %.2f\n", options.max_imbalance_factor);
+    print_arrival_pattern(rank);
+    if (rank == 0) printf("# Delay injection: %s\n", delay_description());
+    if (rank == 0) printf("# Clock sync error: %.2f us\n", clock_sync_error() * 1e6);
 
-    for (size=options.min_message_size; size*sizeof(float) <= options.max_message_size; size *= 2) {
+    for (size=first_message_size(sizeof(float)); size*sizeof(float) <= options.max_message_size; size = next_message_size(size, sizeof(float))) {
 
         if (size > LARGE_MESSAGE_SIZE) {
             options.skip = options.skip_large;
             options.iterations = options.iterations_large;
         }
+
+        // resample the clocks now and then so the drift estimate follows the run
+        resync_clocks(MPI_COMM_WORLD);
         
         // do a p2p lat test with rank (world_size - 1) to get lat for current msize
         if(rank == 0){
@@ -140,26 +156,14 @@ int main(int argc, char *argv[])
                 MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
             }
 
-            // calculate imbalance factor
-            if(0 == rank){
-                imbalance_factor = 0;
-            }
-			else if(1 == rank){
-                imbalance_factor = options.max_imbalance_factor;
-            }
-            else{
-               imbalance_factor = ((double)rand()/(double)RAND_MAX) * options.max_imbalance_factor;
-            }
-            // apply imbalance factor
-			/*im_s_time = MPI_Wtime();*/
-			/*im_f_time = im_s_time + imbalance_factor * p2p_latency;*/
-			/*while(im_f_time > MPI_Wtime());*/
-			int64_t sleep_time = (int64_t)(p2p_latency * imbalance_factor * 1e6);
-			usleep(sleep_time);
+            // apply the arrival delay of this rank, size and iteration
+            inject_delay(arrival_delay(size, i, p2p_latency));
 
+            arrival = global_time();
             t_start = MPI_Wtime();
             MPI_CHECK(MPI_Allreduce(sendbuf, recvbuf, size, MPI_FLOAT, MPI_SUM, MPI_COMM_WORLD ));
             t_stop=MPI_Wtime();
+            exit_time = global_time();
 
             if (options.validate) {
                 errors += validate_reduction(recvbuf, size, i, numprocs, options.accel);
@@ -167,6 +171,8 @@ int main(int argc, char *argv[])
 
             if (i>=options.skip){
                 timer+=t_stop-t_start;
+                record_latency_sample((t_stop - t_start) * 1e6);
+                record_skew_sample(i - options.skip, arrival, exit_time);
             }
             MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
         }
@@ -180,18 +186,19 @@ int main(int argc, char *argv[])
                 MPI_COMM_WORLD));
         avg_time = avg_time/numprocs;
 
-        if (options.validate) {
-            print_stats_validate(rank, size * sizeof(float), avg_time, min_time,
-                                max_time, errors);
-        } else {
-            print_stats(rank, size * sizeof(float), avg_time, min_time, max_time);
-        }
+        reduce_latency_samples(MPI_COMM_WORLD);
+        reduce_skew_samples(MPI_COMM_WORLD, options.iterations);
+        print_stats_pap(rank, size * sizeof(float), avg_time, min_time,
+                        max_time, errors);
         MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
     }
 
     free_buffer(sendbuf, options.accel);
     free_buffer(recvbuf, options.accel);
 
+    free_latency_samples();
+    free_arrival_pattern();
+    free_skew_samples();
     MPI_CHECK(MPI_Finalize());
 
     if (NONE != options.accel) {
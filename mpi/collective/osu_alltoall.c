@@ -18,11 +18,13 @@ main (int argc, char *argv[])
     double timer=0.0;
     double avg_time = 0.0, max_time = 0.0, min_time = 0.0;
     char * sendbuf = NULL, * recvbuf = NULL;
+    struct coll_args args = {0};
     int po_ret;
     int errors = 0;
     size_t bufsize;
     options.bench = COLLECTIVE;
     options.subtype = LAT;
+    options.features = FEATURE_ITERATION_SYNC;
 
     set_header(HEADER);
     set_benchmark_name("osu_alltoall");
@@ -85,15 +87,26 @@ main (int argc, char *argv[])
     }
 
     set_buffer(recvbuf, options.accel, 0, bufsize);
+    if (allocate_latency_samples()) {
+        fprintf(stderr, "Could Not Allocate Memory [rank %d]\n", rank);
+        MPI_CHECK(MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE));
+    }
+
+    args.sendbuf = sendbuf;
+    args.recvbuf = recvbuf;
+
     print_preamble(rank);
 
-    for (size=options.min_message_size; size <= options.max_message_size; size *= 2) {
+    for (size=first_message_size(1); size <= options.max_message_size; size = next_message_size(size, 1)) {
         if (size > LARGE_MESSAGE_SIZE) {
             options.skip = options.skip_large;
             options.iterations = options.iterations_large;
         }
 
-        MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
+        args.count = size;
+        adaptive_begin();
+
+        iteration_sync_begin(MPI_COMM_WORLD);
         timer=0.0;
 
         for (i=0; i < options.iterations + options.skip ; i++) {
@@ -103,8 +116,7 @@ main (int argc, char *argv[])
                 MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
             }
             t_start = MPI_Wtime();
-            MPI_CHECK(MPI_Alltoall(sendbuf, size, MPI_CHAR, recvbuf, size, MPI_CHAR,
-                    MPI_COMM_WORLD));
+            coll_alltoall(&args);
             t_stop = MPI_Wtime();
 
             if (options.validate) {
@@ -113,9 +125,12 @@ main (int argc, char *argv[])
 
             if (i >= options.skip) {
                 timer+=t_stop-t_start;
+                record_latency_sample((t_stop - t_start) * 1e6);
             }
-            MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
+            adaptive_check(MPI_COMM_WORLD, i);
+            iteration_sync(MPI_COMM_WORLD);
         }
+        iteration_sync_end(MPI_COMM_WORLD);
         latency = (double)(timer * 1e6) / options.iterations;
 
         MPI_CHECK(MPI_Reduce(&latency, &min_time, 1, MPI_DOUBLE, MPI_MIN, 0,
@@ -126,6 +141,7 @@ main (int argc, char *argv[])
                 MPI_COMM_WORLD));
         avg_time = avg_time/numprocs;
 
+        reduce_latency_samples(MPI_COMM_WORLD);
         if (options.validate) {
             print_stats_validate(rank, size * sizeof(char), avg_time, min_time,
                                 max_time, errors);
@@ -138,6 +154,7 @@ main (int argc, char *argv[])
     free_buffer(sendbuf, options.accel);
     free_buffer(recvbuf, options.accel);
 
+    free_latency_samples();
     MPI_CHECK(MPI_Finalize());
 
     if (NONE != options.accel) {
@@ -12,16 +12,18 @@
 
 int main(int argc, char *argv[])
 {
-    int i = 0, rank = 0, size, numprocs, disp;
+    int i = 0, rank = 0, size, numprocs;
     double latency=0.0, t_start = 0.0, t_stop = 0.0;
     double timer=0.0;
     double avg_time = 0.0, max_time = 0.0, min_time = 0.0;
     char *sendbuf=NULL, *recvbuf=NULL;
-    int *rdispls=NULL, *recvcounts=NULL, *sdispls=NULL, *sendcounts=NULL;
+    int *rdispls=NULL, *recvcounts=NULL;
+    struct coll_args args = {0};
     int po_ret;
     size_t bufsize;
     options.bench = COLLECTIVE;
     options.subtype = LAT;
+    options.features = FEATURE_ITERATION_SYNC;
 
     set_header(HEADER);
     set_benchmark_name("osu_alltoallv");
@@ -71,19 +73,11 @@ int main(int argc, char *argv[])
         fprintf(stderr, "Could Not Allocate Memory [rank %d]\n", rank);
         MPI_CHECK(MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE));
     }
-    if (allocate_memory_coll((void**)&sendcounts, numprocs*sizeof(int), NONE)) {
-        fprintf(stderr, "Could Not Allocate Memory [rank %d]\n", rank);
-        MPI_CHECK(MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE));
-    }
 
     if (allocate_memory_coll((void**)&rdispls, numprocs*sizeof(int), NONE)) {
         fprintf(stderr, "Could Not Allocate Memory [rank %d]\n", rank);
         MPI_CHECK(MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE));
     }
-    if (allocate_memory_coll((void**)&sdispls, numprocs*sizeof(int), NONE)) {
-        fprintf(stderr, "Could Not Allocate Memory [rank %d]\n", rank);
-        MPI_CHECK(MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE));
-    }
 
     bufsize = options.max_message_size * numprocs;
     if (allocate_memory_coll((void**)&sendbuf, bufsize, options.accel)) {
@@ -99,42 +93,50 @@ int main(int argc, char *argv[])
     }
     set_buffer(recvbuf, options.accel, 0, bufsize);
 
+    if (allocate_latency_samples()) {
+        fprintf(stderr, "Could Not Allocate Memory [rank %d]\n", rank);
+        MPI_CHECK(MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE));
+    }
+
+    /* the same counts and displacements for sending and receiving */
+    args.sendbuf = sendbuf;
+    args.recvbuf = recvbuf;
+    args.counts = recvcounts;
+    args.displs = rdispls;
+
     print_preamble(rank);
 
     MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
 
-    for (size=options.min_message_size; size <= options.max_message_size; size *= 2) {
+    for (size=first_message_size(1); size <= options.max_message_size; size = next_message_size(size, 1)) {
         if (size > LARGE_MESSAGE_SIZE) {
             options.skip = options.skip_large;
             options.iterations = options.iterations_large;
         }
 
-        disp =0;
-        for (i = 0; i < numprocs; i++) {
-            recvcounts[i] = size;
-            sendcounts[i] = size;
-            rdispls[i] = disp;
-            sdispls[i] = disp;
-            disp += size;
+        args.count = size;
+        coll_counts_uniform(&args, numprocs);
 
-        }
+        adaptive_begin();
 
-        MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
+        iteration_sync_begin(MPI_COMM_WORLD);
 
         timer=0.0;
         for (i = 0; i < options.iterations + options.skip; i++) {
             t_start = MPI_Wtime();
 
-              MPI_CHECK(MPI_Alltoallv(sendbuf, sendcounts, sdispls, MPI_CHAR, recvbuf, recvcounts, rdispls, MPI_CHAR,
-                      MPI_COMM_WORLD));
+            coll_alltoallv(&args);
 
             t_stop = MPI_Wtime();
 
             if (i>=options.skip) {
                 timer+=t_stop-t_start;
+                record_latency_sample((t_stop - t_start) * 1e6);
             }
-            MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
+            adaptive_check(MPI_COMM_WORLD, i);
+            iteration_sync(MPI_COMM_WORLD);
         }
+        iteration_sync_end(MPI_COMM_WORLD);
 
         latency = (double)(timer * 1e6) / options.iterations;
 
@@ -146,18 +148,18 @@ int main(int argc, char *argv[])
                 MPI_COMM_WORLD));
         avg_time = avg_time/numprocs;
 
+        reduce_latency_samples(MPI_COMM_WORLD);
         print_stats(rank, size, avg_time, min_time, max_time);
 
         MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
     }
 
     free_buffer(rdispls, NONE);
-    free_buffer(sdispls, NONE);
     free_buffer(recvcounts, NONE);
-    free_buffer(sendcounts, NONE);
     free_buffer(sendbuf, options.accel);
     free_buffer(recvbuf, options.accel);
 
+    free_latency_samples();
     MPI_CHECK(MPI_Finalize());
 
     if (NONE != options.accel) {
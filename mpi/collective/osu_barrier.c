@@ -65,18 +65,26 @@ int main(int argc, char *argv[])
         return EXIT_FAILURE;
     }
 
+    if (allocate_latency_samples()) {
+        fprintf(stderr, "Could Not Allocate Memory [rank %d]\n", rank);
+        MPI_CHECK(MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE));
+    }
+
     print_preamble(rank);
 
     timer = 0.0;
+    adaptive_begin();
 
     for (i=0; i < options.iterations + options.skip ; i++) {
         t_start = MPI_Wtime();
-        MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
+        coll_barrier(NULL);
         t_stop = MPI_Wtime();
 
         if (i>=options.skip){
             timer+=t_stop-t_start;
+            record_latency_sample((t_stop - t_start) * 1e6);
         }
+        adaptive_check(MPI_COMM_WORLD, i);
     }
 
     MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
@@ -91,7 +99,9 @@ int main(int argc, char *argv[])
                 MPI_COMM_WORLD));
     avg_time = avg_time/numprocs;
 
+    reduce_latency_samples(MPI_COMM_WORLD);
     print_stats(rank, 0, avg_time, min_time, max_time);
+    free_latency_samples();
     MPI_CHECK(MPI_Finalize());
 
     return EXIT_SUCCESS;
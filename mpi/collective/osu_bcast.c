@@ -18,9 +18,11 @@ int main(int argc, char *argv[])
     double latency = 0.0, t_start = 0.0, t_stop = 0.0;
     double timer=0.0;
     char *buffer=NULL;
+    struct coll_args args = {0};
     int po_ret;
     options.bench = COLLECTIVE;
     options.subtype = LAT;
+    options.features = FEATURE_ITERATION_SYNC;
 
     set_header(HEADER);
     set_benchmark_name("osu_bcast");
@@ -78,26 +80,39 @@ int main(int argc, char *argv[])
     }
     set_buffer(buffer, options.accel, 1, options.max_message_size);
 
+    if (allocate_latency_samples()) {
+        fprintf(stderr, "Could Not Allocate Memory [rank %d]\n", rank);
+        MPI_CHECK(MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE));
+    }
+
+    args.sendbuf = buffer;
+
     print_preamble(rank);
 
-    for (size=options.min_message_size; size <= options.max_message_size; size *= 2) {
+    for (size=first_message_size(1); size <= options.max_message_size; size = next_message_size(size, 1)) {
         if (size > LARGE_MESSAGE_SIZE) {
             options.skip = options.skip_large; 
             options.iterations = options.iterations_large;
         }
 
+        args.count = size;
         timer=0.0;
+        adaptive_begin();
+        iteration_sync_begin(MPI_COMM_WORLD);
         for (i=0; i < options.iterations + options.skip ; i++) {
             t_start = MPI_Wtime();
-            MPI_CHECK(MPI_Bcast(buffer, size, MPI_CHAR, 0, MPI_COMM_WORLD));
+            coll_bcast(&args);
             t_stop = MPI_Wtime();
 
             if (i>=options.skip){
                 timer+=t_stop-t_start;
+                record_latency_sample((t_stop - t_start) * 1e6);
             }
-            MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
+            adaptive_check(MPI_COMM_WORLD, i);
+            iteration_sync(MPI_COMM_WORLD);
 
         }
+        iteration_sync_end(MPI_COMM_WORLD);
 
         MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
 
@@ -111,11 +126,13 @@ int main(int argc, char *argv[])
                 MPI_COMM_WORLD));
         avg_time = avg_time/numprocs;
 
+        reduce_latency_samples(MPI_COMM_WORLD);
         print_stats(rank, size, avg_time, min_time, max_time);
     }
 
     free_buffer(buffer, options.accel);
 
+    free_latency_samples();
     MPI_CHECK(MPI_Finalize());
 
     if (NONE != options.accel) {
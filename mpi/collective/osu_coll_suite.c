@@ -0,0 +1,358 @@
+#define BENCHMARK "OSU MPI%s Collective Latency Suite"
+/*
+ * Copyright (C) 2002-2021 the Network-Based Computing Laboratory
+ * (NBCL), The Ohio State University.
+ *
+ * Contact: Dr. D. K. Panda (panda@cse.ohio-state.edu)
+ *
+ * For detailed copyright and licensing information, please refer to the
+ * copyright file COPYRIGHT in the top level OMB directory.
+ */
+#include <osu_util_mpi.h>
+
+#ifdef PACKAGE_VERSION
+#   define COLL_HEADER(name) "# OSU MPI%s " name " Latency Test v" PACKAGE_VERSION "\n"
+#else
+#   define COLL_HEADER(name) "# OSU MPI%s " name " Latency Test\n"
+#endif
+
+/*
+ * Runs several blocking collectives in one MPI job.  All kernels share one
+ * pair of buffers sized for the largest collective, so MPI_Init, launch and
+ * allocation are paid once for the whole sweep.  The kernels are the coll_*
+ * calls the standalone tests time as well.
+ */
+static struct coll_args args;
+static int numprocs;
+
+struct coll_bench {
+    char const * name;
+    char const * header;
+    void (*run)(struct coll_args const * args);
+    void (*set_counts)(struct coll_args * args, int numprocs);
+    size_t type_size;
+    int has_size;
+};
+
+static struct coll_bench const benchmarks[] = {
+    {"allgather", COLL_HEADER("Allgather"), coll_allgather, NULL, 1, 1},
+    {"allgatherv", COLL_HEADER("Allgatherv"), coll_allgatherv,
+        coll_counts_uniform, 1, 1},
+    {"allreduce", COLL_HEADER("Allreduce"), coll_allreduce, NULL,
+        sizeof(float), 1},
+    {"alltoall", COLL_HEADER("All-to-All Personalized Exchange"),
+        coll_alltoall, NULL, 1, 1},
+    {"alltoallv", COLL_HEADER("All-to-Allv Personalized Exchange"),
+        coll_alltoallv, coll_counts_uniform, 1, 1},
+    {"barrier", COLL_HEADER("Barrier"), coll_barrier, NULL, 1, 0},
+    {"bcast", COLL_HEADER("Broadcast"), coll_bcast, NULL, 1, 1},
+    {"gather", COLL_HEADER("Gather"), coll_gather, NULL, 1, 1},
+    {"gatherv", COLL_HEADER("Gatherv"), coll_gatherv, coll_counts_uniform, 1,
+        1},
+    {"reduce", COLL_HEADER("Reduce"), coll_reduce, NULL, sizeof(float), 1},
+    {"reduce_scatter", COLL_HEADER("Reduce_scatter"), coll_reduce_scatter,
+        coll_counts_split, sizeof(float), 1},
+    {"scatter", COLL_HEADER("Scatter"), coll_scatter, NULL, 1, 1},
+    {"scatterv", COLL_HEADER("Scatterv"), coll_scatterv, coll_counts_uniform,
+        1, 1},
+};
+
+#define NUM_BENCHMARKS (sizeof(benchmarks) / sizeof(benchmarks[0]))
+
+static struct coll_bench const * find_benchmark (char const * name, size_t len)
+{
+    size_t i;
+
+    /* accept both "allreduce" and "osu_allreduce" */
+    if (len > 4 && 0 == strncmp(name, "osu_", 4)) {
+        name += 4;
+        len -= 4;
+    }
+
+    for (i = 0; i < NUM_BENCHMARKS; i++) {
+        if (strlen(benchmarks[i].name) == len &&
+                0 == strncmp(benchmarks[i].name, name, len)) {
+            return &benchmarks[i];
+        }
+    }
+
+    return NULL;
+}
+
+/*
+ * Cold pass: every iteration runs on new buffers from the cache pool, or on
+ * the usual buffers after flushing them. Fresh pass: every iteration runs on
+ * buffers the MPI library has not registered yet, kept up to the memory
+ * limit so that few reuse the address of another. The barrier after the
+ * preparation keeps its cost and skew out of the timed collective.
+ */
+static double run_extra (struct coll_bench const * bench, size_t size,
+        int fresh)
+{
+    void *hot_sendbuf = args.sendbuf, *hot_recvbuf = args.recvbuf;
+    double t_start = 0.0, timer = 0.0, latency = 0.0, avg_time = 0.0;
+    int i;
+
+    for (i = 0; i < options.iterations + options.skip; i++) {
+        if (fresh) {
+            args.sendbuf = fresh_buffer(2 * i, size);
+            args.recvbuf = fresh_buffer(2 * i + 1, size);
+        } else if (CACHE_COLD == options.cache_state) {
+            args.sendbuf = cache_buffer(2 * i, size);
+            args.recvbuf = cache_buffer(2 * i + 1, size);
+        } else {
+            flush_cache(args.sendbuf, size);
+            flush_cache(args.recvbuf, size);
+        }
+        MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
+
+        t_start = MPI_Wtime();
+        bench->run(&args);
+        if (i >= options.skip) {
+            timer += MPI_Wtime() - t_start;
+        }
+    }
+
+    if (fresh) {
+        free_fresh_buffers();
+    }
+
+    args.sendbuf = hot_sendbuf;
+    args.recvbuf = hot_recvbuf;
+    latency = (double)(timer * 1e6) / options.iterations;
+
+    MPI_CHECK(MPI_Reduce(&latency, &avg_time, 1, MPI_DOUBLE, MPI_SUM, 0,
+            MPI_COMM_WORLD));
+
+    return avg_time / numprocs;
+}
+
+static void run_benchmark (struct coll_bench const * bench, int rank,
+        int iterations, int skip)
+{
+    char name[64];
+    size_t size;
+    int i;
+    double latency = 0.0, t_start = 0.0, t_stop = 0.0;
+    double timer = 0.0;
+    double avg_time = 0.0, max_time = 0.0, min_time = 0.0;
+
+    snprintf(name, sizeof(name), "osu_%s", bench->name);
+    set_header(bench->header);
+    set_benchmark_name(name);
+
+    options.show_size = bench->has_size;
+    options.iterations = iterations;
+    options.skip = skip;
+
+    print_preamble(rank);
+
+    for (size = first_message_size(bench->type_size) * bench->type_size;
+            size <= options.max_message_size;
+            size = next_message_size(args.count, bench->type_size) *
+                bench->type_size) {
+        args.count = size / bench->type_size;
+
+        if (args.count > LARGE_MESSAGE_SIZE) {
+            options.skip = options.skip_large;
+            options.iterations = options.iterations_large;
+        }
+
+        if (bench->set_counts) {
+            bench->set_counts(&args, numprocs);
+        }
+
+        adaptive_begin();
+
+        iteration_sync_begin(MPI_COMM_WORLD);
+
+        timer = 0.0;
+        for (i = 0; i < options.iterations + options.skip; i++) {
+            t_start = MPI_Wtime();
+            bench->run(&args);
+            t_stop = MPI_Wtime();
+
+            if (i >= options.skip) {
+                timer += t_stop - t_start;
+                record_latency_sample((t_stop - t_start) * 1e6);
+            }
+            adaptive_check(MPI_COMM_WORLD, i);
+            iteration_sync(MPI_COMM_WORLD);
+        }
+        iteration_sync_end(MPI_COMM_WORLD);
+        latency = (double)(timer * 1e6) / options.iterations;
+
+        MPI_CHECK(MPI_Reduce(&latency, &min_time, 1, MPI_DOUBLE, MPI_MIN, 0,
+                MPI_COMM_WORLD));
+        MPI_CHECK(MPI_Reduce(&latency, &max_time, 1, MPI_DOUBLE, MPI_MAX, 0,
+                MPI_COMM_WORLD));
+        MPI_CHECK(MPI_Reduce(&latency, &avg_time, 1, MPI_DOUBLE, MPI_SUM, 0,
+                MPI_COMM_WORLD));
+        avg_time = avg_time/numprocs;
+
+        /* large enough for the rooted and all-to-all collectives */
+        if (CACHE_HOT != options.cache_state) {
+            set_cold_latency(run_extra(bench, size * numprocs, 0));
+        }
+        if (FRESH_NONE != options.fresh_buffers) {
+            set_fresh_latency(run_extra(bench, size * numprocs, 1));
+        }
+
+        reduce_latency_samples(MPI_COMM_WORLD);
+        print_stats(rank, args.count * bench->type_size, avg_time, min_time,
+                max_time);
+        MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
+
+        if (!bench->has_size) {
+            break;
+        }
+    }
+}
+
+int main (int argc, char *argv[])
+{
+    struct coll_bench const * selected[NUM_BENCHMARKS];
+    size_t num_selected = 0, bufsize, len, i;
+    char const * list;
+    int rank, iterations, skip;
+    int po_ret;
+    options.bench = COLLECTIVE;
+    options.subtype = LAT_MULTI;
+    options.features = FEATURE_ITERATION_SYNC | FEATURE_CACHE;
+
+    set_header(HEADER);
+    set_benchmark_name("osu_coll_suite");
+    po_ret = process_options(argc, argv);
+
+    if (PO_OKAY == po_ret && NONE != options.accel) {
+        if (init_accel()) {
+            fprintf(stderr, "Error initializing device\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    MPI_CHECK(MPI_Init(&argc, &argv));
+    MPI_CHECK(MPI_Comm_rank(MPI_COMM_WORLD, &rank));
+    MPI_CHECK(MPI_Comm_size(MPI_COMM_WORLD, &numprocs));
+
+    switch (po_ret) {
+        case PO_BAD_USAGE:
+            print_bad_usage_message(rank);
+            MPI_CHECK(MPI_Finalize());
+            exit(EXIT_FAILURE);
+        case PO_HELP_MESSAGE:
+            print_help_message(rank);
+            MPI_CHECK(MPI_Finalize());
+            exit(EXIT_SUCCESS);
+        case PO_VERSION_MESSAGE:
+            print_version_message(rank);
+            MPI_CHECK(MPI_Finalize());
+            exit(EXIT_SUCCESS);
+        case PO_OKAY:
+            break;
+    }
+
+    if (numprocs < 2) {
+        if (rank == 0) {
+            fprintf(stderr, "This test requires at least two processes\n");
+        }
+
+        MPI_CHECK(MPI_Finalize());
+        exit(EXIT_FAILURE);
+    }
+
+    if (NULL == options.coll_list) {
+        for (i = 0; i < NUM_BENCHMARKS; i++) {
+            selected[num_selected++] = &benchmarks[i];
+        }
+    } else {
+        for (list = options.coll_list; *list; list += len) {
+            list += strspn(list, ",");
+            len = strcspn(list, ",");
+            if (0 == len) {
+                break;
+            }
+
+            selected[num_selected] = find_benchmark(list, len);
+            for (i = 0; i < num_selected; i++) {
+                if (selected[i] == selected[num_selected]) {
+                    selected[num_selected] = NULL;
+                }
+            }
+
+            if (NULL == selected[num_selected]) {
+                if (rank == 0) {
+                    fprintf(stderr, "Unknown or repeated collective [%.*s], "
+                            "available:", (int)len, list);
+                    for (i = 0; i < NUM_BENCHMARKS; i++) {
+                        fprintf(stderr, " %s", benchmarks[i].name);
+                    }
+                    fprintf(stderr, "\n");
+                }
+
+                MPI_CHECK(MPI_Finalize());
+                exit(EXIT_FAILURE);
+            }
+            num_selected++;
+        }
+    }
+
+    if ((options.max_message_size * numprocs) > options.max_mem_limit) {
+        options.max_message_size = options.max_mem_limit / numprocs;
+    }
+
+    /* large enough for the rooted and all-to-all collectives */
+    bufsize = options.max_message_size * numprocs;
+    if (allocate_memory_coll(&args.sendbuf, bufsize, options.accel)) {
+        fprintf(stderr, "Could Not Allocate Memory [rank %d]\n", rank);
+        MPI_CHECK(MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE));
+    }
+    set_buffer(args.sendbuf, options.accel, 1, bufsize);
+
+    if (allocate_memory_coll(&args.recvbuf, bufsize, options.accel)) {
+        fprintf(stderr, "Could Not Allocate Memory [rank %d]\n", rank);
+        MPI_CHECK(MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE));
+    }
+    set_buffer(args.recvbuf, options.accel, 0, bufsize);
+
+    if (allocate_memory_coll((void**)&args.counts, numprocs * sizeof(int),
+                NONE) ||
+            allocate_memory_coll((void**)&args.displs, numprocs * sizeof(int),
+                NONE)) {
+        fprintf(stderr, "Could Not Allocate Memory [rank %d]\n", rank);
+        MPI_CHECK(MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE));
+    }
+
+    if (allocate_latency_samples() || allocate_cache_pool(bufsize)) {
+        fprintf(stderr, "Could Not Allocate Memory [rank %d]\n", rank);
+        MPI_CHECK(MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE));
+    }
+
+    /* every collective starts from the small-message iteration counts */
+    iterations = options.iterations;
+    skip = options.skip;
+
+    for (i = 0; i < num_selected; i++) {
+        run_benchmark(selected[i], rank, iterations, skip);
+    }
+
+    free_buffer(args.sendbuf, options.accel);
+    free_buffer(args.recvbuf, options.accel);
+    free_buffer(args.counts, NONE);
+    free_buffer(args.displs, NONE);
+
+    free_latency_samples();
+    free_cache_pool();
+    MPI_CHECK(MPI_Finalize());
+
+    if (NONE != options.accel) {
+        if (cleanup_accel()) {
+            fprintf(stderr, "Error cleaning up device\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/* vi: set sw=4 sts=4 tw=80: */
@@ -12,16 +12,18 @@
 
 int main(int argc, char *argv[])
 {
-    int i, numprocs, rank, size, disp;
+    int i, numprocs, rank, size;
     double latency = 0.0, t_start = 0.0, t_stop = 0.0;
     double timer=0.0;
     double avg_time = 0.0, max_time = 0.0, min_time = 0.0;
     char *sendbuf, *recvbuf;
-    int *rdispls, *recvcounts;
+    int *rdispls=NULL, *recvcounts=NULL;
+    struct coll_args args = {0};
     int po_ret;
     size_t bufsize;
     options.bench = COLLECTIVE;
     options.subtype = LAT;
+    options.features = FEATURE_ITERATION_SYNC;
 
     set_header(HEADER);
     set_benchmark_name("osu_gatherv");
@@ -93,9 +95,19 @@ int main(int argc, char *argv[])
     }
     set_buffer(sendbuf, options.accel, 0, options.max_message_size);
 
+    if (allocate_latency_samples()) {
+        fprintf(stderr, "Could Not Allocate Memory [rank %d]\n", rank);
+        MPI_CHECK(MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE));
+    }
+
+    args.sendbuf = sendbuf;
+    args.recvbuf = recvbuf;
+    args.counts = recvcounts;
+    args.displs = rdispls;
+
     print_preamble(rank);
 
-    for (size=options.min_message_size; size <= options.max_message_size; size *= 2) {
+    for (size=first_message_size(1); size <= options.max_message_size; size = next_message_size(size, 1)) {
 
         if (size > LARGE_MESSAGE_SIZE) {
             options.skip = options.skip_large;
@@ -104,31 +116,31 @@ int main(int argc, char *argv[])
 
         MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
 
+        args.count = size;
         if (0 == rank) {
-            disp =0;
-            for ( i = 0; i < numprocs; i++) {
-                recvcounts[i] = size;
-                rdispls[i] = disp;
-                disp += size;
-            }
+            coll_counts_uniform(&args, numprocs);
         }
 
-        MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
+        adaptive_begin();
+
+        iteration_sync_begin(MPI_COMM_WORLD);
         timer=0.0;
         for (i=0; i < options.iterations + options.skip ; i++) {
 
             t_start = MPI_Wtime();
 
-            MPI_CHECK(MPI_Gatherv(sendbuf, size, MPI_CHAR, recvbuf, recvcounts,
-                                    rdispls, MPI_CHAR, 0, MPI_COMM_WORLD));
+            coll_gatherv(&args);
 
             t_stop = MPI_Wtime();
 
             if (i >= options.skip) {
                 timer+= t_stop-t_start;
+                record_latency_sample((t_stop - t_start) * 1e6);
             }
-            MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
+            adaptive_check(MPI_COMM_WORLD, i);
+            iteration_sync(MPI_COMM_WORLD);
         }
+        iteration_sync_end(MPI_COMM_WORLD);
 
         MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
 
@@ -142,6 +154,7 @@ int main(int argc, char *argv[])
                 MPI_COMM_WORLD));
         avg_time = avg_time/numprocs;
 
+        reduce_latency_samples(MPI_COMM_WORLD);
         print_stats(rank, size, avg_time, min_time, max_time);
         MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
     }
@@ -153,6 +166,7 @@ int main(int argc, char *argv[])
     }
     free_buffer(sendbuf, options.accel);
 
+    free_latency_samples();
     MPI_CHECK(MPI_Finalize());
 
     if (NONE != options.accel) {
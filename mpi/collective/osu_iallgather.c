@@ -23,6 +23,7 @@ int main(int argc, char *argv[])
     double init_total = 0.0, wait_total = 0.0;
     options.bench = COLLECTIVE;
     options.subtype = NBC;
+    options.features = FEATURE_ITERATION_SYNC;
 
     char *sendbuf = NULL;
     char *recvbuf = NULL;
@@ -97,13 +98,13 @@ int main(int argc, char *argv[])
 
     print_preamble_nbc(rank);
 
-    for (size=options.min_message_size; size <= options.max_message_size; size *= 2) {
+    for (size=first_message_size(1); size <= options.max_message_size; size = next_message_size(size, 1)) {
         if (size > LARGE_MESSAGE_SIZE) {
             options.skip = options.skip_large;
             options.iterations = options.iterations_large;
         }
 
-        MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
+        iteration_sync_begin(MPI_COMM_WORLD);
 
         timer = 0.0;
 
@@ -119,8 +120,9 @@ int main(int argc, char *argv[])
             if (i>=options.skip){
                 timer += t_stop-t_start;
             }
-            MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
+            iteration_sync(MPI_COMM_WORLD);
         }
+        iteration_sync_end(MPI_COMM_WORLD);
 
         MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
 
@@ -131,7 +133,7 @@ int main(int argc, char *argv[])
 
         init_arrays(latency_in_secs);
 
-        MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
+        iteration_sync_begin(MPI_COMM_WORLD);
 
         timer = 0.0; tcomp_total = 0; tcomp = 0;
         init_total = 0.0; wait_total = 0.0;
@@ -162,8 +164,9 @@ int main(int argc, char *argv[])
                 test_total += test_time;
                 init_total += init_time;
             }
-            MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
+            iteration_sync(MPI_COMM_WORLD);
         }
+        iteration_sync_end(MPI_COMM_WORLD);
 
         MPI_Barrier (MPI_COMM_WORLD);
 
@@ -31,6 +31,7 @@ int main(int argc, char *argv[])
     set_benchmark_name("osu_iallgatherv");
     options.bench = COLLECTIVE;
     options.subtype = NBC;
+    options.features = FEATURE_ITERATION_SYNC;
 
     po_ret = process_options(argc, argv);
 
@@ -107,7 +108,7 @@ int main(int argc, char *argv[])
 
     print_preamble_nbc(rank);
 
-    for (size=options.min_message_size; size <= options.max_message_size; size *= 2) {
+    for (size=first_message_size(1); size <= options.max_message_size; size = next_message_size(size, 1)) {
         if (size > LARGE_MESSAGE_SIZE) {
             options.skip = options.skip_large;
             options.iterations = options.iterations_large;
@@ -122,7 +123,7 @@ int main(int argc, char *argv[])
             disp += size;
         }
 
-        MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
+        iteration_sync_begin(MPI_COMM_WORLD);
         timer=0.0;
         for (i=0; i < options.iterations + options.skip ; i++) {
 
@@ -136,9 +137,10 @@ int main(int argc, char *argv[])
             if (i >= options.skip) {
                 timer+= t_stop-t_start;
             }
-            MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
+            iteration_sync(MPI_COMM_WORLD);
  
         }
+        iteration_sync_end(MPI_COMM_WORLD);
         
         MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
 
@@ -156,7 +158,7 @@ int main(int argc, char *argv[])
             disp += size;
         }
 
-	    MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
+	    iteration_sync_begin(MPI_COMM_WORLD);
 
         timer = 0.0; tcomp_total = 0; tcomp = 0;
         init_total = 0.0; wait_total = 0.0;
@@ -187,8 +189,9 @@ int main(int argc, char *argv[])
                 wait_total += wait_time;
                 init_total += init_time; 
             }
-            MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
+            iteration_sync(MPI_COMM_WORLD);
         }  
+        iteration_sync_end(MPI_COMM_WORLD);
 
         MPI_Barrier (MPI_COMM_WORLD);
         
@@ -34,6 +34,7 @@ int main(int argc, char *argv[])
 
     options.bench = COLLECTIVE;
     options.subtype = NBC;
+    options.features = FEATURE_ITERATION_SYNC;
 
     po_ret = process_options(argc, argv);
 
@@ -129,7 +130,7 @@ int main(int argc, char *argv[])
 
     print_preamble_nbc(rank);
 
-    for (size=options.min_message_size; size <=options.max_message_size; size *= 2) {
+    for (size=first_message_size(1); size <=options.max_message_size; size = next_message_size(size, 1)) {
         if (size > LARGE_MESSAGE_SIZE) {
             options.skip = options.skip_large;
             options.iterations = options.iterations_large;
@@ -148,7 +149,7 @@ int main(int argc, char *argv[])
             stypes[i] = MPI_CHAR;
             rtypes[i] = MPI_CHAR;
         }
-        MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
+        iteration_sync_begin(MPI_COMM_WORLD);
  
         timer = 0.0;     
           
@@ -164,8 +165,9 @@ int main(int argc, char *argv[])
             if (i>=options.skip) {
                 timer += t_stop-t_start;
             } 
-            MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
+            iteration_sync(MPI_COMM_WORLD);
         }  
+        iteration_sync_end(MPI_COMM_WORLD);
         
         MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
 
@@ -185,7 +187,7 @@ int main(int argc, char *argv[])
 
         }
 
-        MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
+        iteration_sync_begin(MPI_COMM_WORLD);
 
         timer = 0.0; tcomp_total = 0; tcomp = 0;        
         init_total = 0.0; wait_total = 0.0;
@@ -217,8 +219,9 @@ int main(int argc, char *argv[])
                 init_total += init_time;
                 wait_total += wait_time;
             }
-            MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
+            iteration_sync(MPI_COMM_WORLD);
         }  
+        iteration_sync_end(MPI_COMM_WORLD);
        
         MPI_Barrier (MPI_COMM_WORLD);
         
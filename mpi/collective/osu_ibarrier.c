@@ -28,6 +28,7 @@ int main(int argc, char *argv[])
 
     options.bench = COLLECTIVE;
     options.subtype = NBC;
+    options.features = FEATURE_ITERATION_SYNC;
 
     po_ret = process_options(argc, argv);
 
@@ -101,7 +102,7 @@ int main(int argc, char *argv[])
 
     init_arrays(latency_in_secs);
 
-    MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
+    iteration_sync_begin(MPI_COMM_WORLD);
 
     timer = 0.0; tcomp_total = 0; tcomp = 0;
     init_total = 0.0; wait_total = 0.0;
@@ -131,8 +132,9 @@ int main(int argc, char *argv[])
                 init_total += init_time;
                 wait_total += wait_time;
             }
-            MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
+            iteration_sync(MPI_COMM_WORLD);
     }
+    iteration_sync_end(MPI_COMM_WORLD);
 
     MPI_Barrier (MPI_COMM_WORLD);
 
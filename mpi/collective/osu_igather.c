@@ -31,6 +31,7 @@ int main(int argc, char *argv[])
 
     options.bench = COLLECTIVE;
     options.subtype = NBC;
+    options.features = FEATURE_ITERATION_SYNC;
 
     po_ret = process_options(argc, argv);
 
@@ -100,7 +101,7 @@ int main(int argc, char *argv[])
 
     print_preamble_nbc(rank);
 
-    for (size=options.min_message_size; size <= options.max_message_size; size *= 2) {
+    for (size=first_message_size(1); size <= options.max_message_size; size = next_message_size(size, 1)) {
         if (size > LARGE_MESSAGE_SIZE) {
             options.skip = options.skip_large;
             options.iterations = options.iterations_large;
@@ -108,6 +109,7 @@ int main(int argc, char *argv[])
 
         timer = 0.0;
 
+        iteration_sync_begin(MPI_COMM_WORLD);
         for (i=0; i < options.iterations + options.skip ; i++) {
             t_start = MPI_Wtime();
             MPI_CHECK(MPI_Igather(sendbuf, size, MPI_CHAR,
@@ -120,8 +122,9 @@ int main(int argc, char *argv[])
             if (i>=options.skip) {
                 timer += t_stop-t_start;
             }
-            MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
+            iteration_sync(MPI_COMM_WORLD);
         }
+        iteration_sync_end(MPI_COMM_WORLD);
 
         MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
 
@@ -138,6 +141,7 @@ int main(int argc, char *argv[])
 	    test_time = 0.0, test_total = 0.0;
 
 	    /* for loop with dummy_compute */
+        iteration_sync_begin(MPI_COMM_WORLD);
         for (i=0; i < options.iterations + options.skip ; i++) {
             t_start = MPI_Wtime();
 
@@ -164,8 +168,9 @@ int main(int argc, char *argv[])
 		        init_total += init_time;
                 wait_total += wait_time;
             }
-            MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
+            iteration_sync(MPI_COMM_WORLD);
         }
+        iteration_sync_end(MPI_COMM_WORLD);
 
         MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
 
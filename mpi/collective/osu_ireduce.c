@@ -23,6 +23,7 @@ int main(int argc, char *argv[])
     double init_total = 0.0, wait_total = 0.0;
     options.bench = COLLECTIVE;
     options.subtype = NBC;
+    options.features = FEATURE_ITERATION_SYNC;
 
     char *sendbuf = NULL;
     char *recvbuf = NULL;
@@ -30,7 +31,7 @@ int main(int argc, char *argv[])
     size_t bufsize;
 
     set_header(HEADER);
-    set_benchmark_name("osu_reduce");
+    set_benchmark_name("osu_ireduce");
     po_ret = process_options(argc, argv);
 
     if (PO_OKAY == po_ret && NONE != options.accel) {
@@ -81,11 +82,6 @@ int main(int argc, char *argv[])
         options.max_message_size = options.max_mem_limit;
     }
 
-    options.min_message_size /= sizeof(float);
-    if (options.min_message_size < MIN_MESSAGE_SIZE) {
-        options.min_message_size = MIN_MESSAGE_SIZE;
-    }
-
     bufsize = sizeof(float)*(options.max_message_size/sizeof(float));
 
     if (allocate_memory_coll((void**)&sendbuf, bufsize, options.accel)) {
@@ -102,13 +98,13 @@ int main(int argc, char *argv[])
 
     print_preamble_nbc(rank);
 
-    for (size=options.min_message_size; size*sizeof(float) <= options.max_message_size; size *= 2) {
+    for (size=first_message_size(sizeof(float)); size*sizeof(float) <= options.max_message_size; size = next_message_size(size, sizeof(float))) {
         if (size > LARGE_MESSAGE_SIZE) {
             options.skip = options.skip_large;
             options.iterations = options.iterations_large;
         }
 
-        MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
+        iteration_sync_begin(MPI_COMM_WORLD);
 
         timer = 0.0;
 
@@ -124,8 +120,9 @@ int main(int argc, char *argv[])
             if (i>=options.skip) {
                 timer += t_stop-t_start;
             }
-            MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
+            iteration_sync(MPI_COMM_WORLD);
         }
+        iteration_sync_end(MPI_COMM_WORLD);
 
         MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
 
@@ -136,7 +133,7 @@ int main(int argc, char *argv[])
 
         init_arrays(latency_in_secs);
 
-        MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
+        iteration_sync_begin(MPI_COMM_WORLD);
 
         timer = 0.0; tcomp_total = 0.0; tcomp = 0.0;
         init_total = 0.0; wait_total = 0.0;
@@ -167,8 +164,9 @@ int main(int argc, char *argv[])
                 test_total += test_time;
                 init_total += init_time;
             }
-            MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
+            iteration_sync(MPI_COMM_WORLD);
         }
+        iteration_sync_end(MPI_COMM_WORLD);
 
         MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
 
@@ -18,6 +18,7 @@ int main(int argc, char *argv[])
     double avg_time = 0.0, max_time = 0.0, min_time = 0.0;
     float *sendbuf, *recvbuf;
     int *recvcounts;
+    struct coll_args args = {0};
     int po_ret;
     size_t bufsize;
 
@@ -26,6 +27,7 @@ int main(int argc, char *argv[])
 
     options.bench = COLLECTIVE;
     options.subtype = LAT;
+    options.features = FEATURE_ITERATION_SYNC;
 
     po_ret = process_options(argc, argv);
 
@@ -75,11 +77,6 @@ int main(int argc, char *argv[])
         options.max_message_size = options.max_mem_limit;
     }
 
-    options.min_message_size /= sizeof(float);
-    if (options.min_message_size < MIN_MESSAGE_SIZE) {
-        options.min_message_size = MIN_MESSAGE_SIZE;
-    }
-
     if (allocate_memory_coll((void**)&recvcounts, numprocs*sizeof(int), NONE)) {
         fprintf(stderr, "Could Not Allocate Memory [rank %d]\n", rank);
         MPI_CHECK(MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE));
@@ -100,47 +97,45 @@ int main(int argc, char *argv[])
     }
     set_buffer(recvbuf, options.accel, 0, bufsize);
 
+    if (allocate_latency_samples()) {
+        fprintf(stderr, "Could Not Allocate Memory [rank %d]\n", rank);
+        MPI_CHECK(MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE));
+    }
+
+    args.sendbuf = sendbuf;
+    args.recvbuf = recvbuf;
+    args.counts = recvcounts;
+
     print_preamble(rank);
 
-    for (size=options.min_message_size; size*sizeof(float) <= options.max_message_size; size *= 2) {
+    for (size=first_message_size(sizeof(float)); size*sizeof(float) <= options.max_message_size; size = next_message_size(size, sizeof(float))) {
 
         if (size > LARGE_MESSAGE_SIZE) {
             options.skip = options.skip_large;
             options.iterations = options.iterations_large;
         }
 
-        int portion=0, remainder=0;
-        portion=size/numprocs;
-        remainder=size%numprocs;
+        args.count = size;
+        coll_counts_split(&args, numprocs);
 
-        for (i=0; i<numprocs; i++) {
-            recvcounts[i]=0;
-            if (size<numprocs) {
-                if (i<size)
-                    recvcounts[i]=1;
-            }
-            else{
-                if ((remainder!=0) && (i<remainder)) {
-                    recvcounts[i]+=1;
-                }
-                recvcounts[i]+=portion;
-            }
-        }
-        MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
+        adaptive_begin();
+        iteration_sync_begin(MPI_COMM_WORLD);
 
         timer=0.0;
         for (i=0; i < options.iterations + options.skip ; i++) {
             t_start = MPI_Wtime();
 
-            MPI_CHECK(MPI_Reduce_scatter(sendbuf, recvbuf, recvcounts, MPI_FLOAT,
-                                            MPI_SUM, MPI_COMM_WORLD ));
+            coll_reduce_scatter(&args);
             t_stop=MPI_Wtime();
             if (i>=options.skip) {
 
             timer+=t_stop-t_start;
+            record_latency_sample((t_stop - t_start) * 1e6);
             }
-            MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
+            adaptive_check(MPI_COMM_WORLD, i);
+            iteration_sync(MPI_COMM_WORLD);
         }
+        iteration_sync_end(MPI_COMM_WORLD);
         latency = (double)(timer * 1e6) / options.iterations;
 
         MPI_CHECK(MPI_Reduce(&latency, &min_time, 1, MPI_DOUBLE, MPI_MIN, 0,
@@ -151,6 +146,7 @@ int main(int argc, char *argv[])
                 MPI_COMM_WORLD));
         avg_time = avg_time/numprocs;
 
+        reduce_latency_samples(MPI_COMM_WORLD);
         print_stats(rank, size * sizeof(float), avg_time, min_time, max_time);
         MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
     }
@@ -159,6 +155,7 @@ int main(int argc, char *argv[])
     free_buffer(sendbuf, options.accel);
     free_buffer(recvbuf, options.accel);
 
+    free_latency_samples();
     MPI_CHECK(MPI_Finalize());
 
     if (NONE != options.accel) {
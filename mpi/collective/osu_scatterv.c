@@ -12,12 +12,13 @@
 
 int main(int argc, char *argv[])
 {
-    int i, numprocs, rank, size, disp;
+    int i, numprocs, rank, size;
     double latency = 0.0, t_start = 0.0, t_stop = 0.0;
     double timer=0.0;
     double avg_time = 0.0, max_time = 0.0, min_time = 0.0;
     char *sendbuf, *recvbuf;
     int *sdispls=NULL, *sendcounts=NULL;
+    struct coll_args args = {0};
     int po_ret;
     size_t bufsize;
 
@@ -26,6 +27,7 @@ int main(int argc, char *argv[])
 
     options.bench = COLLECTIVE;
     options.subtype = LAT;
+    options.features = FEATURE_ITERATION_SYNC;
 
     po_ret = process_options(argc, argv);
 
@@ -100,9 +102,19 @@ int main(int argc, char *argv[])
     }
     set_buffer(recvbuf, options.accel, 0, options.max_message_size);
 
+    if (allocate_latency_samples()) {
+        fprintf(stderr, "Could Not Allocate Memory [rank %d]\n", rank);
+        MPI_CHECK(MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE));
+    }
+
+    args.sendbuf = sendbuf;
+    args.recvbuf = recvbuf;
+    args.counts = sendcounts;
+    args.displs = sdispls;
+
     print_preamble(rank);
 
-    for (size=options.min_message_size; size <= options.max_message_size; size *= 2) {
+    for (size=first_message_size(1); size <= options.max_message_size; size = next_message_size(size, 1)) {
 
         if (size > LARGE_MESSAGE_SIZE) {
             options.skip = options.skip_large;
@@ -111,31 +123,31 @@ int main(int argc, char *argv[])
 
         MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
 
+        args.count = size;
         if (0 == rank) {
-            disp =0;
-            for ( i = 0; i < numprocs; i++) {
-                sendcounts[i] = size;
-                sdispls[i] = disp;
-                disp += size;
-            }
+            coll_counts_uniform(&args, numprocs);
         }
 
-        MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
+        adaptive_begin();
+
+        iteration_sync_begin(MPI_COMM_WORLD);
 
         timer=0.0;
 
         for (i=0; i < options.iterations + options.skip ; i++) {
 
             t_start = MPI_Wtime();
-            MPI_CHECK(MPI_Scatterv(sendbuf, sendcounts, sdispls, MPI_CHAR, recvbuf,
-                      size, MPI_CHAR, 0, MPI_COMM_WORLD));
+            coll_scatterv(&args);
 
             t_stop = MPI_Wtime();
             if (i >= options.skip) {
                 timer+=t_stop-t_start;
+                record_latency_sample((t_stop - t_start) * 1e6);
             }
-            MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
+            adaptive_check(MPI_COMM_WORLD, i);
+            iteration_sync(MPI_COMM_WORLD);
         }
+        iteration_sync_end(MPI_COMM_WORLD);
         latency = (double)(timer * 1e6) / options.iterations;
 
         MPI_CHECK(MPI_Reduce(&latency, &min_time, 1, MPI_DOUBLE, MPI_MIN, 0,
@@ -146,6 +158,7 @@ int main(int argc, char *argv[])
                 MPI_COMM_WORLD));
         avg_time = avg_time/numprocs;
 
+        reduce_latency_samples(MPI_COMM_WORLD);
         print_stats(rank, size, avg_time, min_time, max_time);
         MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
     }
@@ -157,6 +170,7 @@ int main(int argc, char *argv[])
     }
     free_buffer(recvbuf, options.accel);
 
+    free_latency_samples();
     MPI_CHECK(MPI_Finalize());
 
     if (NONE != options.accel) {
@@ -48,6 +48,7 @@ int main (int argc, char *argv[])
 
     MPI_CHECK(MPI_Init(&argc, &argv));
     MPI_CHECK(MPI_Comm_size(MPI_COMM_WORLD, &nprocs));
+    set_num_ranks(nprocs);
     MPI_CHECK(MPI_Comm_rank(MPI_COMM_WORLD, &rank));
 
     if (0 == rank) {
@@ -134,8 +135,8 @@ int main (int argc, char *argv[])
 void print_latency(int rank, int size)
 {
     if (rank == 0) {
-        fprintf(stdout, "%-*d%*.*f\n", 10, size, FIELD_WIDTH,
-                FLOAT_PRECISION, (t_end - t_start) * 1.0e6 / options.iterations);
+        print_result(size, "latency_us",
+                (t_end - t_start) * 1.0e6 / options.iterations);
         fflush(stdout);
     }
 }
@@ -321,8 +322,8 @@ void run_cas_with_fence(int rank, enum WINDOW type)
     MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
 
     if (rank == 0) {
-        fprintf(stdout, "%-*d%*.*f\n", 10, 8, FIELD_WIDTH,
-                FLOAT_PRECISION, (t_end - t_start) * 1.0e6 / options.iterations / 2);
+        print_result(8, "latency_us",
+                (t_end - t_start) * 1.0e6 / options.iterations / 2);
         fflush(stdout);
     }
 
@@ -386,8 +387,8 @@ void run_cas_with_pscw(int rank, enum WINDOW type)
     MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
 
     if (rank == 0) {
-        fprintf(stdout, "%-*d%*.*f\n", 10, 8, FIELD_WIDTH,
-                FLOAT_PRECISION, (t_end - t_start) * 1.0e6 / options.iterations / 2);
+        print_result(8, "latency_us",
+                (t_end - t_start) * 1.0e6 / options.iterations / 2);
         fflush(stdout);
     }
 
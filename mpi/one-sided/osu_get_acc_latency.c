@@ -40,6 +40,7 @@ int main (int argc, char *argv[])
  
     MPI_CHECK(MPI_Init(&argc, &argv));
     MPI_CHECK(MPI_Comm_size(MPI_COMM_WORLD, &nprocs));
+    set_num_ranks(nprocs);
     MPI_CHECK(MPI_Comm_rank(MPI_COMM_WORLD, &rank));
 
     if (nprocs != 2) {
@@ -134,9 +135,9 @@ void run_get_acc_with_flush(int rank, enum WINDOW type)
     MPI_Aint disp = 0;
     MPI_Win     win;
 
-    for (size = options.min_message_size; size <= options.max_message_size; size = (size ? size * 2 : size + 1)) {
-        allocate_memory_get_acc_lat(rank, rbuf, size, type, &win);
+    allocate_memory_get_acc_lat(rank, rbuf, options.max_message_size, type, &win);
 
+    for (size = first_message_size(1); size <= options.max_message_size; size = next_message_size(size, 1)) {
         if (type == WIN_DYNAMIC) {
             disp = sdisp_remote;
         }
@@ -163,9 +164,9 @@ void run_get_acc_with_flush(int rank, enum WINDOW type)
         MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
         
         print_latency_get_acc_lat(rank, size);
-        
-        MPI_Win_free(&win);
     }
+
+    MPI_Win_free(&win);
 }
 
 /*Run Get_accumulate with flush local*/
@@ -175,9 +176,9 @@ void run_get_acc_with_flush_local(int rank, enum WINDOW type)
     MPI_Aint disp = 0;
     MPI_Win     win;
 
-    for (size = options.min_message_size; size <= options.max_message_size; size = (size ? size * 2 : size + 1)) {
-        allocate_memory_get_acc_lat(rank, rbuf, size, type, &win);
+    allocate_memory_get_acc_lat(rank, rbuf, options.max_message_size, type, &win);
 
+    for (size = first_message_size(1); size <= options.max_message_size; size = next_message_size(size, 1)) {
         if (type == WIN_DYNAMIC) {
             disp = sdisp_remote;
         }
@@ -204,9 +205,9 @@ void run_get_acc_with_flush_local(int rank, enum WINDOW type)
         MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
         
         print_latency_get_acc_lat(rank, size);
-
-        MPI_Win_free(&win);
     }
+
+    MPI_Win_free(&win);
 }
 
 /*Run Get_accumulate with Lock_all/unlock_all */
@@ -216,9 +217,9 @@ void run_get_acc_with_lock_all(int rank, enum WINDOW type)
     MPI_Aint disp = 0;
     MPI_Win     win;
 
-    for (size = options.min_message_size; size <= options.max_message_size; size = (size ? size * 2 : size + 1)) {
-        allocate_memory_get_acc_lat(rank, rbuf, size, type, &win);
+    allocate_memory_get_acc_lat(rank, rbuf, options.max_message_size, type, &win);
 
+    for (size = first_message_size(1); size <= options.max_message_size; size = next_message_size(size, 1)) {
         if (type == WIN_DYNAMIC) {
             disp = sdisp_remote;
         }
@@ -244,9 +245,9 @@ void run_get_acc_with_lock_all(int rank, enum WINDOW type)
         MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
 
         print_latency_get_acc_lat(rank, size);
-        
-        MPI_Win_free(&win);
     }
+
+    MPI_Win_free(&win);
 }
 
 /*Run Get_accumulate with Lock/unlock */
@@ -256,9 +257,9 @@ void run_get_acc_with_lock(int rank, enum WINDOW type)
     MPI_Aint disp = 0;
     MPI_Win     win;
 
-    for (size = options.min_message_size; size <= options.max_message_size; size = (size ? size * 2 : size + 1)) {
-        allocate_memory_get_acc_lat(rank, rbuf, size, type, &win);
+    allocate_memory_get_acc_lat(rank, rbuf, options.max_message_size, type, &win);
 
+    for (size = first_message_size(1); size <= options.max_message_size; size = next_message_size(size, 1)) {
         if (type == WIN_DYNAMIC) {
             disp = sdisp_remote;
         }
@@ -284,9 +285,9 @@ void run_get_acc_with_lock(int rank, enum WINDOW type)
         MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
 
         print_latency_get_acc_lat(rank, size);
-        
-        MPI_Win_free(&win);
     }
+
+    MPI_Win_free(&win);
 }
 
 /*Run Get_accumulate with Fence */
@@ -296,9 +297,9 @@ void run_get_acc_with_fence(int rank, enum WINDOW type)
     MPI_Aint disp = 0;
     MPI_Win     win;
 
-    for (size = options.min_message_size; size <= options.max_message_size; size = (size ? size * 2 : size + 1)) {
-        allocate_memory_get_acc_lat(rank, rbuf, size, type, &win);
+    allocate_memory_get_acc_lat(rank, rbuf, options.max_message_size, type, &win);
 
+    for (size = first_message_size(1); size <= options.max_message_size; size = next_message_size(size, 1)) {
         if (type == WIN_DYNAMIC) {
             disp = sdisp_remote;
         }
@@ -335,13 +336,13 @@ void run_get_acc_with_fence(int rank, enum WINDOW type)
         MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
 
         if (rank == 0) {
-            fprintf(stdout, "%-*d%*.*f\n", 10, size, FIELD_WIDTH,
-                    FLOAT_PRECISION, (t_end - t_start) * 1.0e6 /  options.iterations / 2);
+            print_result(size, "latency_us",
+                    (t_end - t_start) * 1.0e6 /  options.iterations / 2);
             fflush(stdout);
         }
-
-        MPI_Win_free(&win);
     }
+
+    MPI_Win_free(&win);
 }
 
 /*Run GET with Post/Start/Complete/Wait */
@@ -354,9 +355,9 @@ void run_get_acc_with_pscw(int rank, enum WINDOW type)
     MPI_Group       comm_group, group;
     MPI_CHECK(MPI_Comm_group(MPI_COMM_WORLD, &comm_group));
 
-    for (size = options.min_message_size; size <= options.max_message_size; size = (size ? size * 2 : 1)) {
-        allocate_memory_get_acc_lat(rank, rbuf, size, type, &win);
+    allocate_memory_get_acc_lat(rank, rbuf, options.max_message_size, type, &win);
 
+    for (size = first_message_size(1); size <= options.max_message_size; size = next_message_size(size, 1)) {
         if (type == WIN_DYNAMIC) {
             disp = sdisp_remote;
         }
@@ -407,16 +408,16 @@ void run_get_acc_with_pscw(int rank, enum WINDOW type)
         MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
 
         if (rank == 0) {
-            fprintf(stdout, "%-*d%*.*f\n", 10, size, FIELD_WIDTH,
-                    FLOAT_PRECISION, (t_end - t_start) * 1.0e6 /  options.iterations / 2);
+            print_result(size, "latency_us",
+                    (t_end - t_start) * 1.0e6 /  options.iterations / 2);
             fflush(stdout);
         }
 
         MPI_CHECK(MPI_Group_free(&group));
-
-        MPI_Win_free(&win);
     }
 
+    MPI_Win_free(&win);
+
     MPI_CHECK(MPI_Group_free(&comm_group));
 }
 
@@ -463,8 +464,8 @@ void print_header_get_acc_lat (int rank, enum WINDOW win, enum SYNC sync)
 void print_latency_get_acc_lat(int rank, int size)
 {
     if (rank == 0) {
-        fprintf(stdout, "%-*d%*.*f\n", 10, size, FIELD_WIDTH,
-                FLOAT_PRECISION, (t_end - t_start) * 1.0e6 /  options.iterations);
+        print_result(size, "latency_us",
+                (t_end - t_start) * 1.0e6 /  options.iterations);
         fflush(stdout);
     }
 }
@@ -54,6 +54,7 @@ int main (int argc, char *argv[])
 
     MPI_CHECK(MPI_Init(&argc, &argv));
     MPI_CHECK(MPI_Comm_size(MPI_COMM_WORLD, &nprocs));
+    set_num_ranks(nprocs);
     MPI_CHECK(MPI_Comm_rank(MPI_COMM_WORLD, &rank));
 
     if (0 == rank) {
@@ -144,8 +145,7 @@ void print_bw(int rank, int size, double t)
     if (rank == 0) {
         double tmp = size / 1e6 * options.iterations * options.window_size;
 
-        fprintf(stdout, "%-*d%*.*f\n", 10, size, FIELD_WIDTH,
-                FLOAT_PRECISION, tmp / t);
+        print_result(size, "bandwidth_mbps", tmp / t);
         fflush(stdout);
     }
 }
@@ -160,9 +160,9 @@ void run_get_with_flush_local (int rank, enum WINDOW type)
     MPI_Win     win;
 
     int window_size = options.window_size;
-    for (size = options.min_message_size; size <= options.max_message_size; size = size * 2) {
-        allocate_memory_one_sided(rank, &rbuf, &win_base, size*window_size, type, &win);
+    allocate_memory_one_sided(rank, &rbuf, &win_base, options.max_message_size*window_size, type, &win);
 
+    for (size = first_message_size(1); size <= options.max_message_size; size = next_message_size(size, 1)) {
         if (type == WIN_DYNAMIC) {
             disp = disp_remote;
         }
@@ -191,9 +191,9 @@ void run_get_with_flush_local (int rank, enum WINDOW type)
         MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
 
         print_bw(rank, size, t);
-
-        free_memory_one_sided (rbuf, win_base, type, win, rank);
     }
+
+    free_memory_one_sided (rbuf, win_base, type, win, rank);
 }
 
 /*Run GET with flush */
@@ -205,9 +205,9 @@ void run_get_with_flush (int rank, enum WINDOW type)
     MPI_Win     win;
 
     int window_size = options.window_size;
-    for (size = options.min_message_size; size <= options.max_message_size; size = size * 2) {
-        allocate_memory_one_sided(rank, &rbuf, &win_base, size*window_size, type, &win);
+    allocate_memory_one_sided(rank, &rbuf, &win_base, options.max_message_size*window_size, type, &win);
 
+    for (size = first_message_size(1); size <= options.max_message_size; size = next_message_size(size, 1)) {
         if (type == WIN_DYNAMIC) {
             disp = disp_remote;
         }
@@ -237,9 +237,9 @@ void run_get_with_flush (int rank, enum WINDOW type)
         MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
 
         print_bw(rank, size, t);
-
-        free_memory_one_sided (rbuf, win_base, type, win, rank);
     }
+
+    free_memory_one_sided (rbuf, win_base, type, win, rank);
 }
 
 /*Run GET with Lock_all/unlock_all */
@@ -251,9 +251,9 @@ void run_get_with_lock_all (int rank, enum WINDOW type)
     MPI_Win     win;
 
     int window_size = options.window_size;
-    for (size = options.min_message_size; size <= options.max_message_size; size = size * 2) {
-        allocate_memory_one_sided(rank, &rbuf, &win_base, size*window_size, type, &win);
+    allocate_memory_one_sided(rank, &rbuf, &win_base, options.max_message_size*window_size, type, &win);
 
+    for (size = first_message_size(1); size <= options.max_message_size; size = next_message_size(size, 1)) {
         if (type == WIN_DYNAMIC) {
             disp = disp_remote;
         }
@@ -281,9 +281,9 @@ void run_get_with_lock_all (int rank, enum WINDOW type)
         MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
 
         print_bw(rank, size, t);
-
-        free_memory_one_sided (rbuf, win_base, type, win, rank);
     }
+
+    free_memory_one_sided (rbuf, win_base, type, win, rank);
 }
 #endif
 
@@ -296,9 +296,9 @@ void run_get_with_lock(int rank, enum WINDOW type)
     MPI_Win     win;
 
     int window_size = options.window_size;
-    for (size = options.min_message_size; size <= options.max_message_size; size = size * 2) {
-        allocate_memory_one_sided(rank, &rbuf, &win_base, size*window_size, type, &win);
+    allocate_memory_one_sided(rank, &rbuf, &win_base, options.max_message_size*window_size, type, &win);
 
+    for (size = first_message_size(1); size <= options.max_message_size; size = next_message_size(size, 1)) {
 #if MPI_VERSION >= 3
         if (type == WIN_DYNAMIC) {
             disp = disp_remote;
@@ -328,9 +328,9 @@ void run_get_with_lock(int rank, enum WINDOW type)
         MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
 
         print_bw(rank, size, t);
-
-        free_memory_one_sided (rbuf, win_base, type, win, rank);
     }
+
+    free_memory_one_sided (rbuf, win_base, type, win, rank);
 }
 
 /*Run GET with Fence */
@@ -342,9 +342,9 @@ void run_get_with_fence(int rank, enum WINDOW type)
     MPI_Win     win;
 
     int window_size = options.window_size;
-    for (size = options.min_message_size; size <= options.max_message_size; size = size * 2) {
-        allocate_memory_one_sided(rank, &rbuf, &win_base, size*window_size, type, &win);
+    allocate_memory_one_sided(rank, &rbuf, &win_base, options.max_message_size*window_size, type, &win);
 
+    for (size = first_message_size(1); size <= options.max_message_size; size = next_message_size(size, 1)) {
 #if MPI_VERSION >= 3
         if (type == WIN_DYNAMIC) {
             disp = disp_remote;
@@ -382,9 +382,9 @@ void run_get_with_fence(int rank, enum WINDOW type)
         MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
 
         print_bw(rank, size, t);
-
-        free_memory_one_sided (rbuf, win_base, type, win, rank);
     }
+
+    free_memory_one_sided (rbuf, win_base, type, win, rank);
 }
 
 /*Run GET with Post/Start/Complete/Wait */
@@ -398,9 +398,9 @@ void run_get_with_pscw(int rank, enum WINDOW type)
     MPI_CHECK(MPI_Comm_group(MPI_COMM_WORLD, &comm_group));
 
     int window_size = options.window_size;
-    for (size = options.min_message_size; size <= options.max_message_size; size = (size ? size * 2 : 1)) {
-        allocate_memory_one_sided(rank, &rbuf, &win_base, size*window_size, type, &win);
+    allocate_memory_one_sided(rank, &rbuf, &win_base, options.max_message_size*window_size, type, &win);
 
+    for (size = first_message_size(1); size <= options.max_message_size; size = next_message_size(size, 1)) {
 #if MPI_VERSION >= 3
         if (type == WIN_DYNAMIC) {
             disp = disp_remote;
@@ -446,9 +446,9 @@ void run_get_with_pscw(int rank, enum WINDOW type)
         print_bw(rank, size, t);
 
         MPI_CHECK(MPI_Group_free(&group));
-
-        free_memory_one_sided (rbuf, win_base, type, win, rank);
     }
+
+    free_memory_one_sided (rbuf, win_base, type, win, rank);
     MPI_CHECK(MPI_Group_free(&comm_group));
 }
 /* vi: set sw=4 sts=4 tw=80: */
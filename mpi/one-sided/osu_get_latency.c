@@ -54,6 +54,7 @@ int main (int argc, char *argv[])
 
     MPI_CHECK(MPI_Init(&argc, &argv));
     MPI_CHECK(MPI_Comm_size(MPI_COMM_WORLD, &nprocs));
+    set_num_ranks(nprocs);
     MPI_CHECK(MPI_Comm_rank(MPI_COMM_WORLD, &rank));
 
     if (0 == rank) {
@@ -144,8 +145,8 @@ int main (int argc, char *argv[])
 void print_latency(int rank, int size)
 {
     if (rank == 0) {
-        fprintf(stdout, "%-*d%*.*f\n", 10, size, FIELD_WIDTH,
-                FLOAT_PRECISION, (t_end - t_start) * 1.0e6 / options.iterations);
+        print_result(size, "latency_us",
+                (t_end - t_start) * 1.0e6 / options.iterations);
         fflush(stdout);
     }
 }
@@ -158,9 +159,9 @@ void run_get_with_flush(int rank, enum WINDOW type)
     MPI_Aint disp = 0;
     MPI_Win     win;
 
-    for (size = options.min_message_size; size <= options.max_message_size; size = (size ? size * 2 : size + 1)) {
-        allocate_memory_one_sided(rank, &rbuf, &win_base, size, type, &win);
+    allocate_memory_one_sided(rank, &rbuf, &win_base, options.max_message_size, type, &win);
 
+    for (size = first_message_size(1); size <= options.max_message_size; size = next_message_size(size, 1)) {
         if (type == WIN_DYNAMIC) {
             disp = disp_remote;
         }
@@ -185,9 +186,9 @@ void run_get_with_flush(int rank, enum WINDOW type)
         MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
         
         print_latency(rank, size);
-
-        free_memory_one_sided (rbuf, win_base, type, win, rank);
     }
+
+    free_memory_one_sided (rbuf, win_base, type, win, rank);
 }
 
 /*Run Get with flush local */
@@ -197,9 +198,9 @@ void run_get_with_flush_local(int rank, enum WINDOW type)
     MPI_Aint disp = 0;
     MPI_Win     win;
 
-    for (size = options.min_message_size; size <= options.max_message_size; size = (size ? size * 2 : size + 1)) {
-        allocate_memory_one_sided(rank, &rbuf, &win_base, size, type, &win);
+    allocate_memory_one_sided(rank, &rbuf, &win_base, options.max_message_size, type, &win);
 
+    for (size = first_message_size(1); size <= options.max_message_size; size = next_message_size(size, 1)) {
         if (type == WIN_DYNAMIC) {
             disp = disp_remote;
         }
@@ -225,9 +226,9 @@ void run_get_with_flush_local(int rank, enum WINDOW type)
         MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
         
         print_latency(rank, size);
-
-        free_memory_one_sided (rbuf, win_base, type, win, rank);
     }
+
+    free_memory_one_sided (rbuf, win_base, type, win, rank);
 }
 
 /*Run Get with Lock_all/unlock_all */
@@ -237,9 +238,9 @@ void run_get_with_lock_all(int rank, enum WINDOW type)
     MPI_Aint disp = 0;
     MPI_Win     win;
 
-    for (size = options.min_message_size; size <= options.max_message_size; size = (size ? size * 2 : size + 1)) {
-        allocate_memory_one_sided(rank, &rbuf, &win_base, size, type, &win);
+    allocate_memory_one_sided(rank, &rbuf, &win_base, options.max_message_size, type, &win);
 
+    for (size = first_message_size(1); size <= options.max_message_size; size = next_message_size(size, 1)) {
         if (type == WIN_DYNAMIC) {
             disp = disp_remote;
         }
@@ -264,9 +265,9 @@ void run_get_with_lock_all(int rank, enum WINDOW type)
         MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
 
         print_latency(rank, size);
-
-        free_memory_one_sided (rbuf, win_base, type, win, rank);
     }
+
+    free_memory_one_sided (rbuf, win_base, type, win, rank);
 }
 #endif
 
@@ -277,9 +278,9 @@ void run_get_with_lock(int rank, enum WINDOW type)
     MPI_Aint disp = 0;
     MPI_Win     win;
 
-    for (size = options.min_message_size; size <= options.max_message_size; size = (size ? size * 2 : size + 1)) {
-        allocate_memory_one_sided(rank, &rbuf, &win_base, size, type, &win);
+    allocate_memory_one_sided(rank, &rbuf, &win_base, options.max_message_size, type, &win);
 
+    for (size = first_message_size(1); size <= options.max_message_size; size = next_message_size(size, 1)) {
 #if MPI_VERSION >= 3
         if (type == WIN_DYNAMIC) {
             disp = disp_remote;
@@ -306,9 +307,9 @@ void run_get_with_lock(int rank, enum WINDOW type)
         MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
 
         print_latency(rank, size);
-
-        free_memory_one_sided (rbuf, win_base, type, win, rank);
     }
+
+    free_memory_one_sided (rbuf, win_base, type, win, rank);
 }
 
 /*Run Get with Fence */
@@ -318,9 +319,9 @@ void run_get_with_fence(int rank, enum WINDOW type)
     MPI_Aint disp = 0;
     MPI_Win     win;
 
-    for (size = options.min_message_size; size <= options.max_message_size; size = (size ? size * 2 : size + 1)) {
-        allocate_memory_one_sided(rank, &rbuf, &win_base, size, type, &win);
+    allocate_memory_one_sided(rank, &rbuf, &win_base, options.max_message_size, type, &win);
 
+    for (size = first_message_size(1); size <= options.max_message_size; size = next_message_size(size, 1)) {
 #if MPI_VERSION >= 3
         if (type == WIN_DYNAMIC) {
             disp = disp_remote;
@@ -357,13 +358,13 @@ void run_get_with_fence(int rank, enum WINDOW type)
         MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
 
          if (rank == 0) {
-            fprintf(stdout, "%-*d%*.*f\n", 10, size, FIELD_WIDTH,
-                    FLOAT_PRECISION, (t_end - t_start) * 1.0e6 / options.iterations / 2);
+            print_result(size, "latency_us",
+                    (t_end - t_start) * 1.0e6 / options.iterations / 2);
             fflush(stdout);
         }
-
-        free_memory_one_sided (rbuf, win_base, type, win, rank);
     }
+
+    free_memory_one_sided (rbuf, win_base, type, win, rank);
 }
 
 /*Run GET with Post/Start/Complete/Wait */
@@ -376,9 +377,9 @@ void run_get_with_pscw(int rank, enum WINDOW type)
     MPI_Group       comm_group, group;
     MPI_CHECK(MPI_Comm_group(MPI_COMM_WORLD, &comm_group));
 
-    for (size = options.min_message_size; size <= options.max_message_size; size = (size ? size * 2 : 1)) {
-        allocate_memory_one_sided(rank, &rbuf, &win_base, size, type, &win);
+    allocate_memory_one_sided(rank, &rbuf, &win_base, options.max_message_size, type, &win);
 
+    for (size = first_message_size(1); size <= options.max_message_size; size = next_message_size(size, 1)) {
 #if MPI_VERSION >= 3
         if (type == WIN_DYNAMIC) {
             disp = disp_remote;
@@ -431,16 +432,16 @@ void run_get_with_pscw(int rank, enum WINDOW type)
         MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
 
         if (rank == 0) {
-            fprintf(stdout, "%-*d%*.*f\n", 10, size, FIELD_WIDTH,
-                    FLOAT_PRECISION, (t_end - t_start) * 1.0e6 / options.iterations / 2);
+            print_result(size, "latency_us",
+                    (t_end - t_start) * 1.0e6 / options.iterations / 2);
             fflush(stdout);
         }
 
         MPI_CHECK(MPI_Group_free(&group));
-
-        free_memory_one_sided (rbuf, win_base, type, win, rank);
     }
 
+    free_memory_one_sided (rbuf, win_base, type, win, rank);
+
     MPI_CHECK(MPI_Group_free(&comm_group));
 }
 /* vi: set sw=4 sts=4 tw=80: */
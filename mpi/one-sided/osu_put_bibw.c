@@ -49,6 +49,7 @@ int main (int argc, char *argv[])
 
     MPI_CHECK(MPI_Init(&argc, &argv));
     MPI_CHECK(MPI_Comm_size(MPI_COMM_WORLD, &nprocs));
+    set_num_ranks(nprocs);
     MPI_CHECK(MPI_Comm_rank(MPI_COMM_WORLD, &rank));
 
     if (0 == rank) {
@@ -134,8 +135,7 @@ void print_bibw(int rank, int size, double t)
     if (rank == 0) {
         double tmp = size / 1e6 * options.iterations * options.window_size;
 
-        fprintf(stdout, "%-*d%*.*f\n", 10, size, FIELD_WIDTH,
-                FLOAT_PRECISION, (tmp / t) * 2);
+        print_result(size, "bandwidth_mbps", (tmp / t) * 2);
         fflush(stdout);
     }
 }
@@ -149,9 +149,9 @@ void run_put_with_fence(int rank, enum WINDOW type)
     MPI_Win     win;
 
     int window_size = options.window_size;
-    for (size = options.min_message_size; size <= options.max_message_size; size = size * 2) {
-        allocate_memory_one_sided(rank, &sbuf, &win_base, size*window_size, type, &win);
+    allocate_memory_one_sided(rank, &sbuf, &win_base, options.max_message_size*window_size, type, &win);
 
+    for (size = first_message_size(1); size <= options.max_message_size; size = next_message_size(size, 1)) {
 #if MPI_VERSION >= 3
         if (type == WIN_DYNAMIC) {
             disp = disp_remote;
@@ -193,9 +193,9 @@ void run_put_with_fence(int rank, enum WINDOW type)
         MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
 
         print_bibw(rank, size, t);
-
-        free_memory_one_sided (sbuf, win_base, type, win, rank);
     }
+
+    free_memory_one_sided (sbuf, win_base, type, win, rank);
 }
 
 /*Run PUT with Post/Start/Complete/Wait */
@@ -210,9 +210,9 @@ void run_put_with_pscw(int rank, enum WINDOW type)
     MPI_CHECK(MPI_Comm_group(MPI_COMM_WORLD, &comm_group));
 
     int window_size = options.window_size;
-    for (size = options.min_message_size; size <= options.max_message_size; size = size * 2) {
-        allocate_memory_one_sided(rank, &sbuf, &win_base, size*window_size, type, &win);
+    allocate_memory_one_sided(rank, &sbuf, &win_base, options.max_message_size*window_size, type, &win);
 
+    for (size = first_message_size(1); size <= options.max_message_size; size = next_message_size(size, 1)) {
 #if MPI_VERSION >= 3
         if (type == WIN_DYNAMIC) {
             disp = disp_remote;
@@ -272,9 +272,9 @@ void run_put_with_pscw(int rank, enum WINDOW type)
         print_bibw(rank, size, t);
 
         MPI_CHECK(MPI_Group_free(&group));
-
-        free_memory_one_sided (sbuf, win_base, type, win, rank);
     }
+
+    free_memory_one_sided (sbuf, win_base, type, win, rank);
     MPI_CHECK(MPI_Group_free(&comm_group));
 }
 /* vi: set sw=4 sts=4 tw=80: */
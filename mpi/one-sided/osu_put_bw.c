@@ -55,6 +55,7 @@ int main (int argc, char *argv[])
 
     MPI_CHECK(MPI_Init(&argc, &argv));
     MPI_CHECK(MPI_Comm_size(MPI_COMM_WORLD, &nprocs));
+    set_num_ranks(nprocs);
     MPI_CHECK(MPI_Comm_rank(MPI_COMM_WORLD, &rank));
 
     if (0 == rank) {
@@ -147,8 +148,7 @@ void print_bw(int rank, int size, double t)
     if (rank == 0) {
         double tmp = size / 1e6 * options.iterations * options.window_size;
 
-        fprintf(stdout, "%-*d%*.*f\n", 10, size, FIELD_WIDTH,
-                FLOAT_PRECISION, tmp / t);
+        print_result(size, "bandwidth_mbps", tmp / t);
         fflush(stdout);
     }
 }
@@ -163,9 +163,9 @@ void run_put_with_flush_local (int rank, enum WINDOW type)
     MPI_Win     win;
 
     int window_size = options.window_size;
-    for (size = options.min_message_size; size <= options.max_message_size; size = size * 2) {
-        allocate_memory_one_sided(rank, &sbuf, &win_base, size*window_size, type, &win);
+    allocate_memory_one_sided(rank, &sbuf, &win_base, options.max_message_size*window_size, type, &win);
 
+    for (size = first_message_size(1); size <= options.max_message_size; size = next_message_size(size, 1)) {
         if (type == WIN_DYNAMIC) {
             disp = disp_remote;
         }
@@ -194,9 +194,9 @@ void run_put_with_flush_local (int rank, enum WINDOW type)
         MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
 
         print_bw(rank, size, t);
-
-        free_memory_one_sided(sbuf, win_base, type, win, rank);
     }
+
+    free_memory_one_sided(sbuf, win_base, type, win, rank);
 }
 
 /*Run PUT with flush */
@@ -208,9 +208,9 @@ void run_put_with_flush (int rank, enum WINDOW type)
     MPI_Win     win;
 
     int window_size = options.window_size;
-    for (size = options.min_message_size; size <= options.max_message_size; size = size * 2) {
-        allocate_memory_one_sided(rank, &sbuf, &win_base, size*window_size, type, &win);
+    allocate_memory_one_sided(rank, &sbuf, &win_base, options.max_message_size*window_size, type, &win);
 
+    for (size = first_message_size(1); size <= options.max_message_size; size = next_message_size(size, 1)) {
         if (type == WIN_DYNAMIC) {
             disp = disp_remote;
         }
@@ -240,9 +240,9 @@ void run_put_with_flush (int rank, enum WINDOW type)
         MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
 
         print_bw(rank, size, t);
-
-        free_memory_one_sided(sbuf, win_base, type, win, rank);
     }
+
+    free_memory_one_sided(sbuf, win_base, type, win, rank);
 }
 
 /*Run PUT with Lock_all/unlock_all */
@@ -254,9 +254,9 @@ void run_put_with_lock_all (int rank, enum WINDOW type)
     MPI_Win     win;
 
     int window_size = options.window_size;
-    for (size = options.min_message_size; size <= options.max_message_size; size = size * 2) {
-        allocate_memory_one_sided(rank, &sbuf, &win_base, size*window_size, type, &win);
+    allocate_memory_one_sided(rank, &sbuf, &win_base, options.max_message_size*window_size, type, &win);
 
+    for (size = first_message_size(1); size <= options.max_message_size; size = next_message_size(size, 1)) {
         if (type == WIN_DYNAMIC) {
             disp = disp_remote;
         }
@@ -285,9 +285,9 @@ void run_put_with_lock_all (int rank, enum WINDOW type)
         MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
 
         print_bw(rank, size, t);
-
-        free_memory_one_sided(sbuf, win_base, type, win, rank);
     }
+
+    free_memory_one_sided(sbuf, win_base, type, win, rank);
 }
 #endif
 
@@ -301,9 +301,9 @@ void run_put_with_lock(int rank, enum WINDOW type)
     MPI_Win     win;
 
     int window_size = options.window_size;
-    for (size = options.min_message_size; size <= options.max_message_size; size = size * 2) {
-        allocate_memory_one_sided(rank, &sbuf, &win_base, size*window_size, type, &win);
+    allocate_memory_one_sided(rank, &sbuf, &win_base, options.max_message_size*window_size, type, &win);
 
+    for (size = first_message_size(1); size <= options.max_message_size; size = next_message_size(size, 1)) {
 #if MPI_VERSION >= 3
         if (type == WIN_DYNAMIC) {
             disp = disp_remote;
@@ -333,9 +333,9 @@ void run_put_with_lock(int rank, enum WINDOW type)
         MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
 
         print_bw(rank, size, t);
-
-        free_memory_one_sided(sbuf, win_base, type, win, rank);
     }
+
+    free_memory_one_sided(sbuf, win_base, type, win, rank);
 }
 
 /*Run PUT with Fence */
@@ -348,9 +348,9 @@ void run_put_with_fence(int rank, enum WINDOW type)
     MPI_Win     win;
 
     int window_size = options.window_size;
-    for (size = options.min_message_size; size <= options.max_message_size; size = size * 2) {
-        allocate_memory_one_sided(rank, &sbuf, &win_base, size*window_size, type, &win);
+    allocate_memory_one_sided(rank, &sbuf, &win_base, options.max_message_size*window_size, type, &win);
 
+    for (size = first_message_size(1); size <= options.max_message_size; size = next_message_size(size, 1)) {
 #if MPI_VERSION >= 3
         if (type == WIN_DYNAMIC) {
             disp = disp_remote;
@@ -388,9 +388,9 @@ void run_put_with_fence(int rank, enum WINDOW type)
         MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
 
         print_bw(rank, size, t);
-
-        free_memory_one_sided (sbuf, win_base, type, win, rank);
     }
+
+    free_memory_one_sided (sbuf, win_base, type, win, rank);
 }
 
 /*Run PUT with Post/Start/Complete/Wait */
@@ -406,9 +406,9 @@ void run_put_with_pscw(int rank, enum WINDOW type)
     MPI_CHECK(MPI_Comm_group(MPI_COMM_WORLD, &comm_group));
 
     int window_size = options.window_size;
-    for (size = options.min_message_size; size <= options.max_message_size; size = size * 2) {
-        allocate_memory_one_sided(rank, &sbuf, &win_base, size*window_size, type, &win);
+    allocate_memory_one_sided(rank, &sbuf, &win_base, options.max_message_size*window_size, type, &win);
 
+    for (size = first_message_size(1); size <= options.max_message_size; size = next_message_size(size, 1)) {
 #if MPI_VERSION >= 3
         if (type == WIN_DYNAMIC) {
             disp = disp_remote;
@@ -455,9 +455,9 @@ void run_put_with_pscw(int rank, enum WINDOW type)
         print_bw(rank, size, t);
 
         MPI_CHECK(MPI_Group_free(&group));
-
-        free_memory_one_sided (sbuf, win_base, type, win, rank);
     }
+
+    free_memory_one_sided (sbuf, win_base, type, win, rank);
     MPI_CHECK(MPI_Group_free(&comm_group));
 }
 /* vi: set sw=4 sts=4 tw=80: */
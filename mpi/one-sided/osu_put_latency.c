@@ -52,9 +52,11 @@ int main (int argc, char *argv[])
     }
  
     set_header(HEADER);
+    set_benchmark_name("osu_put_latency");
 
     MPI_CHECK(MPI_Init(&argc, &argv));
     MPI_CHECK(MPI_Comm_size(MPI_COMM_WORLD, &nprocs));
+    set_num_ranks(nprocs);
     MPI_CHECK(MPI_Comm_rank(MPI_COMM_WORLD, &rank));
 
     if (0 == rank) {
@@ -145,8 +147,8 @@ int main (int argc, char *argv[])
 void print_latency(int rank, int size)
 {
     if (rank == 0) {
-        fprintf(stdout, "%-*d%*.*f\n", 10, size, FIELD_WIDTH,
-                FLOAT_PRECISION, (t_end - t_start) * 1.0e6 / options.iterations);
+        print_result(size, "latency_us",
+                (t_end - t_start) * 1.0e6 / options.iterations);
         fflush(stdout);
     }
 }
@@ -159,9 +161,9 @@ void run_put_with_flush_local (int rank, enum WINDOW type)
     MPI_Aint disp = 0;
     MPI_Win     win;
 
-    for (size = options.min_message_size; size <= options.max_message_size; size = (size ? size * 2 : 1)) {
-        allocate_memory_one_sided(rank, &sbuf, &win_base, size, type, &win);
+    allocate_memory_one_sided(rank, &sbuf, &win_base, options.max_message_size, type, &win);
 
+    for (size = first_message_size(1); size <= options.max_message_size; size = next_message_size(size, 1)) {
         if (type == WIN_DYNAMIC) {
             disp = disp_remote;
         }
@@ -187,9 +189,9 @@ void run_put_with_flush_local (int rank, enum WINDOW type)
         MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
 
         print_latency(rank, size);
-
-        free_memory_one_sided (sbuf, win_base, type, win, rank);
     }
+
+    free_memory_one_sided (sbuf, win_base, type, win, rank);
 }
 
 /*Run PUT with flush */
@@ -199,9 +201,9 @@ void run_put_with_flush (int rank, enum WINDOW type)
     MPI_Aint disp = 0;
     MPI_Win     win;
 
-    for (size = options.min_message_size; size <= options.max_message_size; size = (size ? size * 2 : 1)) {
-        allocate_memory_one_sided(rank, &sbuf, &win_base, size, type, &win);
+    allocate_memory_one_sided(rank, &sbuf, &win_base, options.max_message_size, type, &win);
 
+    for (size = first_message_size(1); size <= options.max_message_size; size = next_message_size(size, 1)) {
         if (type == WIN_DYNAMIC) {
             disp = disp_remote;
         }
@@ -227,9 +229,9 @@ void run_put_with_flush (int rank, enum WINDOW type)
         MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
 
         print_latency(rank, size);
-
-        free_memory_one_sided (sbuf, win_base, type, win, rank);
     }
+
+    free_memory_one_sided (sbuf, win_base, type, win, rank);
 }
 
 /*Run PUT with Lock_all/unlock_all */
@@ -239,9 +241,9 @@ void run_put_with_lock_all (int rank, enum WINDOW type)
     MPI_Aint disp = 0;
     MPI_Win     win;
 
-    for (size = options.min_message_size; size <= options.max_message_size; size = (size ? size * 2 : 1)) {
-        allocate_memory_one_sided(rank, &sbuf, &win_base, size, type, &win);
+    allocate_memory_one_sided(rank, &sbuf, &win_base, options.max_message_size, type, &win);
 
+    for (size = first_message_size(1); size <= options.max_message_size; size = next_message_size(size, 1)) {
         if (type == WIN_DYNAMIC) {
             disp = disp_remote;
         }
@@ -266,9 +268,9 @@ void run_put_with_lock_all (int rank, enum WINDOW type)
         MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
 
         print_latency(rank, size);
-
-        free_memory_one_sided (sbuf, win_base, type, win, rank);
     }
+
+    free_memory_one_sided (sbuf, win_base, type, win, rank);
 }
 #endif 
 
@@ -279,9 +281,9 @@ void run_put_with_lock(int rank, enum WINDOW type)
     MPI_Aint disp = 0;
     MPI_Win     win;
 
-    for (size = options.min_message_size; size <= options.max_message_size; size = (size ? size * 2 : 1)) {
-        allocate_memory_one_sided(rank, &sbuf, &win_base, size, type, &win);
+    allocate_memory_one_sided(rank, &sbuf, &win_base, options.max_message_size, type, &win);
 
+    for (size = first_message_size(1); size <= options.max_message_size; size = next_message_size(size, 1)) {
 #if MPI_VERSION >= 3
         if (type == WIN_DYNAMIC) {
             disp = disp_remote;
@@ -308,9 +310,9 @@ void run_put_with_lock(int rank, enum WINDOW type)
         MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
 
         print_latency(rank, size);
-
-        free_memory_one_sided (sbuf, win_base, type, win, rank);
     }
+
+    free_memory_one_sided (sbuf, win_base, type, win, rank);
 }
 
 /*Run PUT with Fence */
@@ -320,9 +322,9 @@ void run_put_with_fence(int rank, enum WINDOW type)
     MPI_Aint disp = 0;
     MPI_Win     win;
 
-    for (size = options.min_message_size; size <= options.max_message_size; size = (size ? size * 2 : 1)) {
-        allocate_memory_one_sided(rank, &sbuf, &win_base, size, type, &win);
+    allocate_memory_one_sided(rank, &sbuf, &win_base, options.max_message_size, type, &win);
 
+    for (size = first_message_size(1); size <= options.max_message_size; size = next_message_size(size, 1)) {
 #if MPI_VERSION >= 3
         if (type == WIN_DYNAMIC) {
             disp = disp_remote;
@@ -359,13 +361,13 @@ void run_put_with_fence(int rank, enum WINDOW type)
         MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
 
         if (rank == 0) {
-            fprintf(stdout, "%-*d%*.*f\n", 10, size, FIELD_WIDTH,
-                    FLOAT_PRECISION, (t_end - t_start) * 1.0e6 / options.iterations / 2);
+            print_result(size, "latency_us",
+                    (t_end - t_start) * 1.0e6 / options.iterations / 2);
             fflush(stdout);
         }
-
-        free_memory_one_sided (sbuf, win_base, type, win, rank);
     }
+
+    free_memory_one_sided (sbuf, win_base, type, win, rank);
 }
 
 /*Run PUT with Post/Start/Complete/Wait */
@@ -378,9 +380,9 @@ void run_put_with_pscw(int rank, enum WINDOW type)
 
     MPI_CHECK(MPI_Comm_group(MPI_COMM_WORLD, &comm_group));
 
-    for (size = options.min_message_size; size <= options.max_message_size; size = (size ? size * 2 : 1)) {
-        allocate_memory_one_sided(rank, &sbuf, &win_base, size, type, &win);
+    allocate_memory_one_sided(rank, &sbuf, &win_base, options.max_message_size, type, &win);
 
+    for (size = first_message_size(1); size <= options.max_message_size; size = next_message_size(size, 1)) {
 #if MPI_VERSION >= 3
         if (type == WIN_DYNAMIC) {
             disp = disp_remote;
@@ -429,15 +431,15 @@ void run_put_with_pscw(int rank, enum WINDOW type)
         MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
 
         if (rank == 0) {
-            fprintf(stdout, "%-*d%*.*f\n", 10, size, FIELD_WIDTH,
-                    FLOAT_PRECISION, (t_end - t_start) * 1.0e6 / options.iterations / 2);
+            print_result(size, "latency_us",
+                    (t_end - t_start) * 1.0e6 / options.iterations / 2);
             fflush(stdout);
         }
 
         MPI_CHECK(MPI_Group_free(&group));
-
-        free_memory_one_sided (sbuf, win_base, type, win, rank);
     }
+
+    free_memory_one_sided (sbuf, win_base, type, win, rank);
     MPI_CHECK(MPI_Group_free(&comm_group));
 }
 /* vi: set sw=4 sts=4 tw=80: */
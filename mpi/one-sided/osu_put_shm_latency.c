@@ -0,0 +1,219 @@
+#define BENCHMARK "OSU MPI%s Shared-Memory Window Put Latency Test"
+/*
+ * Copyright (C) 2003-2021 the Network-Based Computing Laboratory
+ * (NBCL), The Ohio State University.
+ *
+ * Contact: Dr. D. K. Panda (panda@cse.ohio-state.edu)
+ *
+ * For detailed copyright and licensing information, please refer to the
+ * copyright file COPYRIGHT in the top level OMB directory.
+ */
+
+#include <osu_util_mpi.h>
+
+/*
+ * Rank 0 writes SIZE bytes into the segment of rank 1 of a window from
+ * MPI_Win_allocate_shared, three ways: MPI_Put with MPI_Win_flush, memcpy
+ * with MPI_Win_sync, and relaxed atomic stores with MPI_Win_sync. Both ranks
+ * must be on the same node. The difference is the cost of the RMA call path
+ * over plain stores to shared memory.
+ */
+enum shm_method {
+    SHM_PUT,
+    SHM_MEMCPY,
+    SHM_ATOMIC
+};
+
+char *sbuf = NULL, *peer_base = NULL;
+
+static void atomic_copy (char * dst, char const * src, int size)
+{
+    uint64_t *dst64 = (uint64_t *)dst;
+    uint64_t const *src64 = (uint64_t const *)src;
+    int i, words = size / sizeof(uint64_t);
+
+    for (i = 0; i < words; i++) {
+        __atomic_store_n(dst64 + i, src64[i], __ATOMIC_RELAXED);
+    }
+    for (i = words * sizeof(uint64_t); i < size; i++) {
+        __atomic_store_n(dst + i, src[i], __ATOMIC_RELAXED);
+    }
+}
+
+static double shm_latency (int rank, int size, enum shm_method method,
+        MPI_Win win)
+{
+    double t_start = 0.0, t_end = 0.0;
+    int i;
+
+    MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
+
+    if (0 == rank) {
+        for (i = 0; i < options.skip + options.iterations; i++) {
+            if (i == options.skip) {
+                t_start = MPI_Wtime();
+            }
+
+            switch (method) {
+                case SHM_PUT:
+                    MPI_CHECK(MPI_Put(sbuf, size, MPI_CHAR, 1, 0, size,
+                            MPI_CHAR, win));
+                    MPI_CHECK(MPI_Win_flush(1, win));
+                    break;
+                case SHM_MEMCPY:
+                    memcpy(peer_base, sbuf, size);
+                    MPI_CHECK(MPI_Win_sync(win));
+                    break;
+                case SHM_ATOMIC:
+                    atomic_copy(peer_base, sbuf, size);
+                    MPI_CHECK(MPI_Win_sync(win));
+                    break;
+            }
+        }
+        t_end = MPI_Wtime();
+    }
+
+    MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
+
+    return (t_end - t_start) * 1.0e6 / options.iterations;
+}
+
+int main (int argc, char *argv[])
+{
+    int rank, nprocs, size, disp_unit, node_size;
+    int po_ret = PO_OKAY;
+    double t_put, t_memcpy, t_atomic;
+    char *win_base = NULL;
+    MPI_Aint seg_size;
+    MPI_Comm node_comm;
+    MPI_Win win;
+
+    options.bench = ONE_SIDED;
+    options.subtype = LAT_SHM;
+    options.synctype = ALL_SYNC;
+
+    set_header(HEADER);
+    set_benchmark_name("osu_put_shm_latency");
+
+    po_ret = process_options(argc, argv);
+
+    MPI_CHECK(MPI_Init(&argc, &argv));
+    MPI_CHECK(MPI_Comm_size(MPI_COMM_WORLD, &nprocs));
+    set_num_ranks(nprocs);
+    MPI_CHECK(MPI_Comm_rank(MPI_COMM_WORLD, &rank));
+
+    if (0 == rank) {
+        switch (po_ret) {
+            case PO_BAD_USAGE:
+                print_bad_usage_message(rank);
+            case PO_HELP_MESSAGE:
+                usage_one_sided("osu_put_shm_latency");
+                break;
+            case PO_VERSION_MESSAGE:
+                print_version_message(rank);
+                MPI_CHECK(MPI_Finalize());
+                exit(EXIT_SUCCESS);
+            default:
+                break;
+        }
+    }
+
+    switch (po_ret) {
+        case PO_CUDA_NOT_AVAIL:
+        case PO_OPENACC_NOT_AVAIL:
+        case PO_BAD_USAGE:
+            MPI_CHECK(MPI_Finalize());
+            exit(EXIT_FAILURE);
+        case PO_HELP_MESSAGE:
+        case PO_VERSION_MESSAGE:
+            MPI_CHECK(MPI_Finalize());
+            exit(EXIT_SUCCESS);
+        case PO_OKAY:
+            break;
+    }
+
+    if (nprocs != 2) {
+        if (rank == 0) {
+            fprintf(stderr, "This test requires exactly two processes\n");
+        }
+
+        MPI_CHECK(MPI_Finalize());
+
+        return EXIT_FAILURE;
+    }
+
+    MPI_CHECK(MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, 0,
+            MPI_INFO_NULL, &node_comm));
+    MPI_CHECK(MPI_Comm_size(node_comm, &node_size));
+
+    if (node_size != 2) {
+        if (rank == 0) {
+            fprintf(stderr, "This test requires both processes on one node\n");
+        }
+
+        MPI_CHECK(MPI_Comm_free(&node_comm));
+        MPI_CHECK(MPI_Finalize());
+
+        return EXIT_FAILURE;
+    }
+
+    CHECK(allocate_host_buffer((void **)&sbuf, options.max_message_size));
+    memset(sbuf, 'a', options.max_message_size);
+
+    /*
+     * node_comm keeps the world order, so rank 1 is the same process in both.
+     * Only rank 1 contributes memory, which keeps its segment at the aligned
+     * start of the shared allocation.
+     */
+    MPI_CHECK(MPI_Win_allocate_shared(rank ? options.max_message_size : 0, 1,
+            MPI_INFO_NULL, node_comm, &win_base, &win));
+    MPI_CHECK(MPI_Win_shared_query(win, 1, &seg_size, &disp_unit, &peer_base));
+    MPI_CHECK(MPI_Win_lock_all(0, win));
+
+    if (0 == rank) {
+        printf(benchmark_header, "");
+        fprintf(stdout, "# Window creation: MPI_Win_allocate_shared\n");
+        print_host_memory_policy();
+        fprintf(stdout, "# Synchronization: MPI_Win_flush (Put), "
+                "MPI_Win_sync (memcpy, atomic)\n");
+        fprintf(stdout, "%-*s%*s%*s%*s\n", 10, "# Size", FIELD_WIDTH,
+                "MPI_Put (us)", FIELD_WIDTH, "memcpy (us)", FIELD_WIDTH,
+                "Atomic (us)");
+        fflush(stdout);
+    }
+
+    for (size = first_message_size(1); size <= options.max_message_size;
+            size = next_message_size(size, 1)) {
+        if (size > LARGE_MESSAGE_SIZE) {
+            options.iterations = options.iterations_large;
+            options.skip = options.skip_large;
+        }
+
+        t_put = shm_latency(rank, size, SHM_PUT, win);
+        t_memcpy = shm_latency(rank, size, SHM_MEMCPY, win);
+        t_atomic = shm_latency(rank, size, SHM_ATOMIC, win);
+
+        if (0 == rank) {
+            fprintf(stdout, "%-*d%*.*f%*.*f%*.*f\n", 10, size, FIELD_WIDTH,
+                    FLOAT_PRECISION, t_put, FIELD_WIDTH, FLOAT_PRECISION,
+                    t_memcpy, FIELD_WIDTH, FLOAT_PRECISION, t_atomic);
+            omb_result_begin(size, options.iterations);
+            omb_result_metric("latency_us", t_put);
+            omb_result_field("memcpy_latency_us", t_memcpy);
+            omb_result_field("atomic_latency_us", t_atomic);
+            omb_result_end();
+            fflush(stdout);
+        }
+    }
+
+    MPI_CHECK(MPI_Win_unlock_all(win));
+    MPI_CHECK(MPI_Win_free(&win));
+    MPI_CHECK(MPI_Comm_free(&node_comm));
+    free_host_buffer(sbuf);
+
+    MPI_CHECK(MPI_Finalize());
+
+    return EXIT_SUCCESS;
+}
+
+/* vi: set sw=4 sts=4 tw=80: */
@@ -0,0 +1,369 @@
+#define BENCHMARK "OSU MPI%s RMA Random Access (GUPS) Test"
+/*
+ * Copyright (C) 2003-2021 the Network-Based Computing Laboratory
+ * (NBCL), The Ohio State University.
+ *
+ * Contact: Dr. D. K. Panda (panda@cse.ohio-state.edu)
+ *
+ * For detailed copyright and licensing information, please refer to the
+ * copyright file COPYRIGHT in the top level OMB directory.
+ */
+
+#include <osu_util_mpi.h>
+
+/*
+ * Every process owns options.table_size bytes of a table of 64-bit words
+ * spread over all processes, and XORs random values into random words of
+ * the whole table with MPI_Fetch_and_op or MPI_Accumulate. The -s mode
+ * completes the updates after every batch. Batches of 1, 2, 4, ...
+ * options.batch updates are timed and reported in giga-updates per second
+ * over all processes.
+ */
+#define GUPS_SEED 0x9e3779b97f4a7c15ULL
+
+uint64_t *table = NULL, *result = NULL, *values = NULL;
+uint64_t words, total_words;
+int *targets = NULL, *locked = NULL;
+MPI_Aint *disps = NULL, *bases = NULL;
+MPI_Group world_group;
+
+/* xorshift64, so a rank can replay its exact update stream */
+static uint64_t next_random (uint64_t *state)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+
+    return *state;
+}
+
+static void begin_run (MPI_Win win)
+{
+    switch (options.sync) {
+        case FENCE:
+            MPI_CHECK(MPI_Win_fence(MPI_MODE_NOPRECEDE, win));
+            break;
+        case FLUSH:
+        case FLUSH_LOCAL:
+            MPI_CHECK(MPI_Win_lock_all(0, win));
+            break;
+        default:
+            break;
+    }
+}
+
+static void end_run (MPI_Win win)
+{
+    switch (options.sync) {
+        case FENCE:
+            MPI_CHECK(MPI_Win_fence(MPI_MODE_NOSUCCEED, win));
+            break;
+        case FLUSH:
+        case FLUSH_LOCAL:
+            MPI_CHECK(MPI_Win_unlock_all(win));
+            break;
+        default:
+            break;
+    }
+}
+
+static void run_batch (int batch, uint64_t *state, MPI_Win win)
+{
+    uint64_t r, idx;
+    int j;
+
+    for (j = 0; j < batch; j++) {
+        r = next_random(state);
+        idx = r % total_words;
+        values[j] = r;
+        targets[j] = idx / words;
+        disps[j] = bases[targets[j]] + (idx % words) * sizeof(uint64_t);
+    }
+
+    switch (options.sync) {
+        case LOCK:
+            for (j = 0; j < batch; j++) {
+                if (!locked[targets[j]]) {
+                    MPI_CHECK(MPI_Win_lock(MPI_LOCK_SHARED, targets[j], 0,
+                            win));
+                    locked[targets[j]] = 1;
+                }
+            }
+            break;
+        case PSCW:
+            MPI_CHECK(MPI_Win_post(world_group, 0, win));
+            MPI_CHECK(MPI_Win_start(world_group, 0, win));
+            break;
+        case LOCK_ALL:
+            MPI_CHECK(MPI_Win_lock_all(0, win));
+            break;
+        default:
+            break;
+    }
+
+    for (j = 0; j < batch; j++) {
+        if (RMA_OP_FOP == options.rma_op) {
+            MPI_CHECK(MPI_Fetch_and_op(&values[j], &result[j], MPI_UINT64_T,
+                    targets[j], disps[j], MPI_BXOR, win));
+        } else {
+            MPI_CHECK(MPI_Accumulate(&values[j], 1, MPI_UINT64_T, targets[j],
+                    disps[j], 1, MPI_UINT64_T, MPI_BXOR, win));
+        }
+    }
+
+    switch (options.sync) {
+        case LOCK:
+            for (j = 0; j < batch; j++) {
+                if (locked[targets[j]]) {
+                    MPI_CHECK(MPI_Win_unlock(targets[j], win));
+                    locked[targets[j]] = 0;
+                }
+            }
+            break;
+        case PSCW:
+            MPI_CHECK(MPI_Win_complete(win));
+            MPI_CHECK(MPI_Win_wait(win));
+            break;
+        case FENCE:
+            MPI_CHECK(MPI_Win_fence(0, win));
+            break;
+        case FLUSH:
+            MPI_CHECK(MPI_Win_flush_all(win));
+            break;
+        case FLUSH_LOCAL:
+            MPI_CHECK(MPI_Win_flush_local_all(win));
+            break;
+        case LOCK_ALL:
+            MPI_CHECK(MPI_Win_unlock_all(win));
+            break;
+    }
+}
+
+/* Word i of rank r starts as its global index r * words + i */
+static void reset_table (int rank, MPI_Win win)
+{
+    uint64_t i;
+
+    MPI_CHECK(MPI_Win_lock(MPI_LOCK_EXCLUSIVE, rank, 0, win));
+    for (i = 0; i < words; i++) {
+        table[i] = rank * words + i;
+    }
+    MPI_CHECK(MPI_Win_unlock(rank, win));
+
+    MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
+}
+
+static int check_table (int rank, MPI_Win win)
+{
+    int errors = 0, total = 0;
+    uint64_t i;
+
+    MPI_CHECK(MPI_Win_lock(MPI_LOCK_EXCLUSIVE, rank, 0, win));
+    for (i = 0; i < words; i++) {
+        errors += table[i] != rank * words + i;
+    }
+    MPI_CHECK(MPI_Win_unlock(rank, win));
+
+    MPI_CHECK(MPI_Reduce(&errors, &total, 1, MPI_INT, MPI_SUM, 0,
+            MPI_COMM_WORLD));
+
+    return total;
+}
+
+static void run_gups (int rank, int nprocs, int batch, MPI_Win win)
+{
+    int nskip = (options.skip + batch - 1) / batch;
+    int niter = (options.iterations + batch - 1) / batch;
+    int i, errors = 0;
+    uint64_t state;
+    double t_start = 0.0, t = 0.0, t_max = 0.0, gups, update_time;
+
+    if (options.validate) {
+        reset_table(rank, win);
+    }
+
+    state = (rank + 1) * GUPS_SEED;
+    MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
+    begin_run(win);
+
+    for (i = 0; i < nskip + niter; i++) {
+        if (i == nskip) {
+            t_start = MPI_Wtime();
+        }
+        run_batch(batch, &state, win);
+    }
+
+    t = MPI_Wtime() - t_start;
+    end_run(win);
+
+    MPI_CHECK(MPI_Reduce(&t, &t_max, 1, MPI_DOUBLE, MPI_MAX, 0,
+            MPI_COMM_WORLD));
+
+    /* XOR is its own inverse: replaying every update restores the table */
+    if (options.validate) {
+        state = (rank + 1) * GUPS_SEED;
+        MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
+        begin_run(win);
+        for (i = 0; i < nskip + niter; i++) {
+            run_batch(batch, &state, win);
+        }
+        end_run(win);
+        MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
+        errors = check_table(rank, win);
+    }
+
+    if (0 == rank) {
+        gups = (double)nprocs * niter * batch / t_max / 1e9;
+        update_time = t_max * 1e6 / ((double)niter * batch);
+
+        fprintf(stdout, "%-*d%*.*f%*.*f", 10, batch, FIELD_WIDTH,
+                FLOAT_PRECISION + 4, gups, FIELD_WIDTH, FLOAT_PRECISION,
+                update_time);
+        if (options.validate) {
+            fprintf(stdout, "%*d", FIELD_WIDTH, errors);
+        }
+        fprintf(stdout, "\n");
+        omb_result_begin(batch, niter * batch);
+        omb_result_field("gups", gups);
+        omb_result_field("update_time_us", update_time);
+        if (options.validate) {
+            omb_result_field("errors", errors);
+        }
+        omb_result_end();
+        fflush(stdout);
+    }
+}
+
+int main (int argc, char *argv[])
+{
+    int rank, nprocs, batch;
+    int po_ret = PO_OKAY;
+    char *sbuf = NULL, *win_base = NULL;
+    MPI_Win win;
+
+    options.win = WIN_ALLOCATE;
+    options.sync = FLUSH;
+    options.bench = ONE_SIDED;
+    options.subtype = GUPS;
+    options.synctype = ALL_SYNC;
+
+    set_header(HEADER);
+    set_benchmark_name("osu_rma_gups");
+
+    po_ret = process_options(argc, argv);
+
+    MPI_CHECK(MPI_Init(&argc, &argv));
+    MPI_CHECK(MPI_Comm_size(MPI_COMM_WORLD, &nprocs));
+    set_num_ranks(nprocs);
+    MPI_CHECK(MPI_Comm_rank(MPI_COMM_WORLD, &rank));
+
+    if (0 == rank) {
+        switch (po_ret) {
+            case PO_BAD_USAGE:
+                print_bad_usage_message(rank);
+            case PO_HELP_MESSAGE:
+                usage_one_sided("osu_rma_gups");
+                break;
+            case PO_VERSION_MESSAGE:
+                print_version_message(rank);
+                MPI_CHECK(MPI_Finalize());
+                exit(EXIT_SUCCESS);
+            default:
+                break;
+        }
+    }
+
+    switch (po_ret) {
+        case PO_CUDA_NOT_AVAIL:
+        case PO_OPENACC_NOT_AVAIL:
+        case PO_BAD_USAGE:
+            MPI_CHECK(MPI_Finalize());
+            exit(EXIT_FAILURE);
+        case PO_HELP_MESSAGE:
+        case PO_VERSION_MESSAGE:
+            MPI_CHECK(MPI_Finalize());
+            exit(EXIT_SUCCESS);
+        case PO_OKAY:
+            break;
+    }
+
+    if (nprocs < 2) {
+        if (rank == 0) {
+            fprintf(stderr, "This test requires at least two processes\n");
+        }
+
+        MPI_CHECK(MPI_Finalize());
+
+        return EXIT_FAILURE;
+    }
+
+    words = options.table_size / sizeof(uint64_t);
+    total_words = words * nprocs;
+
+    if ((uint64_t)options.batch > words) {
+        if (rank == 0) {
+            fprintf(stderr, "--batch may not exceed the %" PRIu64 " words "
+                    "of the table on each process\n", words);
+        }
+
+        MPI_CHECK(MPI_Finalize());
+
+        return EXIT_FAILURE;
+    }
+
+    /* sbuf holds the fetched values of a batch */
+    allocate_memory_one_sided(rank, &sbuf, &win_base,
+            words * sizeof(uint64_t), options.win, &win);
+    table = (uint64_t *)win_base;
+    result = (uint64_t *)sbuf;
+
+    values = malloc(options.batch * sizeof(uint64_t));
+    targets = malloc(options.batch * sizeof(int));
+    disps = malloc(options.batch * sizeof(MPI_Aint));
+    bases = calloc(nprocs, sizeof(MPI_Aint));
+    locked = calloc(nprocs, sizeof(int));
+    CHECK(NULL == values || NULL == targets || NULL == disps ||
+            NULL == bases || NULL == locked);
+
+    if (WIN_DYNAMIC == options.win) {
+        MPI_CHECK(MPI_Allgather(&disp_local, 1, MPI_AINT, bases, 1, MPI_AINT,
+                MPI_COMM_WORLD));
+    }
+    MPI_CHECK(MPI_Comm_group(MPI_COMM_WORLD, &world_group));
+
+    if (0 == rank) {
+        printf(benchmark_header, "");
+        fprintf(stdout, "# Window creation: %s\n", win_info[options.win]);
+        fprintf(stdout, "# Synchronization: %s\n", sync_info[options.sync]);
+        print_host_memory_policy();
+        fprintf(stdout, "# Operation: %s\n", RMA_OP_FOP == options.rma_op ?
+                "MPI_Fetch_and_op" : "MPI_Accumulate");
+        fprintf(stdout, "# Table: %" PRIu64 " words per process\n", words);
+        fprintf(stdout, "%-*s%*s%*s", 10, "# Batch", FIELD_WIDTH, "GUPS",
+                FIELD_WIDTH, "Update Time(us)");
+        if (options.validate) {
+            fprintf(stdout, "%*s", FIELD_WIDTH, "Errors");
+        }
+        fprintf(stdout, "\n");
+        fflush(stdout);
+    }
+
+    for (batch = 1; batch < options.batch; batch *= 2) {
+        run_gups(rank, nprocs, batch, win);
+    }
+    run_gups(rank, nprocs, options.batch, win);
+
+    MPI_CHECK(MPI_Group_free(&world_group));
+    free(values);
+    free(targets);
+    free(disps);
+    free(bases);
+    free(locked);
+    free_memory_one_sided(sbuf, win_base, options.win, win, rank);
+
+    MPI_CHECK(MPI_Finalize());
+
+    return EXIT_SUCCESS;
+}
+
+/* vi: set sw=4 sts=4 tw=80: */
@@ -0,0 +1,217 @@
+#define BENCHMARK "OSU MPI%s RMA Hotspot Contention Test"
+/*
+ * Copyright (C) 2003-2021 the Network-Based Computing Laboratory
+ * (NBCL), The Ohio State University.
+ *
+ * Contact: Dr. D. K. Panda (panda@cse.ohio-state.edu)
+ *
+ * For detailed copyright and licensing information, please refer to the
+ * copyright file COPYRIGHT in the top level OMB directory.
+ */
+
+#include <osu_util_mpi.h>
+
+/*
+ * Ranks 0 .. K-1 each expose one 64-bit counter and stay passive. The other
+ * ranks are origins; origin i updates the counter of rank i % K with
+ * MPI_Fetch_and_op, MPI_Compare_and_swap or MPI_Accumulate, flushing after
+ * every operation. The number of active origins doubles each round so the
+ * aggregate rate and the per-origin latency can be read against contention.
+ */
+static char const * rma_op_name[] = {
+    "MPI_Fetch_and_op",
+    "MPI_Compare_and_swap",
+    "MPI_Accumulate"
+};
+
+static double run_origin (int target, MPI_Win win)
+{
+    uint64_t one = 1, result = 0, expected = 0, swap;
+    double t_start = 0.0, t_op;
+    int i;
+
+    for (i = 0; i < options.skip + options.iterations; i++) {
+        t_op = MPI_Wtime();
+
+        switch (options.rma_op) {
+            case RMA_OP_FOP:
+                MPI_CHECK(MPI_Fetch_and_op(&one, &result, MPI_UINT64_T, target,
+                        0, MPI_SUM, win));
+                break;
+            case RMA_OP_CAS:
+                swap = expected + 1;
+                MPI_CHECK(MPI_Compare_and_swap(&swap, &expected, &result,
+                        MPI_UINT64_T, target, 0, win));
+                break;
+            case RMA_OP_ACC:
+                MPI_CHECK(MPI_Accumulate(&one, 1, MPI_UINT64_T, target, 0, 1,
+                        MPI_UINT64_T, MPI_SUM, win));
+                break;
+        }
+        MPI_CHECK(MPI_Win_flush(target, win));
+
+        if (RMA_OP_CAS == options.rma_op) {
+            /* on a lost race the returned value is the one to retry against */
+            expected = result == expected ? swap : result;
+        }
+
+        if (i == options.skip) {
+            t_start = t_op;
+        }
+        if (i >= options.skip) {
+            record_latency_sample((MPI_Wtime() - t_op) * 1e6);
+        }
+    }
+
+    return MPI_Wtime() - t_start;
+}
+
+static void run_hotspot (int rank, int norigins, MPI_Win win)
+{
+    int targets = options.rma_targets;
+    int active = rank >= targets && rank - targets < norigins;
+    double t_total = 0.0, t_max = 0.0, lat, lat_sum = 0.0;
+    double lat_min = 0.0, lat_max = 0.0, rate;
+
+    MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
+
+    if (active) {
+        t_total = run_origin((rank - targets) % targets, win);
+    }
+
+    MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
+
+    lat = active ? t_total * 1e6 / options.iterations : 0.0;
+    MPI_CHECK(MPI_Reduce(&t_total, &t_max, 1, MPI_DOUBLE, MPI_MAX, 0,
+            MPI_COMM_WORLD));
+    MPI_CHECK(MPI_Reduce(&lat, &lat_sum, 1, MPI_DOUBLE, MPI_SUM, 0,
+            MPI_COMM_WORLD));
+    MPI_CHECK(MPI_Reduce(&lat, &lat_max, 1, MPI_DOUBLE, MPI_MAX, 0,
+            MPI_COMM_WORLD));
+    lat = active ? lat : DBL_MAX;
+    MPI_CHECK(MPI_Reduce(&lat, &lat_min, 1, MPI_DOUBLE, MPI_MIN, 0,
+            MPI_COMM_WORLD));
+    reduce_latency_samples(MPI_COMM_WORLD);
+
+    if (0 == rank) {
+        rate = (double)norigins * options.iterations / t_max / 1e6;
+
+        fprintf(stdout, "%-*d%*.*f%*.*f%*.*f%*.*f", 10, norigins, FIELD_WIDTH,
+                FLOAT_PRECISION, rate, FIELD_WIDTH, FLOAT_PRECISION,
+                lat_sum / norigins, FIELD_WIDTH, FLOAT_PRECISION, lat_min,
+                FIELD_WIDTH, FLOAT_PRECISION, lat_max);
+        omb_result_begin(norigins, options.iterations);
+        omb_result_field("origins", norigins);
+        omb_result_field("mops_per_sec", rate);
+        omb_result_field("latency_us", lat_sum / norigins);
+        omb_result_field("min_latency_us", lat_min);
+        omb_result_field("max_latency_us", lat_max);
+        print_latency_dist(rank);
+        omb_result_end();
+        fflush(stdout);
+    }
+}
+
+int main (int argc, char *argv[])
+{
+    int rank, nprocs, norigins, max_origins;
+    int po_ret = PO_OKAY;
+    uint64_t *counter = NULL;
+    MPI_Win win;
+
+    options.bench = ONE_SIDED;
+    options.subtype = LAT_HOTSPOT;
+    options.synctype = ALL_SYNC;
+
+    set_header(HEADER);
+    set_benchmark_name("osu_rma_hotspot");
+
+    po_ret = process_options(argc, argv);
+
+    MPI_CHECK(MPI_Init(&argc, &argv));
+    MPI_CHECK(MPI_Comm_size(MPI_COMM_WORLD, &nprocs));
+    set_num_ranks(nprocs);
+    MPI_CHECK(MPI_Comm_rank(MPI_COMM_WORLD, &rank));
+
+    if (0 == rank) {
+        switch (po_ret) {
+            case PO_BAD_USAGE:
+                print_bad_usage_message(rank);
+            case PO_HELP_MESSAGE:
+                usage_one_sided("osu_rma_hotspot");
+                break;
+            case PO_VERSION_MESSAGE:
+                print_version_message(rank);
+                MPI_CHECK(MPI_Finalize());
+                exit(EXIT_SUCCESS);
+            default:
+                break;
+        }
+    }
+
+    switch (po_ret) {
+        case PO_CUDA_NOT_AVAIL:
+        case PO_OPENACC_NOT_AVAIL:
+        case PO_BAD_USAGE:
+            MPI_CHECK(MPI_Finalize());
+            exit(EXIT_FAILURE);
+        case PO_HELP_MESSAGE:
+        case PO_VERSION_MESSAGE:
+            MPI_CHECK(MPI_Finalize());
+            exit(EXIT_SUCCESS);
+        case PO_OKAY:
+            break;
+    }
+
+    if (nprocs <= options.rma_targets) {
+        if (rank == 0) {
+            fprintf(stderr, "This test requires more processes than targets "
+                    "(%d)\n", options.rma_targets);
+        }
+
+        MPI_CHECK(MPI_Finalize());
+
+        return EXIT_FAILURE;
+    }
+
+    if (allocate_latency_samples()) {
+        MPI_CHECK(MPI_Finalize());
+        exit(EXIT_FAILURE);
+    }
+
+    MPI_CHECK(MPI_Win_allocate(sizeof(uint64_t), sizeof(uint64_t),
+            MPI_INFO_NULL, MPI_COMM_WORLD, &counter, &win));
+    *counter = 0;
+    MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
+    MPI_CHECK(MPI_Win_lock_all(0, win));
+
+    if (0 == rank) {
+        printf(benchmark_header, "");
+        fprintf(stdout, "# Operation: %s\n", rma_op_name[options.rma_op]);
+        fprintf(stdout, "# Targets: %d\n", options.rma_targets);
+        fprintf(stdout, "# Synchronization: MPI_Win_lock_all + "
+                "MPI_Win_flush\n");
+        fprintf(stdout, "%-*s%*s%*s%*s%*s", 10, "# Origins", FIELD_WIDTH,
+                "Rate (Mops/s)", FIELD_WIDTH, "Avg Latency(us)", FIELD_WIDTH,
+                "Min Latency(us)", FIELD_WIDTH, "Max Latency(us)");
+        print_header_percentiles();
+        fprintf(stdout, "\n");
+        fflush(stdout);
+    }
+
+    max_origins = nprocs - options.rma_targets;
+    for (norigins = 1; norigins < max_origins; norigins *= 2) {
+        run_hotspot(rank, norigins, win);
+    }
+    run_hotspot(rank, max_origins, win);
+
+    MPI_CHECK(MPI_Win_unlock_all(win));
+    MPI_CHECK(MPI_Win_free(&win));
+    free_latency_samples();
+
+    MPI_CHECK(MPI_Finalize());
+
+    return EXIT_SUCCESS;
+}
+
+/* vi: set sw=4 sts=4 tw=80: */
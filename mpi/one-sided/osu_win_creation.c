@@ -0,0 +1,189 @@
+#define BENCHMARK "OSU MPI%s Window Creation Latency Test"
+/*
+ * Copyright (C) 2003-2021 the Network-Based Computing Laboratory
+ * (NBCL), The Ohio State University.
+ *
+ * Contact: Dr. D. K. Panda (panda@cse.ohio-state.edu)
+ *
+ * For detailed copyright and licensing information, please refer to the
+ * copyright file COPYRIGHT in the top level OMB directory.
+ */
+
+#include <osu_util_mpi.h>
+
+/*
+ * Time to create a window of each size with MPI_Win_create, MPI_Win_allocate
+ * and MPI_Win_create_dynamic plus MPI_Win_attach, on the first 2, 4, 8, ...
+ * ranks and on all of them. Each rank times its own calls; the slowest
+ * rank's average is reported since window creation is collective.
+ */
+char *win_buf = NULL;
+
+static double time_win_create (MPI_Comm comm, int size, enum WINDOW type)
+{
+    double t = 0.0, t_start = 0.0, t_max = 0.0;
+    void *base = NULL;
+    int i;
+    MPI_Win win;
+
+    for (i = 0; i < options.skip + options.iterations; i++) {
+        MPI_CHECK(MPI_Barrier(comm));
+        t_start = MPI_Wtime();
+
+        switch (type) {
+            case WIN_CREATE:
+                MPI_CHECK(MPI_Win_create(win_buf, size, 1, MPI_INFO_NULL, comm,
+                        &win));
+                break;
+            case WIN_ALLOCATE:
+                MPI_CHECK(MPI_Win_allocate(size, 1, MPI_INFO_NULL, comm, &base,
+                        &win));
+                break;
+            case WIN_DYNAMIC:
+                MPI_CHECK(MPI_Win_create_dynamic(MPI_INFO_NULL, comm, &win));
+                MPI_CHECK(MPI_Win_attach(win, win_buf, size));
+                break;
+        }
+
+        if (i >= options.skip) {
+            t += MPI_Wtime() - t_start;
+        }
+
+        if (WIN_DYNAMIC == type) {
+            MPI_CHECK(MPI_Win_detach(win, win_buf));
+        }
+        MPI_CHECK(MPI_Win_free(&win));
+    }
+
+    t = t * 1e6 / options.iterations;
+    MPI_CHECK(MPI_Reduce(&t, &t_max, 1, MPI_DOUBLE, MPI_MAX, 0, comm));
+
+    return t_max;
+}
+
+static void run_win_creation (int rank, int nranks)
+{
+    double t_create = 0.0, t_allocate = 0.0, t_dynamic = 0.0;
+    int size;
+    MPI_Comm comm;
+
+    MPI_CHECK(MPI_Comm_split(MPI_COMM_WORLD, rank < nranks ? 0 : MPI_UNDEFINED,
+            rank, &comm));
+
+    if (0 == rank) {
+        fprintf(stdout, "\n# Ranks: %d\n", nranks);
+        fprintf(stdout, "%-*s%*s%*s%*s\n", 10, "# Size", FIELD_WIDTH,
+                "Create (us)", FIELD_WIDTH, "Allocate (us)", FIELD_WIDTH,
+                "Dynamic (us)");
+        fflush(stdout);
+    }
+
+    for (size = first_message_size(1); size <= options.max_message_size;
+            size = next_message_size(size, 1)) {
+        if (MPI_COMM_NULL != comm) {
+            t_create = time_win_create(comm, size, WIN_CREATE);
+            t_allocate = time_win_create(comm, size, WIN_ALLOCATE);
+            t_dynamic = time_win_create(comm, size, WIN_DYNAMIC);
+        }
+
+        if (0 == rank) {
+            fprintf(stdout, "%-*d%*.*f%*.*f%*.*f\n", 10, size, FIELD_WIDTH,
+                    FLOAT_PRECISION, t_create, FIELD_WIDTH, FLOAT_PRECISION,
+                    t_allocate, FIELD_WIDTH, FLOAT_PRECISION, t_dynamic);
+            omb_result_begin(size, options.iterations);
+            omb_result_field("create_us", t_create);
+            omb_result_field("allocate_us", t_allocate);
+            omb_result_field("dynamic_us", t_dynamic);
+            omb_result_field("window_ranks", nranks);
+            omb_result_end();
+            fflush(stdout);
+        }
+    }
+
+    if (MPI_COMM_NULL != comm) {
+        MPI_CHECK(MPI_Comm_free(&comm));
+    }
+
+    MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
+}
+
+int main (int argc, char *argv[])
+{
+    int rank, nprocs, nranks;
+    int po_ret = PO_OKAY;
+
+    options.bench = ONE_SIDED;
+    options.subtype = LAT_WIN;
+    options.synctype = ALL_SYNC;
+
+    set_header(HEADER);
+    set_benchmark_name("osu_win_creation");
+
+    po_ret = process_options(argc, argv);
+
+    MPI_CHECK(MPI_Init(&argc, &argv));
+    MPI_CHECK(MPI_Comm_size(MPI_COMM_WORLD, &nprocs));
+    set_num_ranks(nprocs);
+    MPI_CHECK(MPI_Comm_rank(MPI_COMM_WORLD, &rank));
+
+    if (0 == rank) {
+        switch (po_ret) {
+            case PO_BAD_USAGE:
+                print_bad_usage_message(rank);
+            case PO_HELP_MESSAGE:
+                usage_one_sided("osu_win_creation");
+                break;
+            case PO_VERSION_MESSAGE:
+                print_version_message(rank);
+                MPI_CHECK(MPI_Finalize());
+                exit(EXIT_SUCCESS);
+            default:
+                break;
+        }
+    }
+
+    switch (po_ret) {
+        case PO_CUDA_NOT_AVAIL:
+        case PO_OPENACC_NOT_AVAIL:
+        case PO_BAD_USAGE:
+            MPI_CHECK(MPI_Finalize());
+            exit(EXIT_FAILURE);
+        case PO_HELP_MESSAGE:
+        case PO_VERSION_MESSAGE:
+            MPI_CHECK(MPI_Finalize());
+            exit(EXIT_SUCCESS);
+        case PO_OKAY:
+            break;
+    }
+
+    if (nprocs < 2) {
+        if (rank == 0) {
+            fprintf(stderr, "This test requires at least two processes\n");
+        }
+
+        MPI_CHECK(MPI_Finalize());
+
+        return EXIT_FAILURE;
+    }
+
+    CHECK(allocate_host_buffer((void **)&win_buf, options.max_message_size));
+    memset(win_buf, 'a', options.max_message_size);
+
+    if (0 == rank) {
+        printf(benchmark_header, "");
+        print_host_memory_policy();
+        fflush(stdout);
+    }
+
+    for (nranks = 2; nranks < nprocs; nranks *= 2) {
+        run_win_creation(rank, nranks);
+    }
+    run_win_creation(rank, nprocs);
+
+    free_host_buffer(win_buf);
+    MPI_CHECK(MPI_Finalize());
+
+    return EXIT_SUCCESS;
+}
+
+/* vi: set sw=4 sts=4 tw=80: */
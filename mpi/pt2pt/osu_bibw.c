@@ -50,6 +50,7 @@ int main(int argc, char *argv[])
 
     MPI_CHECK(MPI_Init(&argc, &argv));
     MPI_CHECK(MPI_Comm_size(MPI_COMM_WORLD, &numprocs));
+    set_num_ranks(numprocs);
     MPI_CHECK(MPI_Comm_rank(MPI_COMM_WORLD, &myid));
 
     if (0 == myid) {
@@ -120,7 +121,7 @@ int main(int argc, char *argv[])
     print_header(myid, BW);
 
     /* Bi-Directional Bandwidth test */
-    for (size = options.min_message_size; size <= options.max_message_size; size *= 2) {
+    for (size = first_message_size(1); size <= options.max_message_size; size = next_message_size(size, 1)) {
 
         if (options.buf_num == MULTIPLE) {
             for (i = 0; i < window_size; i++) {
@@ -152,6 +153,13 @@ int main(int argc, char *argv[])
         }
 #endif /* #ifdef _ENABLE_CUDA_KERNEL_ */
 
+        if (options.persistent) {
+            init_persistent_requests(r_buf, size, 1 - myid, myid ? 100 : 10, 0,
+                    window_size, recv_request);
+            init_persistent_requests(s_buf, size, 1 - myid, myid ? 10 : 100, 1,
+                    window_size, send_request);
+        }
+
         MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
         t_total = 0.0;
 
@@ -167,23 +175,28 @@ int main(int argc, char *argv[])
                 }
 #endif /* #ifdef _ENABLE_CUDA_KERNEL_ */
 
-                for (j = 0; j < window_size; j++) {
-                    if (options.buf_num == SINGLE) {
-                        MPI_CHECK(MPI_Irecv(r_buf[0], size, MPI_CHAR, 1, 10, MPI_COMM_WORLD,
-                                  recv_request + j));
-                    } else {
-                        MPI_CHECK(MPI_Irecv(r_buf[j], size, MPI_CHAR, 1, 10, MPI_COMM_WORLD,
-                                  recv_request + j));
+                if (options.persistent) {
+                    MPI_CHECK(MPI_Startall(window_size, recv_request));
+                    MPI_CHECK(MPI_Startall(window_size, send_request));
+                } else {
+                    for (j = 0; j < window_size; j++) {
+                        if (options.buf_num == SINGLE) {
+                            MPI_CHECK(MPI_Irecv(r_buf[0], size, MPI_CHAR, 1, 10, MPI_COMM_WORLD,
+                                      recv_request + j));
+                        } else {
+                            MPI_CHECK(MPI_Irecv(r_buf[j], size, MPI_CHAR, 1, 10, MPI_COMM_WORLD,
+                                      recv_request + j));
+                        }
                     }
-                }
 
-                for (j = 0; j < window_size; j++) {
-                    if (options.buf_num == SINGLE) {
-                        MPI_CHECK(MPI_Isend(s_buf[0], size, MPI_CHAR, 1, 100, MPI_COMM_WORLD,
-                                  send_request + j));
-                    } else {
-                        MPI_CHECK(MPI_Isend(s_buf[j], size, MPI_CHAR, 1, 100, MPI_COMM_WORLD,
-                                  send_request + j));
+                    for (j = 0; j < window_size; j++) {
+                        if (options.buf_num == SINGLE) {
+                            MPI_CHECK(MPI_Isend(s_buf[0], size, MPI_CHAR, 1, 100, MPI_COMM_WORLD,
+                                      send_request + j));
+                        } else {
+                            MPI_CHECK(MPI_Isend(s_buf[j], size, MPI_CHAR, 1, 100, MPI_COMM_WORLD,
+                                      send_request + j));
+                        }
                     }
                 }
 
@@ -208,23 +221,28 @@ int main(int argc, char *argv[])
                 }
 #endif /* #ifdef _ENABLE_CUDA_KERNEL_ */
 
-                for (j = 0; j < window_size; j++) {
-                    if (options.buf_num == SINGLE) {
-                        MPI_CHECK(MPI_Irecv(r_buf[0], size, MPI_CHAR, 0, 100, MPI_COMM_WORLD,
-                                  recv_request + j));
-                    } else {
-                        MPI_CHECK(MPI_Irecv(r_buf[j], size, MPI_CHAR, 0, 100, MPI_COMM_WORLD,
-                                  recv_request + j));
+                if (options.persistent) {
+                    MPI_CHECK(MPI_Startall(window_size, recv_request));
+                    MPI_CHECK(MPI_Startall(window_size, send_request));
+                } else {
+                    for (j = 0; j < window_size; j++) {
+                        if (options.buf_num == SINGLE) {
+                            MPI_CHECK(MPI_Irecv(r_buf[0], size, MPI_CHAR, 0, 100, MPI_COMM_WORLD,
+                                      recv_request + j));
+                        } else {
+                            MPI_CHECK(MPI_Irecv(r_buf[j], size, MPI_CHAR, 0, 100, MPI_COMM_WORLD,
+                                      recv_request + j));
+                        }
                     }
-                }
 
-                for (j = 0; j < window_size; j++) {
-                    if (options.buf_num == SINGLE) {
-                        MPI_CHECK(MPI_Isend(s_buf[0], size, MPI_CHAR, 0, 10, MPI_COMM_WORLD,
-                                  send_request + j));
-                    } else {
-                        MPI_CHECK(MPI_Isend(s_buf[j], size, MPI_CHAR, 0, 10, MPI_COMM_WORLD,
-                                  send_request + j));
+                    for (j = 0; j < window_size; j++) {
+                        if (options.buf_num == SINGLE) {
+                            MPI_CHECK(MPI_Isend(s_buf[0], size, MPI_CHAR, 0, 10, MPI_COMM_WORLD,
+                                      send_request + j));
+                        } else {
+                            MPI_CHECK(MPI_Isend(s_buf[j], size, MPI_CHAR, 0, 10, MPI_COMM_WORLD,
+                                      send_request + j));
+                        }
                     }
                 }
 
@@ -240,11 +258,15 @@ int main(int argc, char *argv[])
             }
         }
 
+        if (options.persistent) {
+            free_persistent_requests(window_size, recv_request);
+            free_persistent_requests(window_size, send_request);
+        }
+
         if (myid == 0) {
             double tmp = size / 1e6 * options.iterations * window_size * 2;
 
-            fprintf(stdout, "%-*d%*.*f\n", 10, size, FIELD_WIDTH,
-                    FLOAT_PRECISION, tmp / t_total);
+            print_result(size, "bandwidth_mbps", tmp / t_total);
             fflush(stdout);
         }
 
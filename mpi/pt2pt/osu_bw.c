@@ -52,6 +52,7 @@ main (int argc, char *argv[])
     
     MPI_CHECK(MPI_Init(&argc, &argv));
     MPI_CHECK(MPI_Comm_size(MPI_COMM_WORLD, &numprocs));
+    set_num_ranks(numprocs);
     MPI_CHECK(MPI_Comm_rank(MPI_COMM_WORLD, &myid));
 
     if (0 == myid) {
@@ -122,7 +123,7 @@ main (int argc, char *argv[])
     print_header(myid, BW);
 
     /* Bandwidth test */
-    for (size = options.min_message_size; size <= options.max_message_size; size *= 2) {
+    for (size = first_message_size(1); size <= options.max_message_size; size = next_message_size(size, 1)) {
         if (options.buf_num == MULTIPLE) {
             for (i = 0; i < window_size; i++) {
                 if (allocate_memory_pt2pt_size(&s_buf[i], &r_buf[i], myid, size)) {
@@ -152,6 +153,11 @@ main (int argc, char *argv[])
         }
 #endif /* #ifdef _ENABLE_CUDA_KERNEL_ */
 
+        if (options.persistent) {
+            init_persistent_requests(myid ? r_buf : s_buf, size, 1 - myid,
+                    100, 0 == myid, window_size, request);
+        }
+
         MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
         t_total = 0.0;
 
@@ -167,13 +173,17 @@ main (int argc, char *argv[])
                 }
 #endif /* #ifdef _ENABLE_CUDA_KERNEL_ */
 
-                for (j = 0; j < window_size; j++) {
-                    if (options.buf_num == SINGLE) {
-                        MPI_CHECK(MPI_Isend(s_buf[0], size, MPI_CHAR, 1, 100, MPI_COMM_WORLD,
-                                  request + j));
-                    } else {
-                        MPI_CHECK(MPI_Isend(s_buf[j], size, MPI_CHAR, 1, 100, MPI_COMM_WORLD,
-                                  request + j));
+                if (options.persistent) {
+                    MPI_CHECK(MPI_Startall(window_size, request));
+                } else {
+                    for (j = 0; j < window_size; j++) {
+                        if (options.buf_num == SINGLE) {
+                            MPI_CHECK(MPI_Isend(s_buf[0], size, MPI_CHAR, 1, 100, MPI_COMM_WORLD,
+                                      request + j));
+                        } else {
+                            MPI_CHECK(MPI_Isend(s_buf[j], size, MPI_CHAR, 1, 100, MPI_COMM_WORLD,
+                                      request + j));
+                        }
                     }
                 }
                 MPI_CHECK(MPI_Waitall(window_size, request, reqstat));
@@ -196,13 +206,17 @@ main (int argc, char *argv[])
                     touch_managed_dst(s_buf, size, window_size);
                 }
 #endif /* #ifdef _ENABLE_CUDA_KERNEL_ */
-                for (j = 0; j < window_size; j++) {
-                    if (options.buf_num == SINGLE) {
-                        MPI_CHECK(MPI_Irecv(r_buf[0], size, MPI_CHAR, 0, 100, MPI_COMM_WORLD,
-                                  request + j));
-                    } else {
-                        MPI_CHECK(MPI_Irecv(r_buf[j], size, MPI_CHAR, 0, 100, MPI_COMM_WORLD,
-                                  request + j));
+                if (options.persistent) {
+                    MPI_CHECK(MPI_Startall(window_size, request));
+                } else {
+                    for (j = 0; j < window_size; j++) {
+                        if (options.buf_num == SINGLE) {
+                            MPI_CHECK(MPI_Irecv(r_buf[0], size, MPI_CHAR, 0, 100, MPI_COMM_WORLD,
+                                      request + j));
+                        } else {
+                            MPI_CHECK(MPI_Irecv(r_buf[j], size, MPI_CHAR, 0, 100, MPI_COMM_WORLD,
+                                      request + j));
+                        }
                     }
                 }
                 MPI_CHECK(MPI_Waitall(window_size, request, reqstat));
@@ -217,10 +231,13 @@ main (int argc, char *argv[])
             }
         }
 
+        if (options.persistent) {
+            free_persistent_requests(window_size, request);
+        }
+
         if (myid == 0) {
             double tmp = size / 1e6 * options.iterations * window_size;
-            fprintf(stdout, "%-*d%*.*f\n", 10, size, FIELD_WIDTH,
-                    FLOAT_PRECISION, tmp / t_total);
+            print_result(size, "bandwidth_mbps", tmp / t_total);
             fflush(stdout);
         }
 
@@ -0,0 +1,252 @@
+#define BENCHMARK "OSU MPI%s Derived Datatype Bandwidth Test"
+/*
+ * Copyright (C) 2002-2021 the Network-Based Computing Laboratory
+ * (NBCL), The Ohio State University.
+ *
+ * Contact: Dr. D. K. Panda (panda@cse.ohio-state.edu)
+ *
+ * For detailed copyright and licensing information, please refer to the
+ * copyright file COPYRIGHT in the top level OMB directory.
+ */
+
+#include <osu_util_mpi.h>
+
+/*
+ * Rank 0 sends windows of options.window_size messages of SIZE bytes taken
+ * from blocks of options.ddt_block bytes every options.ddt_stride bytes:
+ * as one element of a derived datatype, packed by memcpy into its own slot
+ * of a contiguous buffer, and as a plain contiguous message of the same
+ * payload. Rank 1 unpacks the manually packed messages once the window has
+ * arrived, then acknowledges the window.
+ */
+enum ddt_method {
+    SEND_DDT,
+    SEND_MANUAL,
+    SEND_CONTIG
+};
+
+static char *s_buf, *r_buf, *s_pack, *r_pack;
+
+static double ddt_bw (int myid, int size, MPI_Datatype ddt,
+        enum ddt_method method)
+{
+    int i, j, nblocks = size / options.ddt_block;
+    double t_start = 0.0, t_end = 0.0;
+
+    MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
+
+    for (i = 0; i < options.iterations + options.skip; i++) {
+        if (i == options.skip) {
+            t_start = MPI_Wtime();
+        }
+
+        if (0 == myid) {
+            for (j = 0; j < options.window_size; j++) {
+                if (SEND_DDT == method) {
+                    MPI_CHECK(MPI_Isend(s_buf, 1, ddt, 1, 100,
+                            MPI_COMM_WORLD, request + j));
+                    continue;
+                }
+                if (SEND_MANUAL == method) {
+                    pack_blocks(s_pack + (size_t)j * size, s_buf, nblocks);
+                }
+                MPI_CHECK(MPI_Isend(s_pack + (size_t)j * size, size, MPI_CHAR,
+                        1, 100, MPI_COMM_WORLD, request + j));
+            }
+            MPI_CHECK(MPI_Waitall(options.window_size, request,
+                    MPI_STATUSES_IGNORE));
+            MPI_CHECK(MPI_Recv(r_pack, 4, MPI_CHAR, 1, 101, MPI_COMM_WORLD,
+                    MPI_STATUS_IGNORE));
+        } else {
+            for (j = 0; j < options.window_size; j++) {
+                if (SEND_DDT == method) {
+                    MPI_CHECK(MPI_Irecv(r_buf, 1, ddt, 0, 100,
+                            MPI_COMM_WORLD, request + j));
+                } else {
+                    MPI_CHECK(MPI_Irecv(r_pack + (size_t)j * size, size,
+                            MPI_CHAR, 0, 100, MPI_COMM_WORLD, request + j));
+                }
+            }
+            MPI_CHECK(MPI_Waitall(options.window_size, request,
+                    MPI_STATUSES_IGNORE));
+            for (j = 0; SEND_MANUAL == method && j < options.window_size;
+                    j++) {
+                unpack_blocks(r_buf, r_pack + (size_t)j * size, nblocks);
+            }
+            MPI_CHECK(MPI_Send(s_pack, 4, MPI_CHAR, 0, 101, MPI_COMM_WORLD));
+        }
+    }
+
+    t_end = MPI_Wtime();
+
+    return size / 1e6 * options.iterations * options.window_size /
+        (t_end - t_start);
+}
+
+static void run_ddt (int myid, enum ddt_type type)
+{
+    char name[64];
+    int size, nblocks;
+    double bw_ddt, bw_manual, bw_contig;
+    MPI_Datatype ddt;
+
+    snprintf(name, sizeof(name), "osu_ddt_bw_%s", ddt_names[type]);
+    set_benchmark_name(name);
+
+    if (0 == myid) {
+        fprintf(stdout, "\n# Datatype: %s, %zu-byte blocks every %zu bytes\n",
+                ddt_constructor[type], options.ddt_block, options.ddt_stride);
+        fprintf(stdout, "%-*s%*s%*s%*s\n", 10, "# Size", FIELD_WIDTH,
+                "Datatype (MB/s)", FIELD_WIDTH, "Manual Pack (MB/s)",
+                FIELD_WIDTH, "Contiguous (MB/s)");
+        fflush(stdout);
+    }
+
+    for (nblocks = first_message_size(options.ddt_block);
+            nblocks * options.ddt_block <= options.max_message_size;
+            nblocks = next_message_size(nblocks, options.ddt_block)) {
+        if (0 == nblocks) {
+            continue;
+        }
+        size = nblocks * options.ddt_block;
+
+        if (size > LARGE_MESSAGE_SIZE) {
+            options.iterations = options.iterations_large;
+            options.skip = options.skip_large;
+        }
+
+        ddt = create_ddt(type, nblocks);
+
+        bw_ddt = ddt_bw(myid, size, ddt, SEND_DDT);
+        bw_manual = ddt_bw(myid, size, ddt, SEND_MANUAL);
+        bw_contig = ddt_bw(myid, size, ddt, SEND_CONTIG);
+
+        if (0 == myid) {
+            fprintf(stdout, "%-*d%*.*f%*.*f%*.*f\n", 10, size,
+                    FIELD_WIDTH, FLOAT_PRECISION, bw_ddt,
+                    FIELD_WIDTH, FLOAT_PRECISION, bw_manual,
+                    FIELD_WIDTH, FLOAT_PRECISION, bw_contig);
+            omb_result_begin(size, options.iterations);
+            omb_result_metric("bandwidth_mbps", bw_ddt);
+            omb_result_field("manual_bandwidth_mbps", bw_manual);
+            omb_result_field("contiguous_bandwidth_mbps", bw_contig);
+            omb_result_field("block_bytes", options.ddt_block);
+            omb_result_field("stride_bytes", options.ddt_stride);
+            omb_result_end();
+            fflush(stdout);
+        }
+
+        MPI_CHECK(MPI_Type_free(&ddt));
+    }
+}
+
+int main (int argc, char *argv[])
+{
+    int myid, numprocs, t;
+    size_t iterations, skip, extent, packed;
+    int po_ret;
+
+    options.bench = PT2PT;
+    options.subtype = BW_DDT;
+
+    set_header(HEADER);
+    set_benchmark_name("osu_ddt_bw");
+
+    po_ret = process_options(argc, argv);
+
+    MPI_CHECK(MPI_Init(&argc, &argv));
+    MPI_CHECK(MPI_Comm_size(MPI_COMM_WORLD, &numprocs));
+    set_num_ranks(numprocs);
+    MPI_CHECK(MPI_Comm_rank(MPI_COMM_WORLD, &myid));
+
+    if (0 == myid) {
+        switch (po_ret) {
+            case PO_BAD_USAGE:
+                print_bad_usage_message(myid);
+                break;
+            case PO_HELP_MESSAGE:
+                print_help_message(myid);
+                break;
+            case PO_VERSION_MESSAGE:
+                print_version_message(myid);
+                MPI_CHECK(MPI_Finalize());
+                exit(EXIT_SUCCESS);
+            case PO_OKAY:
+                break;
+        }
+    }
+
+    switch (po_ret) {
+        case PO_CUDA_NOT_AVAIL:
+        case PO_OPENACC_NOT_AVAIL:
+        case PO_BAD_USAGE:
+            MPI_CHECK(MPI_Finalize());
+            exit(EXIT_FAILURE);
+        case PO_HELP_MESSAGE:
+        case PO_VERSION_MESSAGE:
+            MPI_CHECK(MPI_Finalize());
+            exit(EXIT_SUCCESS);
+        case PO_OKAY:
+            break;
+    }
+
+    if (numprocs != 2) {
+        if (myid == 0) {
+            fprintf(stderr, "This test requires exactly two processes\n");
+        }
+
+        MPI_CHECK(MPI_Finalize());
+        exit(EXIT_FAILURE);
+    }
+
+    /* every message of a window is packed into its own slot */
+    if (options.max_message_size * options.window_size >
+            options.max_mem_limit) {
+        options.max_message_size = options.max_mem_limit / options.window_size;
+    }
+
+    /* the strided buffers hold max_message_size bytes of blocks */
+    extent = ddt_extent();
+    packed = options.max_message_size * options.window_size;
+
+    if (allocate_host_buffer((void **)&s_buf, MAX(extent, 1)) ||
+            allocate_host_buffer((void **)&r_buf, MAX(extent, 1)) ||
+            allocate_host_buffer((void **)&s_pack, MAX(packed, 4)) ||
+            allocate_host_buffer((void **)&r_pack, MAX(packed, 4))) {
+        fprintf(stderr, "Could Not Allocate Memory [rank %d]\n", myid);
+        MPI_CHECK(MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE));
+    }
+    memset(s_buf, 'a', extent);
+    memset(r_buf, 'b', extent);
+    memset(s_pack, 'a', MAX(packed, 4));
+    memset(r_pack, 'b', MAX(packed, 4));
+
+    print_header(myid, BW_DDT);
+    if (0 == myid) {
+        fprintf(stdout, "# [ window size: %d ]\n", options.window_size);
+        fflush(stdout);
+    }
+
+    /* every datatype starts from the small-message iteration counts */
+    iterations = options.iterations;
+    skip = options.skip;
+
+    for (t = 0; t < DDT_NUM_TYPES; t++) {
+        if (options.ddt_types & (1 << t)) {
+            options.iterations = iterations;
+            options.skip = skip;
+            run_ddt(myid, t);
+        }
+    }
+
+    free_host_buffer(s_buf);
+    free_host_buffer(r_buf);
+    free_host_buffer(s_pack);
+    free_host_buffer(r_pack);
+
+    MPI_CHECK(MPI_Finalize());
+
+    return EXIT_SUCCESS;
+}
+
+/* vi: set sw=4 sts=4 tw=80: */
@@ -0,0 +1,279 @@
+#define BENCHMARK "OSU MPI%s Derived Datatype Latency Test"
+/*
+ * Copyright (C) 2002-2021 the Network-Based Computing Laboratory
+ * (NBCL), The Ohio State University.
+ *
+ * Contact: Dr. D. K. Panda (panda@cse.ohio-state.edu)
+ *
+ * For detailed copyright and licensing information, please refer to the
+ * copyright file COPYRIGHT in the top level OMB directory.
+ */
+
+#include <osu_util_mpi.h>
+
+/*
+ * Ping-pong of SIZE bytes taken from blocks of options.ddt_block bytes that
+ * start every options.ddt_stride bytes. The blocks are sent as one element
+ * of a derived datatype, and packed by memcpy into a contiguous message. A
+ * plain contiguous ping-pong of the same payload gives the floor for both.
+ * The MPI_Pack and MPI_Unpack rates show the datatype engine on its own.
+ */
+enum ddt_method {
+    SEND_DDT,
+    SEND_MANUAL,
+    SEND_CONTIG
+};
+
+static char *s_buf, *r_buf, *s_pack, *r_pack;
+
+static void send_message (int peer, int size, MPI_Datatype ddt,
+        enum ddt_method method)
+{
+    switch (method) {
+        case SEND_DDT:
+            MPI_CHECK(MPI_Send(s_buf, 1, ddt, peer, 1, MPI_COMM_WORLD));
+            break;
+        case SEND_MANUAL:
+            pack_blocks(s_pack, s_buf, size / options.ddt_block);
+            /* fall through */
+        case SEND_CONTIG:
+            MPI_CHECK(MPI_Send(s_pack, size, MPI_CHAR, peer, 1,
+                    MPI_COMM_WORLD));
+            break;
+    }
+}
+
+static void recv_message (int peer, int size, MPI_Datatype ddt,
+        enum ddt_method method)
+{
+    switch (method) {
+        case SEND_DDT:
+            MPI_CHECK(MPI_Recv(r_buf, 1, ddt, peer, 1, MPI_COMM_WORLD,
+                    MPI_STATUS_IGNORE));
+            break;
+        case SEND_MANUAL:
+        case SEND_CONTIG:
+            MPI_CHECK(MPI_Recv(r_pack, size, MPI_CHAR, peer, 1,
+                    MPI_COMM_WORLD, MPI_STATUS_IGNORE));
+            if (SEND_MANUAL == method) {
+                unpack_blocks(r_buf, r_pack, size / options.ddt_block);
+            }
+            break;
+    }
+}
+
+static double ddt_latency (int myid, int size, MPI_Datatype ddt,
+        enum ddt_method method)
+{
+    int i, peer = 1 - myid;
+    double t_start = 0.0, t_end = 0.0;
+
+    MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
+
+    for (i = 0; i < options.iterations + options.skip; i++) {
+        if (i == options.skip) {
+            t_start = MPI_Wtime();
+        }
+
+        if (0 == myid) {
+            send_message(peer, size, ddt, method);
+            recv_message(peer, size, ddt, method);
+        } else {
+            recv_message(peer, size, ddt, method);
+            send_message(peer, size, ddt, method);
+        }
+    }
+
+    t_end = MPI_Wtime();
+
+    return (t_end - t_start) * 1e6 / (2.0 * options.iterations);
+}
+
+/* MB/s of MPI_Pack, or of MPI_Unpack with unpack set */
+static double pack_rate (int size, MPI_Datatype ddt, int unpack)
+{
+    int i, position;
+    double t_start = 0.0;
+
+    for (i = 0; i < options.iterations + options.skip; i++) {
+        if (i == options.skip) {
+            t_start = MPI_Wtime();
+        }
+
+        position = 0;
+        if (unpack) {
+            MPI_CHECK(MPI_Unpack(s_pack, size, &position, r_buf, 1, ddt,
+                    MPI_COMM_SELF));
+        } else {
+            MPI_CHECK(MPI_Pack(s_buf, 1, ddt, s_pack, size, &position,
+                    MPI_COMM_SELF));
+        }
+    }
+
+    return size / 1e6 * options.iterations / (MPI_Wtime() - t_start);
+}
+
+static void run_ddt (int myid, enum ddt_type type)
+{
+    char name[64];
+    int size, nblocks;
+    double lat_ddt, lat_manual, lat_contig, pack = 0.0, unpack = 0.0;
+    MPI_Datatype ddt;
+
+    snprintf(name, sizeof(name), "osu_ddt_latency_%s", ddt_names[type]);
+    set_benchmark_name(name);
+
+    if (0 == myid) {
+        fprintf(stdout, "\n# Datatype: %s, %zu-byte blocks every %zu bytes\n",
+                ddt_constructor[type], options.ddt_block, options.ddt_stride);
+        fprintf(stdout, "%-*s%*s%*s%*s%*s%*s\n", 10, "# Size", FIELD_WIDTH,
+                "Datatype (us)", FIELD_WIDTH, "Manual Pack (us)",
+                FIELD_WIDTH, "Contiguous (us)", FIELD_WIDTH,
+                "MPI_Pack (MB/s)", FIELD_WIDTH, "MPI_Unpack (MB/s)");
+        fflush(stdout);
+    }
+
+    for (nblocks = first_message_size(options.ddt_block);
+            nblocks * options.ddt_block <= options.max_message_size;
+            nblocks = next_message_size(nblocks, options.ddt_block)) {
+        if (0 == nblocks) {
+            continue;
+        }
+        size = nblocks * options.ddt_block;
+
+        if (size > LARGE_MESSAGE_SIZE) {
+            options.iterations = options.iterations_large;
+            options.skip = options.skip_large;
+        }
+
+        ddt = create_ddt(type, nblocks);
+
+        lat_ddt = ddt_latency(myid, size, ddt, SEND_DDT);
+        lat_manual = ddt_latency(myid, size, ddt, SEND_MANUAL);
+        lat_contig = ddt_latency(myid, size, ddt, SEND_CONTIG);
+
+        if (0 == myid) {
+            pack = pack_rate(size, ddt, 0);
+            unpack = pack_rate(size, ddt, 1);
+
+            fprintf(stdout, "%-*d%*.*f%*.*f%*.*f%*.*f%*.*f\n", 10, size,
+                    FIELD_WIDTH, FLOAT_PRECISION, lat_ddt,
+                    FIELD_WIDTH, FLOAT_PRECISION, lat_manual,
+                    FIELD_WIDTH, FLOAT_PRECISION, lat_contig,
+                    FIELD_WIDTH, FLOAT_PRECISION, pack,
+                    FIELD_WIDTH, FLOAT_PRECISION, unpack);
+            omb_result_begin(size, options.iterations);
+            omb_result_metric("latency_us", lat_ddt);
+            omb_result_field("manual_latency_us", lat_manual);
+            omb_result_field("contiguous_latency_us", lat_contig);
+            omb_result_field("pack_mbps", pack);
+            omb_result_field("unpack_mbps", unpack);
+            omb_result_field("block_bytes", options.ddt_block);
+            omb_result_field("stride_bytes", options.ddt_stride);
+            omb_result_end();
+            fflush(stdout);
+        }
+
+        MPI_CHECK(MPI_Type_free(&ddt));
+    }
+}
+
+int main (int argc, char *argv[])
+{
+    int myid, numprocs, t;
+    size_t iterations, skip, extent;
+    int po_ret;
+
+    options.bench = PT2PT;
+    options.subtype = LAT_DDT;
+
+    set_header(HEADER);
+    set_benchmark_name("osu_ddt_latency");
+
+    po_ret = process_options(argc, argv);
+
+    MPI_CHECK(MPI_Init(&argc, &argv));
+    MPI_CHECK(MPI_Comm_size(MPI_COMM_WORLD, &numprocs));
+    set_num_ranks(numprocs);
+    MPI_CHECK(MPI_Comm_rank(MPI_COMM_WORLD, &myid));
+
+    if (0 == myid) {
+        switch (po_ret) {
+            case PO_BAD_USAGE:
+                print_bad_usage_message(myid);
+                break;
+            case PO_HELP_MESSAGE:
+                print_help_message(myid);
+                break;
+            case PO_VERSION_MESSAGE:
+                print_version_message(myid);
+                MPI_CHECK(MPI_Finalize());
+                exit(EXIT_SUCCESS);
+            case PO_OKAY:
+                break;
+        }
+    }
+
+    switch (po_ret) {
+        case PO_CUDA_NOT_AVAIL:
+        case PO_OPENACC_NOT_AVAIL:
+        case PO_BAD_USAGE:
+            MPI_CHECK(MPI_Finalize());
+            exit(EXIT_FAILURE);
+        case PO_HELP_MESSAGE:
+        case PO_VERSION_MESSAGE:
+            MPI_CHECK(MPI_Finalize());
+            exit(EXIT_SUCCESS);
+        case PO_OKAY:
+            break;
+    }
+
+    if (numprocs != 2) {
+        if (myid == 0) {
+            fprintf(stderr, "This test requires exactly two processes\n");
+        }
+
+        MPI_CHECK(MPI_Finalize());
+        exit(EXIT_FAILURE);
+    }
+
+    /* the strided buffers hold max_message_size bytes of blocks */
+    extent = ddt_extent();
+
+    if (allocate_host_buffer((void **)&s_buf, MAX(extent, 1)) ||
+            allocate_host_buffer((void **)&r_buf, MAX(extent, 1)) ||
+            allocate_host_buffer((void **)&s_pack, options.max_message_size) ||
+            allocate_host_buffer((void **)&r_pack, options.max_message_size)) {
+        fprintf(stderr, "Could Not Allocate Memory [rank %d]\n", myid);
+        MPI_CHECK(MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE));
+    }
+    memset(s_buf, 'a', extent);
+    memset(r_buf, 'b', extent);
+    memset(s_pack, 'a', options.max_message_size);
+    memset(r_pack, 'b', options.max_message_size);
+
+    print_header(myid, LAT_DDT);
+
+    /* every datatype starts from the small-message iteration counts */
+    iterations = options.iterations;
+    skip = options.skip;
+
+    for (t = 0; t < DDT_NUM_TYPES; t++) {
+        if (options.ddt_types & (1 << t)) {
+            options.iterations = iterations;
+            options.skip = skip;
+            run_ddt(myid, t);
+        }
+    }
+
+    free_host_buffer(s_buf);
+    free_host_buffer(r_buf);
+    free_host_buffer(s_pack);
+    free_host_buffer(r_pack);
+
+    MPI_CHECK(MPI_Finalize());
+
+    return EXIT_SUCCESS;
+}
+
+/* vi: set sw=4 sts=4 tw=80: */
@@ -17,6 +17,53 @@ void touch_managed_dst(char *, int);
 #endif /* #ifdef _ENABLE_CUDA_KERNEL_ */
 double calculate_total(double, double, double);
 
+/*
+ * Ping-pong with cold caches, where every iteration either takes new buffers
+ * from the cache pool or flushes s_buf and r_buf before the message is sent,
+ * or with fresh buffers that the MPI library has not registered yet. The
+ * barrier after the preparation keeps rank 1's allocation or flush out of
+ * rank 0's timed region.
+ */
+static double extra_latency (int myid, int size, char *s_buf, char *r_buf,
+        int fresh)
+{
+    MPI_Status reqstat;
+    double t_start = 0.0, t_total = 0.0;
+    int i;
+
+    for (i = 0; i < options.iterations + options.skip; i++) {
+        if (fresh) {
+            s_buf = fresh_buffer(2 * i, size);
+            r_buf = fresh_buffer(2 * i + 1, size);
+        } else if (CACHE_COLD == options.cache_state) {
+            s_buf = cache_buffer(2 * i, size);
+            r_buf = cache_buffer(2 * i + 1, size);
+        } else {
+            flush_cache(s_buf, size);
+            flush_cache(r_buf, size);
+        }
+        MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
+
+        if (myid == 0) {
+            t_start = MPI_Wtime();
+            MPI_CHECK(MPI_Send(s_buf, size, MPI_CHAR, 1, 1, MPI_COMM_WORLD));
+            MPI_CHECK(MPI_Recv(r_buf, size, MPI_CHAR, 1, 1, MPI_COMM_WORLD, &reqstat));
+            if (i >= options.skip) {
+                t_total += MPI_Wtime() - t_start;
+            }
+        } else if (myid == 1) {
+            MPI_CHECK(MPI_Recv(r_buf, size, MPI_CHAR, 0, 1, MPI_COMM_WORLD, &reqstat));
+            MPI_CHECK(MPI_Send(s_buf, size, MPI_CHAR, 0, 1, MPI_COMM_WORLD));
+        }
+    }
+
+    if (fresh) {
+        free_fresh_buffers();
+    }
+
+    return (t_total * 1e6) / (2.0 * options.iterations);
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -24,11 +71,13 @@ main (int argc, char *argv[])
     int size;
     MPI_Status reqstat;
     char *s_buf, *r_buf;
-    double t_start = 0.0, t_end = 0.0, t_lo = 0.0, t_total = 0.0;
+    double t_start = 0.0, t_end = 0.0, t_lo = 0.0, t_total = 0.0, t_iter = 0.0;
+    double t_cold = 0.0, t_fresh = 0.0;
     int po_ret = 0;
 
     options.bench = PT2PT;
     options.subtype = LAT;
+    options.features = FEATURE_CACHE;
 
     set_header(HEADER);
     set_benchmark_name("osu_latency");
@@ -44,6 +93,7 @@ main (int argc, char *argv[])
 
     MPI_CHECK(MPI_Init(&argc, &argv));
     MPI_CHECK(MPI_Comm_size(MPI_COMM_WORLD, &numprocs));
+    set_num_ranks(numprocs);
     MPI_CHECK(MPI_Comm_rank(MPI_COMM_WORLD, &myid));
 
     if (0 == myid) {
@@ -102,10 +152,16 @@ main (int argc, char *argv[])
         }
     }
 
+    if (allocate_latency_samples() ||
+            allocate_cache_pool(options.max_message_size)) {
+        MPI_CHECK(MPI_Finalize());
+        exit(EXIT_FAILURE);
+    }
+
     print_header(myid, LAT);
 
     /* Latency test */
-    for (size = options.min_message_size; size <= options.max_message_size; size = (size ? size * 2 : 1)) {
+    for (size = first_message_size(1); size <= options.max_message_size; size = next_message_size(size, 1)) {
 
         if (options.buf_num == MULTIPLE) {
             if (allocate_memory_pt2pt_size(&s_buf, &r_buf, myid, size)) {
@@ -130,6 +186,14 @@ main (int argc, char *argv[])
         }
 #endif /* #ifdef _ENABLE_CUDA_KERNEL_ */
 
+        if (options.persistent) {
+            init_persistent_requests(&s_buf, size, 1 - myid, 1, 1, 1,
+                    send_request);
+            init_persistent_requests(&r_buf, size, 1 - myid, 1, 0, 1,
+                    recv_request);
+        }
+
+        adaptive_begin();
         MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
         t_total = 0.0;
 
@@ -144,8 +208,15 @@ main (int argc, char *argv[])
                     touch_managed_src(s_buf, size);
                 }
 #endif /* #ifdef _ENABLE_CUDA_KERNEL_ */
-                MPI_CHECK(MPI_Send(s_buf, size, MPI_CHAR, 1, 1, MPI_COMM_WORLD));
-                MPI_CHECK(MPI_Recv(r_buf, size, MPI_CHAR, 1, 1, MPI_COMM_WORLD, &reqstat));
+                if (options.persistent) {
+                    MPI_CHECK(MPI_Start(send_request));
+                    MPI_CHECK(MPI_Wait(send_request, &reqstat));
+                    MPI_CHECK(MPI_Start(recv_request));
+                    MPI_CHECK(MPI_Wait(recv_request, &reqstat));
+                } else {
+                    MPI_CHECK(MPI_Send(s_buf, size, MPI_CHAR, 1, 1, MPI_COMM_WORLD));
+                    MPI_CHECK(MPI_Recv(r_buf, size, MPI_CHAR, 1, 1, MPI_COMM_WORLD, &reqstat));
+                }
 #ifdef _ENABLE_CUDA_KERNEL_
                 if (options.src == 'M') {
                     touch_managed_src(r_buf, size);
@@ -153,7 +224,9 @@ main (int argc, char *argv[])
 #endif /* #ifdef _ENABLE_CUDA_KERNEL_ */
                 if (i >= options.skip) {
                     t_end = MPI_Wtime();
-                    t_total += calculate_total(t_start, t_end, t_lo);
+                    t_iter = calculate_total(t_start, t_end, t_lo);
+                    t_total += t_iter;
+                    record_latency_sample(t_iter * 1e6 / 2.0);
                 }
             } else if (myid == 1) {
 #ifdef _ENABLE_CUDA_KERNEL_
@@ -161,21 +234,63 @@ main (int argc, char *argv[])
                     touch_managed_dst(s_buf, size);
                 }
 #endif /* #ifdef _ENABLE_CUDA_KERNEL_ */
-                MPI_CHECK(MPI_Recv(r_buf, size, MPI_CHAR, 0, 1, MPI_COMM_WORLD, &reqstat));
+                if (options.persistent) {
+                    MPI_CHECK(MPI_Start(recv_request));
+                    MPI_CHECK(MPI_Wait(recv_request, &reqstat));
+                } else {
+                    MPI_CHECK(MPI_Recv(r_buf, size, MPI_CHAR, 0, 1, MPI_COMM_WORLD, &reqstat));
+                }
 #ifdef _ENABLE_CUDA_KERNEL_
                 if (options.dst == 'M') {
                     touch_managed_dst(r_buf, size);
                 }
 #endif /* #ifdef _ENABLE_CUDA_KERNEL_ */
-                MPI_CHECK(MPI_Send(s_buf, size, MPI_CHAR, 0, 1, MPI_COMM_WORLD));
+                if (options.persistent) {
+                    MPI_CHECK(MPI_Start(send_request));
+                    MPI_CHECK(MPI_Wait(send_request, &reqstat));
+                } else {
+                    MPI_CHECK(MPI_Send(s_buf, size, MPI_CHAR, 0, 1, MPI_COMM_WORLD));
+                }
             }
+            adaptive_check(MPI_COMM_WORLD, i);
+        }
+
+        if (options.persistent) {
+            free_persistent_requests(1, send_request);
+            free_persistent_requests(1, recv_request);
         }
 
+        if (CACHE_HOT != options.cache_state) {
+            t_cold = extra_latency(myid, size, s_buf, r_buf, 0);
+        }
+
+        if (FRESH_NONE != options.fresh_buffers) {
+            t_fresh = extra_latency(myid, size, s_buf, r_buf, 1);
+        }
+
+        reduce_latency_samples(MPI_COMM_WORLD);
+
         if (myid == 0) {
             double latency = (t_total * 1e6) / (2.0 * options.iterations);
 
-            fprintf(stdout, "%-*d%*.*f\n", 10, size, FIELD_WIDTH,
+            fprintf(stdout, "%-*d%*.*f", 10, size, FIELD_WIDTH,
                     FLOAT_PRECISION, latency);
+            if (CACHE_HOT != options.cache_state) {
+                fprintf(stdout, "%*.*f", FIELD_WIDTH, FLOAT_PRECISION, t_cold);
+            }
+            if (FRESH_NONE != options.fresh_buffers) {
+                fprintf(stdout, "%*.*f", FIELD_WIDTH, FLOAT_PRECISION, t_fresh);
+            }
+            omb_result_begin(size, options.iterations);
+            omb_result_metric("latency_us", latency);
+            if (CACHE_HOT != options.cache_state) {
+                omb_result_field("cold_latency_us", t_cold);
+            }
+            if (FRESH_NONE != options.fresh_buffers) {
+                omb_result_field("fresh_latency_us", t_fresh);
+            }
+            print_latency_dist(myid);
+            omb_result_end();
             fflush(stdout);
         }
         if (options.buf_num == MULTIPLE) {
@@ -186,6 +301,8 @@ main (int argc, char *argv[])
     if (options.buf_num == SINGLE) {
         free_memory(s_buf, r_buf, myid);
     }
+    free_latency_samples();
+    free_cache_pool();
 
     MPI_CHECK(MPI_Finalize());
 
@@ -40,6 +40,7 @@ int main(int argc, char *argv[])
 
     MPI_CHECK(MPI_Init(&argc, &argv));
     MPI_CHECK(MPI_Comm_size(MPI_COMM_WORLD, &numprocs));
+    set_num_ranks(numprocs);
     MPI_CHECK(MPI_Comm_rank(MPI_COMM_WORLD, &myid));
 
     if (0 == myid) {
@@ -158,7 +159,7 @@ void communicate(int myid)
         exit(EXIT_FAILURE);
     }
     
-    for (size = options.min_message_size; size <= options.max_message_size; size = (size ? size * 2 : 1)) {
+    for (size = first_message_size(1); size <= options.max_message_size; size = next_message_size(size, 1)) {
         set_buffer_pt2pt(s_buf, myid, options.accel, 'a', size);
         set_buffer_pt2pt(r_buf, myid, options.accel, 'b', size);
 
@@ -190,8 +191,7 @@ void communicate(int myid)
         }
         if (myid == 0) {
             double latency = (t_end - t_start) * 1e6 / (2.0 * options.iterations);
-            fprintf(stdout, "%-*d%*.*f\n", 10, size, FIELD_WIDTH, 
-                    FLOAT_PRECISION, latency);
+            print_result(size, "latency_us", latency);
             fflush(stdout);
         }
     }
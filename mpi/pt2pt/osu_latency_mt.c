@@ -11,18 +11,16 @@
 
 #include <osu_util_mpi.h>
 
-pthread_mutex_t finished_size_mutex;
-pthread_cond_t  finished_size_cond;
-pthread_mutex_t finished_size_sender_mutex;
-pthread_cond_t  finished_size_sender_cond;
-
-pthread_barrier_t sender_barrier;
+/*
+ * The threads of each process meet at a spin barrier before every message
+ * size; thread 0 then synchronizes the two processes with MPI_Barrier.
+ */
+struct spin_barrier thread_barrier;
+MPI_Comm thread_comms[MAX_NUM_THREADS];
+double thread_latency[MAX_NUM_THREADS];
 
 double t_start = 0, t_end = 0;
 
-int finished_size = 0;
-int finished_size_sender = 0;
-
 int num_threads_sender = 1;
 typedef struct thread_tag  {
         int id;
@@ -39,11 +37,6 @@ int main(int argc, char *argv[])
     pthread_t sr_threads[MAX_NUM_THREADS];
     thread_tag_t tags[MAX_NUM_THREADS];
 
-    pthread_mutex_init(&finished_size_mutex, NULL);
-    pthread_cond_init(&finished_size_cond, NULL);
-    pthread_mutex_init(&finished_size_sender_mutex, NULL);
-    pthread_cond_init(&finished_size_sender_cond, NULL);
-
     options.bench = PT2PT;
     options.subtype = LAT_MT;
 
@@ -66,6 +59,7 @@ int main(int argc, char *argv[])
     }
 
     MPI_CHECK(MPI_Comm_size(MPI_COMM_WORLD, &numprocs));
+    set_num_ranks(numprocs);
     MPI_CHECK(MPI_Comm_rank(MPI_COMM_WORLD, &myid));
 
     if (0 == myid) {
@@ -119,9 +113,6 @@ int main(int argc, char *argv[])
      * implementation 
      */
 
-    finished_size = 1;
-    finished_size_sender = 1;
-
     if (provided != MPI_THREAD_MULTIPLE) {
         if (myid == 0) {
             fprintf(stderr,
@@ -138,15 +129,47 @@ int main(int argc, char *argv[])
         num_threads_sender = options.sender_thread;
     }
 
-   
-    pthread_barrier_init(&sender_barrier, NULL, num_threads_sender);
+    if (THREAD_COMM_SHARED != options.thread_comm &&
+            num_threads_sender != options.num_threads) {
+        if (myid == 0) {
+            fprintf(stderr, "--thread-comm tag and dup need as many sender "
+                    "as receiver threads (-t N:N)\n");
+        }
+
+        MPI_CHECK(MPI_Finalize());
 
+        return EXIT_FAILURE;
+    }
+
+    if (THREAD_COMM_DUP == options.thread_comm) {
+        for (i = 0; i < options.num_threads; i++) {
+            MPI_CHECK(MPI_Comm_dup(MPI_COMM_WORLD, &thread_comms[i]));
+        }
+    }
+
+    spin_barrier_init(&thread_barrier, myid == 0 ? num_threads_sender :
+            options.num_threads);
 
     if (myid == 0) {
+        static char const * const comm_modes[] = {"shared", "tag", "dup"};
+
         printf("# Number of Sender threads: %d \n# Number of Receiver threads: %d\n",num_threads_sender,options.num_threads );
+        printf("# Thread communication: %s\n",
+                comm_modes[options.thread_comm]);
+        printf("# Thread pinning: %s\n", !options.pin_threads ? "none" :
+                options.thread_cpus ? options.thread_cpus : "auto");
     
         print_header(myid, LAT_MT);
-        fprintf(stdout, "%-*s%*s\n", 10, "# Size", FIELD_WIDTH, "Latency (us)");
+        fprintf(stdout, "%-*s%*s", 10, "# Size", FIELD_WIDTH, "Latency (us)");
+        if (num_threads_sender > 1) {
+            char name[32];
+
+            for (i = 0; i < num_threads_sender; i++) {
+                snprintf(name, sizeof(name), "Thread %d (us)", i);
+                fprintf(stdout, "%*s", FIELD_WIDTH, name);
+            }
+        }
+        fprintf(stdout, "\n");
         fflush(stdout);
 
         for (i = 0; i < num_threads_sender; i++) {
@@ -167,6 +190,12 @@ int main(int argc, char *argv[])
         }
     }
 
+    if (THREAD_COMM_DUP == options.thread_comm) {
+        for (i = 0; i < options.num_threads; i++) {
+            MPI_CHECK(MPI_Comm_free(&thread_comms[i]));
+        }
+    }
+
     MPI_CHECK(MPI_Finalize());
 
     return EXIT_SUCCESS;
@@ -180,6 +209,8 @@ void * recv_thread(void *arg)
     char * ret = NULL;
     char *s_buf, *r_buf;
     thread_tag_t *thread_id;
+    MPI_Comm comm = MPI_COMM_WORLD;
+    int tag = 1, sense = 0;
 
     thread_id = (thread_tag_t *)arg;
     val = thread_id->id;
@@ -198,24 +229,19 @@ void * recv_thread(void *arg)
         return ret;
     }
 
-    for (size = options.min_message_size, iter = 0; size <= options.max_message_size; size = (size ? size * 2 : 1)) {
-        pthread_mutex_lock(&finished_size_mutex);
-
-        if (finished_size == options.num_threads) {
-            MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
-
-            finished_size = 1;
+    if (options.pin_threads && pin_thread(val) < 0) {
+        fprintf(stderr, "Warning: could not pin thread %d of rank %d\n",
+                val, myid);
+    }
 
-            pthread_mutex_unlock(&finished_size_mutex);
-            pthread_cond_broadcast(&finished_size_cond);
-        }
+    if (THREAD_COMM_SHARED != options.thread_comm) {
+        comm = (THREAD_COMM_DUP == options.thread_comm) ? thread_comms[val] :
+            MPI_COMM_WORLD;
+        tag = (THREAD_COMM_DUP == options.thread_comm) ? 1 : val;
+    }
 
-        else {
-            finished_size++;
-
-            pthread_cond_wait(&finished_size_cond, &finished_size_mutex);
-            pthread_mutex_unlock(&finished_size_mutex);
-        }
+    for (size = first_message_size(1), iter = 0; size <= options.max_message_size; size = next_message_size(size, 1)) {
+        sync_threads(&thread_barrier, MPI_COMM_WORLD, val, &sense);
 
         if (size > LARGE_MESSAGE_SIZE) {
             options.iterations = options.iterations_large;
@@ -226,16 +252,24 @@ void * recv_thread(void *arg)
         set_buffer_pt2pt(s_buf, myid, options.accel, 'a', size);
         set_buffer_pt2pt(r_buf, myid, options.accel, 'b', size);
 
-        for (i = val; i < (options.iterations + options.skip); i += options.num_threads) {
-            if (options.sender_thread>1) {
-                MPI_Recv (r_buf, size, MPI_CHAR, 0, i, MPI_COMM_WORLD,
-                        &reqstat[val]);
-                MPI_Send (s_buf, size, MPI_CHAR, 0, i, MPI_COMM_WORLD);
+        if (THREAD_COMM_SHARED != options.thread_comm) {
+            for (i = 0; i < (options.iterations + options.skip); i++) {
+                MPI_CHECK(MPI_Recv(r_buf, size, MPI_CHAR, 0, tag, comm,
+                        &reqstat[val]));
+                MPI_CHECK(MPI_Send(s_buf, size, MPI_CHAR, 0, tag, comm));
             }
-            else {
-                MPI_Recv (r_buf, size, MPI_CHAR, 0, 1, MPI_COMM_WORLD,
-                        &reqstat[val]);
-                MPI_Send (s_buf, size, MPI_CHAR, 0, 2, MPI_COMM_WORLD);
+        } else {
+            for (i = val; i < (options.iterations + options.skip); i += options.num_threads) {
+                if (options.sender_thread>1) {
+                    MPI_Recv (r_buf, size, MPI_CHAR, 0, i, MPI_COMM_WORLD,
+                            &reqstat[val]);
+                    MPI_Send (s_buf, size, MPI_CHAR, 0, i, MPI_COMM_WORLD);
+                }
+                else {
+                    MPI_Recv (r_buf, size, MPI_CHAR, 0, 1, MPI_COMM_WORLD,
+                            &reqstat[val]);
+                    MPI_Send (s_buf, size, MPI_CHAR, 0, 2, MPI_COMM_WORLD);
+                }
             }
         }
 
@@ -250,13 +284,40 @@ void * recv_thread(void *arg)
 }
 
 
+/* Aggregate latency, then one column per sender thread if there are several */
+static void print_thread_latency (int size, double latency)
+{
+    static char names[MAX_NUM_THREADS][32];
+    int i;
+
+    fprintf(stdout, "%-*d%*.*f", 10, size, FIELD_WIDTH, FLOAT_PRECISION,
+            latency);
+    omb_result_begin(size, options.iterations);
+    omb_result_metric("latency_us", latency);
+
+    if (num_threads_sender > 1) {
+        for (i = 0; i < num_threads_sender; i++) {
+            fprintf(stdout, "%*.*f", FIELD_WIDTH, FLOAT_PRECISION,
+                    thread_latency[i]);
+            snprintf(names[i], sizeof(names[i]), "thread%d_latency_us", i);
+            omb_result_field(names[i], thread_latency[i]);
+        }
+    }
+
+    fprintf(stdout, "\n");
+    omb_result_end();
+    fflush(stdout);
+}
+
 void * send_thread(void *arg)
 {
     int size = 0, i = 0, val = 0, iter = 0;
     int myid = 0;
     char *s_buf, *r_buf;
-    double t = 0, latency = 0;
+    double t = 0, latency = 0, t_thread = 0;
     thread_tag_t *thread_id = (thread_tag_t *)arg;
+    MPI_Comm comm = MPI_COMM_WORLD;
+    int tag = 1, sense = 0, count = 0;
     char *ret = NULL;
 
     val = thread_id->id;
@@ -275,22 +336,19 @@ void * send_thread(void *arg)
         return ret;
     }
 
-    for (size = options.min_message_size, iter = 0; size <= options.max_message_size; size = (size ? size * 2 : 1)) {
-        pthread_mutex_lock(&finished_size_sender_mutex);
-        
-        if (finished_size_sender == num_threads_sender) {
-            MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
-        
-            finished_size_sender = 1;
-
-            pthread_mutex_unlock(&finished_size_sender_mutex);
-            pthread_cond_broadcast(&finished_size_sender_cond);
-        } else {  
-            finished_size_sender++;
-
-            pthread_cond_wait(&finished_size_sender_cond, &finished_size_sender_mutex);
-            pthread_mutex_unlock(&finished_size_sender_mutex);
-        }
+    if (options.pin_threads && pin_thread(val) < 0) {
+        fprintf(stderr, "Warning: could not pin thread %d of rank %d\n",
+                val, myid);
+    }
+
+    if (THREAD_COMM_SHARED != options.thread_comm) {
+        comm = (THREAD_COMM_DUP == options.thread_comm) ? thread_comms[val] :
+            MPI_COMM_WORLD;
+        tag = (THREAD_COMM_DUP == options.thread_comm) ? 1 : val;
+    }
+
+    for (size = first_message_size(1), iter = 0; size <= options.max_message_size; size = next_message_size(size, 1)) {
+        sync_threads(&thread_barrier, MPI_COMM_WORLD, val, &sense);
 
         if (size > LARGE_MESSAGE_SIZE) {
             options.iterations = options.iterations_large;
@@ -302,32 +360,60 @@ void * send_thread(void *arg)
         set_buffer_pt2pt(r_buf, myid, options.accel, 'b', size);
 
         int flag_print=0;
-        for (i = val; i < options.iterations + options.skip; i+=num_threads_sender) {
-            if (i == options.skip) {
-                t_start = MPI_Wtime();
-                flag_print =1;
+        if (THREAD_COMM_SHARED != options.thread_comm) {
+            for (i = 0; i < options.iterations + options.skip; i++) {
+                if (i == options.skip) {
+                    t_thread = MPI_Wtime();
+                }
+
+                MPI_CHECK(MPI_Send(s_buf, size, MPI_CHAR, 1, tag, comm));
+                MPI_CHECK(MPI_Recv(r_buf, size, MPI_CHAR, 1, tag, comm,
+                        &reqstat[val]));
             }
 
-            if (options.sender_thread>1) {     
-                MPI_CHECK(MPI_Send(s_buf, size, MPI_CHAR, 1, i, MPI_COMM_WORLD));
-                MPI_CHECK(MPI_Recv(r_buf, size, MPI_CHAR, 1, i, MPI_COMM_WORLD,
-                        &reqstat[val]));
-            } else {
-                MPI_CHECK(MPI_Send(s_buf, size, MPI_CHAR, 1, 1, MPI_COMM_WORLD));
-                MPI_CHECK(MPI_Recv(r_buf, size, MPI_CHAR, 1, 2, MPI_COMM_WORLD,
-                        &reqstat[val]));
+            thread_latency[val] = (MPI_Wtime() - t_thread) * 1.0e6 /
+                (2.0 * options.iterations);
+            flag_print = (0 == val);
+        } else {
+            count = 0;
+            for (i = val; i < options.iterations + options.skip; i+=num_threads_sender) {
+                if (i == options.skip) {
+                    t_start = MPI_Wtime();
+                    flag_print =1;
+                }
+                if (i >= options.skip && 0 == count) {
+                    t_thread = MPI_Wtime();
+                }
+
+                if (options.sender_thread>1) {     
+                    MPI_CHECK(MPI_Send(s_buf, size, MPI_CHAR, 1, i, MPI_COMM_WORLD));
+                    MPI_CHECK(MPI_Recv(r_buf, size, MPI_CHAR, 1, i, MPI_COMM_WORLD,
+                            &reqstat[val]));
+                } else {
+                    MPI_CHECK(MPI_Send(s_buf, size, MPI_CHAR, 1, 1, MPI_COMM_WORLD));
+                    MPI_CHECK(MPI_Recv(r_buf, size, MPI_CHAR, 1, 2, MPI_COMM_WORLD,
+                            &reqstat[val]));
+                }
+                count += i >= options.skip;
             }
+
+            thread_latency[val] = count ? (MPI_Wtime() - t_thread) * 1.0e6 /
+                (2.0 * count) : 0.0;
         }
 
-        pthread_barrier_wait(&sender_barrier);
+        spin_barrier_wait(&thread_barrier, &sense);
         if (flag_print==1) {
-            t_end = MPI_Wtime ();
-            t = t_end - t_start;
+            if (THREAD_COMM_SHARED != options.thread_comm) {
+                for (i = 0, latency = 0; i < num_threads_sender; i++) {
+                    latency += thread_latency[i] / num_threads_sender;
+                }
+            } else {
+                t_end = MPI_Wtime ();
+                t = t_end - t_start;
 
-            latency = (t) * 1.0e6 / (2.0 * options.iterations / num_threads_sender);
-            fprintf(stdout, "%-*d%*.*f\n", 10, size, FIELD_WIDTH, FLOAT_PRECISION,
-                    latency);
-            fflush(stdout);
+                latency = (t) * 1.0e6 / (2.0 * options.iterations / num_threads_sender);
+            }
+            print_thread_latency(size, latency);
         }
         iter++;
     }
@@ -0,0 +1,265 @@
+#define BENCHMARK "OSU MPI%s Message Matching Latency Test"
+/*
+ * Copyright (C) 2002-2021 the Network-Based Computing Laboratory
+ * (NBCL), The Ohio State University.
+ *
+ * Contact: Dr. D. K. Panda (panda@cse.ohio-state.edu)
+ *
+ * For detailed copyright and licensing information, please refer to the
+ * copyright file COPYRIGHT in the top level OMB directory.
+ */
+
+#include <osu_util_mpi.h>
+
+/*
+ * Ping-pong of MESSAGE_SIZE bytes while each rank's posted receive queue or
+ * unexpected message queue holds DEPTH entries that never match, so every
+ * message has to be matched past them. The entries are receives posted
+ * before the ping-pong, or zero-byte messages sent before it. Depths of 0,
+ * 1, 2, 4, ... options.match_depth are timed for each wildcard:
+ *
+ *   none    ping-pong receives name the peer and tag; the entries use
+ *           another tag
+ *   source  the ping-pong receives and posted entries use MPI_ANY_SOURCE;
+ *           the entries use another tag
+ *   tag     the ping-pong receives use MPI_ANY_TAG; the posted entries name
+ *           the peer and another tag. Only the posted queue is timed, as a
+ *           receive for any tag from the peer would match the unexpected
+ *           messages of the peer.
+ */
+#define MESSAGE_SIZE 8
+#define PING_TAG 1
+#define QUEUE_TAG 2
+
+enum match_queue {
+    QUEUE_POSTED,
+    QUEUE_UNEXPECTED
+};
+
+static char const * wildcard_info[MATCH_NUM_WILDCARDS] = {
+    "exact source and tag",
+    "MPI_ANY_SOURCE",
+    "MPI_ANY_TAG"
+};
+
+static char *s_buf, *r_buf, q_buf[1];
+static MPI_Request *queue;
+
+static void fill_queue (int myid, int depth, enum match_wildcard wildcard,
+        enum match_queue type)
+{
+    int i, peer = 1 - myid;
+
+    for (i = 0; i < depth; i++) {
+        if (QUEUE_POSTED == type) {
+            MPI_CHECK(MPI_Irecv(q_buf, 0, MPI_CHAR,
+                    MATCH_ANY_SOURCE == wildcard ? MPI_ANY_SOURCE : peer,
+                    QUEUE_TAG, MPI_COMM_WORLD, queue + i));
+        } else {
+            MPI_CHECK(MPI_Isend(q_buf, 0, MPI_CHAR, peer, QUEUE_TAG,
+                    MPI_COMM_WORLD, queue + i));
+        }
+    }
+}
+
+static void drain_queue (int myid, int depth, enum match_queue type)
+{
+    int i, peer = 1 - myid;
+
+    for (i = 0; i < depth; i++) {
+        if (QUEUE_POSTED == type) {
+            MPI_CHECK(MPI_Cancel(queue + i));
+        } else {
+            MPI_CHECK(MPI_Recv(q_buf, 0, MPI_CHAR, peer, QUEUE_TAG,
+                    MPI_COMM_WORLD, MPI_STATUS_IGNORE));
+        }
+    }
+
+    MPI_CHECK(MPI_Waitall(depth, queue, MPI_STATUSES_IGNORE));
+
+    /* the peer's next entries must not meet receives not yet cancelled */
+    MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
+}
+
+static double match_latency (int myid, int depth, enum match_wildcard wildcard,
+        enum match_queue type)
+{
+    int i, peer = 1 - myid;
+    int source = MATCH_ANY_SOURCE == wildcard ? MPI_ANY_SOURCE : peer;
+    int tag = MATCH_ANY_TAG == wildcard ? MPI_ANY_TAG : PING_TAG;
+    double t_start = 0.0, t_end = 0.0;
+
+    fill_queue(myid, depth, wildcard, type);
+    MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
+
+    for (i = 0; i < options.iterations + options.skip; i++) {
+        if (i == options.skip) {
+            t_start = MPI_Wtime();
+        }
+
+        if (0 == myid) {
+            MPI_CHECK(MPI_Send(s_buf, MESSAGE_SIZE, MPI_CHAR, peer, PING_TAG,
+                    MPI_COMM_WORLD));
+            MPI_CHECK(MPI_Recv(r_buf, MESSAGE_SIZE, MPI_CHAR, source, tag,
+                    MPI_COMM_WORLD, MPI_STATUS_IGNORE));
+        } else {
+            MPI_CHECK(MPI_Recv(r_buf, MESSAGE_SIZE, MPI_CHAR, source, tag,
+                    MPI_COMM_WORLD, MPI_STATUS_IGNORE));
+            MPI_CHECK(MPI_Send(s_buf, MESSAGE_SIZE, MPI_CHAR, peer, PING_TAG,
+                    MPI_COMM_WORLD));
+        }
+    }
+
+    t_end = MPI_Wtime();
+
+    drain_queue(myid, depth, type);
+
+    return (t_end - t_start) * 1e6 / (2.0 * options.iterations);
+}
+
+static void run_depth (int myid, int depth, enum match_wildcard wildcard)
+{
+    double lat_posted, lat_unexpected = 0.0;
+
+    lat_posted = match_latency(myid, depth, wildcard, QUEUE_POSTED);
+    if (MATCH_ANY_TAG != wildcard) {
+        lat_unexpected = match_latency(myid, depth, wildcard,
+                QUEUE_UNEXPECTED);
+    }
+
+    if (0 == myid) {
+        fprintf(stdout, "%-*d%*.*f", 10, depth, FIELD_WIDTH, FLOAT_PRECISION,
+                lat_posted);
+        if (MATCH_ANY_TAG != wildcard) {
+            fprintf(stdout, "%*.*f", FIELD_WIDTH, FLOAT_PRECISION,
+                    lat_unexpected);
+        }
+        fprintf(stdout, "\n");
+        omb_result_begin(depth, options.iterations);
+        omb_result_field("posted_latency_us", lat_posted);
+        if (MATCH_ANY_TAG != wildcard) {
+            omb_result_field("unexpected_latency_us", lat_unexpected);
+        }
+        omb_result_end();
+        fflush(stdout);
+    }
+}
+
+static void run_wildcard (int myid, enum match_wildcard wildcard)
+{
+    char name[64];
+    int depth;
+
+    snprintf(name, sizeof(name), "osu_match_latency_%s",
+            wildcard_names[wildcard]);
+    set_benchmark_name(name);
+
+    if (0 == myid) {
+        fprintf(stdout, "\n# Matching: %s\n", wildcard_info[wildcard]);
+        fprintf(stdout, "%-*s%*s", 10, "# Depth", FIELD_WIDTH,
+                "Posted (us)");
+        if (MATCH_ANY_TAG != wildcard) {
+            fprintf(stdout, "%*s", FIELD_WIDTH, "Unexpected (us)");
+        }
+        fprintf(stdout, "\n");
+        fflush(stdout);
+    }
+
+    run_depth(myid, 0, wildcard);
+    for (depth = 1; depth < options.match_depth; depth *= 2) {
+        run_depth(myid, depth, wildcard);
+    }
+    run_depth(myid, options.match_depth, wildcard);
+}
+
+int main (int argc, char *argv[])
+{
+    int myid, numprocs, w;
+    int po_ret;
+
+    options.bench = PT2PT;
+    options.subtype = LAT_MATCH;
+
+    set_header(HEADER);
+    set_benchmark_name("osu_match_latency");
+
+    po_ret = process_options(argc, argv);
+    options.show_size = 0;
+
+    MPI_CHECK(MPI_Init(&argc, &argv));
+    MPI_CHECK(MPI_Comm_size(MPI_COMM_WORLD, &numprocs));
+    set_num_ranks(numprocs);
+    MPI_CHECK(MPI_Comm_rank(MPI_COMM_WORLD, &myid));
+
+    if (0 == myid) {
+        switch (po_ret) {
+            case PO_BAD_USAGE:
+                print_bad_usage_message(myid);
+                break;
+            case PO_HELP_MESSAGE:
+                print_help_message(myid);
+                break;
+            case PO_VERSION_MESSAGE:
+                print_version_message(myid);
+                MPI_CHECK(MPI_Finalize());
+                exit(EXIT_SUCCESS);
+            case PO_OKAY:
+                break;
+        }
+    }
+
+    switch (po_ret) {
+        case PO_CUDA_NOT_AVAIL:
+        case PO_OPENACC_NOT_AVAIL:
+        case PO_BAD_USAGE:
+            MPI_CHECK(MPI_Finalize());
+            exit(EXIT_FAILURE);
+        case PO_HELP_MESSAGE:
+        case PO_VERSION_MESSAGE:
+            MPI_CHECK(MPI_Finalize());
+            exit(EXIT_SUCCESS);
+        case PO_OKAY:
+            break;
+    }
+
+    if (numprocs != 2) {
+        if (myid == 0) {
+            fprintf(stderr, "This test requires exactly two processes\n");
+        }
+
+        MPI_CHECK(MPI_Finalize());
+        exit(EXIT_FAILURE);
+    }
+
+    queue = malloc(options.match_depth * sizeof(MPI_Request));
+    if (NULL == queue ||
+            allocate_host_buffer((void **)&s_buf, MESSAGE_SIZE) ||
+            allocate_host_buffer((void **)&r_buf, MESSAGE_SIZE)) {
+        fprintf(stderr, "Could Not Allocate Memory [rank %d]\n", myid);
+        MPI_CHECK(MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE));
+    }
+    memset(s_buf, 'a', MESSAGE_SIZE);
+    memset(r_buf, 'b', MESSAGE_SIZE);
+
+    print_header(myid, LAT_MATCH);
+    if (0 == myid) {
+        fprintf(stdout, "# Message size: %d bytes\n", MESSAGE_SIZE);
+        fflush(stdout);
+    }
+
+    for (w = 0; w < MATCH_NUM_WILDCARDS; w++) {
+        if (options.wildcards & (1 << w)) {
+            run_wildcard(myid, w);
+        }
+    }
+
+    free(queue);
+    free_host_buffer(s_buf);
+    free_host_buffer(r_buf);
+
+    MPI_CHECK(MPI_Finalize());
+
+    return EXIT_SUCCESS;
+}
+
+/* vi: set sw=4 sts=4 tw=80: */
@@ -44,10 +44,13 @@ int main(int argc, char *argv[])
 
     options.bench = MBW_MR;
     options.subtype = BW;
+    options.features = FEATURE_PAIRING;
+    set_benchmark_name("osu_mbw_mr");
     
     MPI_CHECK(MPI_Init(&argc, &argv));
 
     MPI_CHECK(MPI_Comm_size(MPI_COMM_WORLD, &numprocs));
+    set_num_ranks(numprocs);
     MPI_CHECK(MPI_Comm_rank(MPI_COMM_WORLD, &rank));
 
     options.pairs            = numprocs / 2;
@@ -114,6 +117,11 @@ int main(int argc, char *argv[])
         return EXIT_FAILURE;
     }
 
+    if ((options.pairs = init_pairing(rank, numprocs, options.pairs)) < 0) {
+        MPI_CHECK(MPI_Finalize());
+        exit(EXIT_FAILURE);
+    }
+
 #ifdef _ENABLE_CUDA_KERNEL_
     if (options.src == 'M' || options.dst == 'M') {
         if (options.buf_num == SINGLE) {
@@ -136,6 +144,7 @@ int main(int argc, char *argv[])
     if (rank == 0) {
         fprintf(stdout, HEADER);
         print_header(rank, BW);
+        print_pairing(rank);
 
         if (options.window_varied) {
             fprintf(stdout, "# [ pairs: %d ] [ window size: varied ]\n", options.pairs);
@@ -164,7 +173,7 @@ int main(int argc, char *argv[])
    if (options.window_varied) {
        int window_array[] = WINDOW_SIZES;
        double ** bandwidth_results;
-       int log_val = 1, tmp_message_size = options.max_message_size;
+       int log_val = 0, tmp_message_size;
        int i, j;
 
        for (i = 0; i < WINDOW_SIZES_COUNT; i++) {
@@ -176,7 +185,9 @@ int main(int argc, char *argv[])
        mbw_request = (MPI_Request *) malloc(sizeof(MPI_Request) * options.window_size);
        mbw_reqstat = (MPI_Status *) malloc(sizeof(MPI_Status) * options.window_size);
 
-       while(tmp_message_size >>= 1) {
+       for (tmp_message_size = first_message_size(1);
+               tmp_message_size <= options.max_message_size;
+               tmp_message_size = next_message_size(tmp_message_size, 1)) {
            log_val++;
        }
 
@@ -198,7 +209,7 @@ int main(int argc, char *argv[])
            fflush(stdout);
        }
     
-       for (j = 0, curr_size = options.min_message_size; curr_size <= options.max_message_size; curr_size *= 2, j++) {
+       for (j = 0, curr_size = first_message_size(1); curr_size <= options.max_message_size; curr_size = next_message_size(curr_size, 1), j++) {
            if (rank == 0) {
                fprintf(stdout, "%-7d", curr_size);
            }
@@ -239,7 +250,7 @@ int main(int argc, char *argv[])
             fprintf(stdout, "\n");
             fflush(stdout);
 
-            for (c = 0, curr_size = options.min_message_size; curr_size <= options.max_message_size; curr_size *= 2) {
+            for (c = 0, curr_size = first_message_size(1); curr_size <= options.max_message_size; curr_size = next_message_size(curr_size, 1)) {
                 fprintf(stdout, "%-7d", curr_size); 
 
                 for (i = 0; i < WINDOW_SIZES_COUNT; i++) {
@@ -265,7 +276,7 @@ int main(int argc, char *argv[])
        mbw_request = (MPI_Request *)malloc(sizeof(MPI_Request) * options.window_size);
        mbw_reqstat = (MPI_Status *)malloc(sizeof(MPI_Status) * options.window_size);
 
-       for (curr_size = options.min_message_size; curr_size <= options.max_message_size; curr_size *= 2) {
+       for (curr_size = first_message_size(1); curr_size <= options.max_message_size; curr_size = next_message_size(curr_size, 1)) {
            double bw, rate;
 
            bw = calc_bw(rank, curr_size, options.pairs, options.window_size, s_buf, r_buf);
@@ -283,6 +294,11 @@ int main(int argc, char *argv[])
                    fprintf(stdout, "%-*d%*.*f\n", 10, curr_size, FIELD_WIDTH,
                            FLOAT_PRECISION, bw);
                }
+
+               omb_result_begin(curr_size, options.iterations);
+               omb_result_metric("bandwidth_mbps", bw);
+               omb_result_field("messages_per_sec", rate);
+               omb_result_end();
            } 
        }
        if (options.buf_num == MULTIPLE) {
@@ -311,7 +327,7 @@ int main(int argc, char *argv[])
 double calc_bw(int rank, int size, int num_pairs, int window_size, char **s_buf,
         char **r_buf)
 {
-    double t_start = 0, t_end = 0, t = 0, bw = 0, t_lo = 0.0;
+    double t_start = 0, t_end = 0, t = 0, t_max = 0, bw = 0, t_lo = 0.0;
     int i, j, target;
 
     if (options.buf_num == SINGLE) {
@@ -342,10 +358,10 @@ double calc_bw(int rank, int size, int num_pairs, int window_size, char **s_buf,
 
     MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
 
-    for (i = 0; i <  options.iterations +  options.skip; i++) {
-        if (rank < num_pairs) {
-            target = rank + num_pairs;
+    target = pair_partner();
 
+    for (i = 0; i <  options.iterations +  options.skip; i++) {
+        if (pair_initiator()) {
             if (i >= options.skip) {
                 t_start = MPI_Wtime();
             }
@@ -378,9 +394,7 @@ double calc_bw(int rank, int size, int num_pairs, int window_size, char **s_buf,
                 t_end = MPI_Wtime();
                 t += calculate_total(t_start, t_end, t_lo, window_size);
             }
-        } else if (rank < num_pairs * 2) {
-            target = rank - num_pairs;
-
+        } else if (target >= 0) {
 #ifdef _ENABLE_CUDA_KERNEL_
             if (options.dst == 'M') {
                 touch_managed_dst(s_buf, size, window_size);
@@ -405,8 +419,6 @@ double calc_bw(int rank, int size, int num_pairs, int window_size, char **s_buf,
 #endif /* #ifdef _ENABLE_CUDA_KERNEL_ */
 
             MPI_CHECK(MPI_Send(s_buf[0], 4, MPI_CHAR, target, 101, MPI_COMM_WORLD));
-        } else {
-            MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
         }
     }
     if (options.buf_num == MULTIPLE) {
@@ -415,11 +427,14 @@ double calc_bw(int rank, int size, int num_pairs, int window_size, char **s_buf,
         }
     }
 
+    MPI_CHECK(MPI_Reduce(&t, &t_max, 1, MPI_DOUBLE, MPI_MAX, 0,
+                MPI_COMM_WORLD));
+
     if (rank == 0) {
         double tmp = size / 1e6 * num_pairs ;
         
         tmp = tmp *  options.iterations * window_size;
-        bw = tmp / t;
+        bw = tmp / t_max;
 
         return bw;
     }
@@ -0,0 +1,387 @@
+#define BENCHMARK "OSU MPI%s Multi-threaded Bandwidth / Message Rate Test"
+/*
+ * Copyright (C) 2002-2021 the Network-Based Computing Laboratory
+ * (NBCL), The Ohio State University.
+ *
+ * Contact: Dr. D. K. Panda (panda@cse.ohio-state.edu)
+ *
+ * For detailed copyright and licensing information, please refer to the
+ * copyright file COPYRIGHT in the top level OMB directory.
+ */
+
+#include <osu_util_mpi.h>
+
+/*
+ * Thread i of rank 0 streams windows of MPI_Isend to thread i of rank 1,
+ * which answers each window with a short acknowledgement on tag
+ * MAX_NUM_THREADS + i. The aggregate message rate is the number of messages
+ * sent by all threads divided by the time of the slowest thread.
+ */
+struct spin_barrier thread_barrier;
+MPI_Comm thread_comms[MAX_NUM_THREADS];
+double thread_time[MAX_NUM_THREADS];
+int num_threads = DEF_NUM_THREADS;
+
+typedef struct thread_tag  {
+        int id;
+} thread_tag_t;
+
+void * send_thread(void *arg);
+void * recv_thread(void *arg);
+
+/*
+ * Threads communicate on a duplicate of MPI_COMM_WORLD, their own one in dup
+ * mode, so that --comm-hints can attach the MPI-4 assertions to it.
+ */
+static void create_thread_comms (int count)
+{
+    int i;
+#if MPI_VERSION >= 3
+    MPI_Info info;
+
+    if (options.comm_hints) {
+        MPI_CHECK(MPI_Info_create(&info));
+        MPI_CHECK(MPI_Info_set(info, "mpi_assert_allow_overtaking", "true"));
+        MPI_CHECK(MPI_Info_set(info, "mpi_assert_no_any_tag", "true"));
+
+        for (i = 0; i < count; i++) {
+            MPI_CHECK(MPI_Comm_dup_with_info(MPI_COMM_WORLD, info,
+                    &thread_comms[i]));
+        }
+
+        MPI_CHECK(MPI_Info_free(&info));
+        return;
+    }
+#endif
+
+    for (i = 0; i < count; i++) {
+        MPI_CHECK(MPI_Comm_dup(MPI_COMM_WORLD, &thread_comms[i]));
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int numprocs = 0, provided = 0, myid = 0, err = 0;
+    int i = 0, comm_count = 0;
+    int po_ret = 0;
+    pthread_t sr_threads[MAX_NUM_THREADS];
+    thread_tag_t tags[MAX_NUM_THREADS];
+
+    options.bench = PT2PT;
+    options.subtype = BW_MT;
+
+    set_header(HEADER);
+    set_benchmark_name("osu_mbw_mr_mt");
+
+    po_ret = process_options(argc, argv);
+
+    err = MPI_Init_thread(&argc, &argv, MPI_THREAD_MULTIPLE, &provided);
+
+    if (err != MPI_SUCCESS) {
+        MPI_CHECK(MPI_Abort(MPI_COMM_WORLD, 1));
+    }
+
+    MPI_CHECK(MPI_Comm_size(MPI_COMM_WORLD, &numprocs));
+    set_num_ranks(numprocs);
+    MPI_CHECK(MPI_Comm_rank(MPI_COMM_WORLD, &myid));
+
+    if (0 == myid) {
+        switch (po_ret) {
+            case PO_HELP_MESSAGE:
+                print_help_message(myid);
+                break;
+            case PO_BAD_USAGE:
+                print_bad_usage_message(myid);
+                break;
+            case PO_VERSION_MESSAGE:
+                print_version_message(myid);
+                MPI_CHECK(MPI_Finalize());
+                exit(EXIT_SUCCESS);
+            case PO_OKAY:
+                break;
+        }
+    }
+
+    switch (po_ret) {
+        case PO_CUDA_NOT_AVAIL:
+        case PO_OPENACC_NOT_AVAIL:
+        case PO_BAD_USAGE:
+            MPI_CHECK(MPI_Finalize());
+            exit(EXIT_FAILURE);
+        case PO_HELP_MESSAGE:
+        case PO_VERSION_MESSAGE:
+            MPI_CHECK(MPI_Finalize());
+            exit(EXIT_SUCCESS);
+        case PO_OKAY:
+            break;
+    }
+
+    if (numprocs != 2) {
+        if (myid == 0) {
+            fprintf(stderr, "This test requires exactly two processes\n");
+        }
+
+        MPI_CHECK(MPI_Finalize());
+
+        return EXIT_FAILURE;
+    }
+
+    if (provided != MPI_THREAD_MULTIPLE) {
+        if (myid == 0) {
+            fprintf(stderr,
+                "MPI_Init_thread must return MPI_THREAD_MULTIPLE!\n");
+        }
+
+        MPI_CHECK(MPI_Finalize());
+
+        return EXIT_FAILURE;
+    }
+
+    num_threads = options.num_threads;
+
+    if (options.sender_thread != -1 &&
+            options.sender_thread != options.num_threads) {
+        if (myid == 0) {
+            fprintf(stderr, "This test needs as many sender as receiver "
+                    "threads (-t N or -t N:N)\n");
+        }
+
+        MPI_CHECK(MPI_Finalize());
+
+        return EXIT_FAILURE;
+    }
+
+#if MPI_VERSION < 3
+    if (options.comm_hints && myid == 0) {
+        fprintf(stderr, "Warning: --comm-hints needs MPI_Comm_dup_with_info, "
+                "ignoring it\n");
+    }
+    options.comm_hints = 0;
+#endif
+
+    comm_count = THREAD_COMM_DUP == options.thread_comm ? num_threads : 1;
+    create_thread_comms(comm_count);
+    spin_barrier_init(&thread_barrier, num_threads);
+
+    if (myid == 0) {
+        static char const * const comm_modes[] = {"shared", "tag", "dup"};
+
+        print_header(myid, BW_MT);
+        printf("# Number of threads: %d\n", num_threads);
+        printf("# Thread communication: %s\n",
+                comm_modes[options.thread_comm]);
+        printf("# Thread pinning: %s\n", !options.pin_threads ? "none" :
+                options.thread_cpus ? options.thread_cpus : "auto");
+        printf("# Communicator hints: %s\n", options.comm_hints ?
+                "mpi_assert_allow_overtaking, mpi_assert_no_any_tag" : "none");
+        printf("# [ threads: %d ] [ window size: %d ]\n", num_threads,
+                options.window_size);
+
+        fprintf(stdout, "%-*s%*s%*s", 10, "# Size", FIELD_WIDTH, "MB/s",
+                FIELD_WIDTH, "Messages/s");
+        if (num_threads > 1) {
+            char name[32];
+
+            for (i = 0; i < num_threads; i++) {
+                snprintf(name, sizeof(name), "Thread %d (msg/s)", i);
+                fprintf(stdout, "%*s", FIELD_WIDTH, name);
+            }
+        }
+        fprintf(stdout, "\n");
+        fflush(stdout);
+    }
+
+    for (i = 0; i < num_threads; i++) {
+        tags[i].id = i;
+        pthread_create(&sr_threads[i], NULL,
+                myid == 0 ? send_thread : recv_thread, &tags[i]);
+    }
+
+    for (i = 0; i < num_threads; i++) {
+        pthread_join(sr_threads[i], NULL);
+    }
+
+    for (i = 0; i < comm_count; i++) {
+        MPI_CHECK(MPI_Comm_free(&thread_comms[i]));
+    }
+
+    MPI_CHECK(MPI_Finalize());
+
+    return EXIT_SUCCESS;
+}
+
+/* Aggregate bandwidth and message rate, then the rate of each thread */
+static void print_thread_rate (int size, int iterations)
+{
+    static char names[MAX_NUM_THREADS][32];
+    double messages = (double)options.window_size * iterations;
+    double t_max = 0, rate = 0, bw = 0;
+    int i;
+
+    for (i = 0; i < num_threads; i++) {
+        t_max = thread_time[i] > t_max ? thread_time[i] : t_max;
+    }
+
+    rate = t_max > 0 ? messages * num_threads / t_max : 0.0;
+    bw = rate * size / 1e6;
+
+    fprintf(stdout, "%-*d%*.*f%*.*f", 10, size, FIELD_WIDTH, FLOAT_PRECISION,
+            bw, FIELD_WIDTH, FLOAT_PRECISION, rate);
+    omb_result_begin(size, iterations);
+    omb_result_metric("bandwidth_mbps", bw);
+    omb_result_field("messages_per_sec", rate);
+
+    if (num_threads > 1) {
+        for (i = 0; i < num_threads; i++) {
+            rate = thread_time[i] > 0 ? messages / thread_time[i] : 0.0;
+            fprintf(stdout, "%*.*f", FIELD_WIDTH, FLOAT_PRECISION, rate);
+            snprintf(names[i], sizeof(names[i]), "thread%d_messages_per_sec",
+                    i);
+            omb_result_field(names[i], rate);
+        }
+    }
+
+    fprintf(stdout, "\n");
+    omb_result_end();
+    fflush(stdout);
+}
+
+/*
+ * Communicator and tags of the stream between the two threads with index val.
+ * Every stream has its own data tag, so a receiver thread only matches the
+ * windows of its own sender even when the threads share a communicator.
+ */
+static MPI_Comm thread_stream (int val, int * data_tag, int * ack_tag)
+{
+    *data_tag = val;
+    *ack_tag = MAX_NUM_THREADS + val;
+
+    return thread_comms[THREAD_COMM_DUP == options.thread_comm ? val : 0];
+}
+
+void * recv_thread(void *arg)
+{
+    int size = 0, i = 0, j = 0, val = 0;
+    int iterations = options.iterations, skip = options.skip;
+    int myid = 0, data_tag = 0, ack_tag = 0, sense = 0;
+    char *s_buf, *r_buf;
+    MPI_Request *req;
+    MPI_Comm comm;
+
+    val = ((thread_tag_t *)arg)->id;
+
+    MPI_CHECK(MPI_Comm_rank(MPI_COMM_WORLD, &myid));
+
+    req = malloc(sizeof(MPI_Request) * options.window_size);
+    if (NULL == req || allocate_memory_pt2pt(&s_buf, &r_buf, myid)) {
+        fprintf(stderr, "Error allocating memory on Rank %d, thread ID %d\n",
+                myid, val);
+        MPI_CHECK(MPI_Abort(MPI_COMM_WORLD, 1));
+    }
+
+    if (options.pin_threads && pin_thread(val) < 0) {
+        fprintf(stderr, "Warning: could not pin thread %d of rank %d\n",
+                val, myid);
+    }
+
+    comm = thread_stream(val, &data_tag, &ack_tag);
+
+    for (size = first_message_size(1); size <= options.max_message_size;
+            size = next_message_size(size, 1)) {
+        sync_threads(&thread_barrier, MPI_COMM_WORLD, val, &sense);
+
+        if (size > LARGE_MESSAGE_SIZE) {
+            iterations = options.iterations_large;
+            skip = options.skip_large;
+        }
+
+        set_buffer_pt2pt(s_buf, myid, options.accel, 'a', size);
+        set_buffer_pt2pt(r_buf, myid, options.accel, 'b', size);
+
+        for (i = 0; i < iterations + skip; i++) {
+            for (j = 0; j < options.window_size; j++) {
+                MPI_CHECK(MPI_Irecv(r_buf, size, MPI_CHAR, 0, data_tag, comm,
+                        &req[j]));
+            }
+            MPI_CHECK(MPI_Waitall(options.window_size, req,
+                    MPI_STATUSES_IGNORE));
+            MPI_CHECK(MPI_Send(s_buf, 4, MPI_CHAR, 0, ack_tag, comm));
+        }
+    }
+
+    free_memory(s_buf, r_buf, myid);
+    free(req);
+
+    return 0;
+}
+
+void * send_thread(void *arg)
+{
+    int size = 0, i = 0, j = 0, val = 0;
+    int iterations = options.iterations, skip = options.skip;
+    int myid = 0, data_tag = 0, ack_tag = 0, sense = 0;
+    char *s_buf, *r_buf;
+    double t_start = 0;
+    MPI_Request *req;
+    MPI_Comm comm;
+
+    val = ((thread_tag_t *)arg)->id;
+
+    MPI_CHECK(MPI_Comm_rank(MPI_COMM_WORLD, &myid));
+
+    req = malloc(sizeof(MPI_Request) * options.window_size);
+    if (NULL == req || allocate_memory_pt2pt(&s_buf, &r_buf, myid)) {
+        fprintf(stderr, "Error allocating memory on Rank %d, thread ID %d\n",
+                myid, val);
+        MPI_CHECK(MPI_Abort(MPI_COMM_WORLD, 1));
+    }
+
+    if (options.pin_threads && pin_thread(val) < 0) {
+        fprintf(stderr, "Warning: could not pin thread %d of rank %d\n",
+                val, myid);
+    }
+
+    comm = thread_stream(val, &data_tag, &ack_tag);
+
+    for (size = first_message_size(1); size <= options.max_message_size;
+            size = next_message_size(size, 1)) {
+        sync_threads(&thread_barrier, MPI_COMM_WORLD, val, &sense);
+
+        if (size > LARGE_MESSAGE_SIZE) {
+            iterations = options.iterations_large;
+            skip = options.skip_large;
+        }
+
+        set_buffer_pt2pt(s_buf, myid, options.accel, 'a', size);
+        set_buffer_pt2pt(r_buf, myid, options.accel, 'b', size);
+
+        for (i = 0; i < iterations + skip; i++) {
+            if (i == skip) {
+                t_start = MPI_Wtime();
+            }
+
+            for (j = 0; j < options.window_size; j++) {
+                MPI_CHECK(MPI_Isend(s_buf, size, MPI_CHAR, 1, data_tag, comm,
+                        &req[j]));
+            }
+            MPI_CHECK(MPI_Waitall(options.window_size, req,
+                    MPI_STATUSES_IGNORE));
+            MPI_CHECK(MPI_Recv(r_buf, 4, MPI_CHAR, 1, ack_tag, comm,
+                    MPI_STATUS_IGNORE));
+        }
+
+        thread_time[val] = MPI_Wtime() - t_start;
+
+        spin_barrier_wait(&thread_barrier, &sense);
+        if (0 == val) {
+            print_thread_rate(size, iterations);
+        }
+    }
+
+    free_memory(s_buf, r_buf, myid);
+    free(req);
+
+    return 0;
+}
+
+/* vi: set sw=4 sts=4 tw=80: */
@@ -30,6 +30,7 @@ int main(int argc, char* argv[])
     int po_ret = 0;
     options.bench = PT2PT;
     options.subtype = LAT;
+    options.features = FEATURE_PAIRING;
 
     set_header(HEADER);
     set_benchmark_name("osu_multi_lat");
@@ -46,8 +47,7 @@ int main(int argc, char* argv[])
 
     MPI_CHECK(MPI_Comm_rank(MPI_COMM_WORLD, &rank));
     MPI_CHECK(MPI_Comm_size(MPI_COMM_WORLD, &nprocs));
-
-    pairs = nprocs/2;
+    set_num_ranks(nprocs);
 
     if (0 == rank) {
         switch (po_ret) {
@@ -88,8 +88,20 @@ int main(int argc, char* argv[])
             break;
     }
 
+    if (allocate_latency_samples()) {
+        MPI_CHECK(MPI_Finalize());
+        exit(EXIT_FAILURE);
+    }
+
+    if ((pairs = init_pairing(rank, nprocs, nprocs / 2)) < 0) {
+        free_latency_samples();
+        MPI_CHECK(MPI_Finalize());
+        exit(EXIT_FAILURE);
+    }
+
     if (rank == 0) {
         print_header(rank, LAT);
+        print_pairing(rank);
         fflush(stdout);
     }
 
@@ -99,6 +111,8 @@ int main(int argc, char* argv[])
     
     MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
 
+    free_latency_samples();
+
     MPI_CHECK(MPI_Finalize());
 
     if (NONE != options.accel) {
@@ -113,18 +127,18 @@ int main(int argc, char* argv[])
 
 static void multi_latency(int rank, int pairs)
 {
-    int size, partner;
+    int size, partner = pair_partner();
     int i;
     double t_start = 0.0, t_end = 0.0,
            latency = 0.0, total_lat = 0.0,
-           avg_lat = 0.0, t_total = 0.0;
+           avg_lat = 0.0, t_total = 0.0, t_iter = 0.0;
 
     /*needed for the kernel loss calculations*/
     double t_lo=0.0;
 
     MPI_Status reqstat;
 
-    for (size = options.min_message_size; size <= options.max_message_size; size  = (size ? size * 2 : 1)) {
+    for (size = first_message_size(1); size <= options.max_message_size; size = next_message_size(size, 1)) {
 
         if (allocate_memory_pt2pt_mul_size(&s_buf, &r_buf, rank, pairs, size)) {
             /* Error allocating memory */
@@ -150,13 +164,19 @@ static void multi_latency(int rank, int pairs)
         }
 #endif /* #ifdef _ENABLE_CUDA_KERNEL_ */
 
+        if (options.persistent && partner >= 0) {
+            init_persistent_requests(&s_buf, size, partner, 1, 1, 1,
+                    send_request);
+            init_persistent_requests(&r_buf, size, partner, 1, 0, 1,
+                    recv_request);
+        }
+
+        adaptive_begin();
         MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
         t_total = 0.0;
 
         for (i = 0; i < options.iterations + options.skip; i++) {
-            if (rank < pairs) {
-                partner = rank + pairs;
-
+            if (pair_initiator()) {
                 if (i >= options.skip) {
                     t_start = MPI_Wtime();
                 }
@@ -167,9 +187,16 @@ static void multi_latency(int rank, int pairs)
                 }
 #endif /* #ifdef _ENABLE_CUDA_KERNEL_ */
 
-                MPI_CHECK(MPI_Send(s_buf, size, MPI_CHAR, partner, 1, MPI_COMM_WORLD));
-                MPI_CHECK(MPI_Recv(r_buf, size, MPI_CHAR, partner, 1, MPI_COMM_WORLD,
-                          &reqstat));
+                if (options.persistent) {
+                    MPI_CHECK(MPI_Start(send_request));
+                    MPI_CHECK(MPI_Wait(send_request, &reqstat));
+                    MPI_CHECK(MPI_Start(recv_request));
+                    MPI_CHECK(MPI_Wait(recv_request, &reqstat));
+                } else {
+                    MPI_CHECK(MPI_Send(s_buf, size, MPI_CHAR, partner, 1, MPI_COMM_WORLD));
+                    MPI_CHECK(MPI_Recv(r_buf, size, MPI_CHAR, partner, 1, MPI_COMM_WORLD,
+                              &reqstat));
+                }
 #ifdef _ENABLE_CUDA_KERNEL_
                 if (options.src == 'M') {
                     touch_managed_src(r_buf, size);
@@ -178,34 +205,59 @@ static void multi_latency(int rank, int pairs)
 
                 if (i >= options.skip) {
                     t_end = MPI_Wtime();
-                    t_total += calculate_total(t_start, t_end, t_lo);
+                    t_iter = calculate_total(t_start, t_end, t_lo);
+                    t_total += t_iter;
+                    record_latency_sample(t_iter * 1e6 / 2.0);
                 }
-            } else {
-                partner = rank - pairs;
-
+            } else if (partner >= 0) {
 #ifdef _ENABLE_CUDA_KERNEL_
                 if (options.dst == 'M') {
                     touch_managed_dst(s_buf, size);
                 }
 #endif /* #ifdef _ENABLE_CUDA_KERNEL_ */
 
-                MPI_CHECK(MPI_Recv(r_buf, size, MPI_CHAR, partner, 1, MPI_COMM_WORLD,
-                          &reqstat));
+                if (options.persistent) {
+                    MPI_CHECK(MPI_Start(recv_request));
+                    MPI_CHECK(MPI_Wait(recv_request, &reqstat));
+                } else {
+                    MPI_CHECK(MPI_Recv(r_buf, size, MPI_CHAR, partner, 1, MPI_COMM_WORLD,
+                              &reqstat));
+                }
 #ifdef _ENABLE_CUDA_KERNEL_
                 if (options.dst == 'M') {
                     touch_managed_dst(r_buf, size);
                 }
 #endif /* #ifdef _ENABLE_CUDA_KERNEL_ */
 
-                MPI_CHECK(MPI_Send(s_buf, size, MPI_CHAR, partner, 1, MPI_COMM_WORLD));
+                if (options.persistent) {
+                    MPI_CHECK(MPI_Start(send_request));
+                    MPI_CHECK(MPI_Wait(send_request, &reqstat));
+                } else {
+                    MPI_CHECK(MPI_Send(s_buf, size, MPI_CHAR, partner, 1, MPI_COMM_WORLD));
+                }
             }
+            adaptive_check(MPI_COMM_WORLD, i);
+        }
+
+        if (options.persistent && partner >= 0) {
+            free_persistent_requests(1, send_request);
+            free_persistent_requests(1, recv_request);
         }
 
+        reduce_latency_samples(MPI_COMM_WORLD);
+        MPI_CHECK(MPI_Reduce(&t_total, &total_lat, 1, MPI_DOUBLE, MPI_SUM, 0,
+                    MPI_COMM_WORLD));
+
         if (0 == rank) {
-            double latency = (t_total * 1e6) / (2.0 * options.iterations);
+            double latency = (total_lat * 1e6) /
+                (2.0 * options.iterations * pairs);
 
-            fprintf(stdout, "%-*d%*.*f\n", 10, size, FIELD_WIDTH,
+            fprintf(stdout, "%-*d%*.*f", 10, size, FIELD_WIDTH,
                     FLOAT_PRECISION, latency);
+            omb_result_begin(size, options.iterations);
+            omb_result_metric("latency_us", latency);
+            print_latency_dist(rank);
+            omb_result_end();
             fflush(stdout);
         }
 
@@ -0,0 +1,203 @@
+#define BENCHMARK "OSU MPI%s Partitioned Bandwidth Test"
+/*
+ * Copyright (C) 2002-2021 the Network-Based Computing Laboratory
+ * (NBCL), The Ohio State University.
+ *
+ * Contact: Dr. D. K. Panda (panda@cse.ohio-state.edu)
+ *
+ * For detailed copyright and licensing information, please refer to the
+ * copyright file COPYRIGHT in the top level OMB directory.
+ */
+
+#include <osu_util_mpi.h>
+
+/*
+ * Rank 0 sends windows of options.window_size messages, each split into
+ * options.partitions partitions, once as partitioned requests and once as
+ * one MPI_Isend per partition; rank 1 acknowledges each window.
+ */
+static double partition_bw (char * s_buf, char * r_buf, int size, int myid,
+        int partitioned)
+{
+    struct partition_set set;
+    int i;
+    double t_start = 0.0, t_end = 0.0, t = 0.0;
+
+    if (0 == myid) {
+        init_partition_set(&set, s_buf, size, 1, 100, 1, options.window_size,
+                partitioned);
+    } else {
+        init_partition_set(&set, r_buf, size, 0, 100, 0, options.window_size,
+                partitioned);
+    }
+
+    MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
+
+    for (i = 0; i < options.iterations + options.skip; i++) {
+        if (i == options.skip) {
+            t_start = MPI_Wtime();
+        }
+
+        start_partitions(&set);
+
+        if (0 == myid) {
+            ready_partitions(&set);
+            wait_partitions(&set);
+            MPI_CHECK(MPI_Recv(r_buf, 4, MPI_CHAR, 1, 101, MPI_COMM_WORLD,
+                    MPI_STATUS_IGNORE));
+        } else {
+            wait_partitions(&set);
+            MPI_CHECK(MPI_Send(s_buf, 4, MPI_CHAR, 0, 101, MPI_COMM_WORLD));
+        }
+    }
+
+    t_end = MPI_Wtime();
+    t = t_end - t_start;
+
+    free_partition_set(&set);
+
+    return (double)set.chunk * options.partitions / 1e6 * options.iterations *
+        options.window_size / t;
+}
+
+int main(int argc, char *argv[])
+{
+    int myid, numprocs, provided, required;
+    int size;
+    char *s_buf, *r_buf;
+    double part_bw, isend_bw;
+    int po_ret;
+
+    options.bench = PT2PT;
+    options.subtype = BW_PART;
+
+    set_header(HEADER);
+    set_benchmark_name("osu_partitioned_bw");
+
+    po_ret = process_options(argc, argv);
+    required = READY_THREADS == options.ready_mode ? MPI_THREAD_MULTIPLE :
+        MPI_THREAD_SINGLE;
+
+    MPI_CHECK(MPI_Init_thread(&argc, &argv, required, &provided));
+    MPI_CHECK(MPI_Comm_size(MPI_COMM_WORLD, &numprocs));
+    set_num_ranks(numprocs);
+    MPI_CHECK(MPI_Comm_rank(MPI_COMM_WORLD, &myid));
+
+    if (0 == myid) {
+        switch (po_ret) {
+            case PO_BAD_USAGE:
+                print_bad_usage_message(myid);
+                break;
+            case PO_HELP_MESSAGE:
+                print_help_message(myid);
+                break;
+            case PO_VERSION_MESSAGE:
+                print_version_message(myid);
+                MPI_CHECK(MPI_Finalize());
+                exit(EXIT_SUCCESS);
+            case PO_OKAY:
+                break;
+        }
+    }
+
+    switch (po_ret) {
+        case PO_CUDA_NOT_AVAIL:
+        case PO_OPENACC_NOT_AVAIL:
+        case PO_BAD_USAGE:
+            MPI_CHECK(MPI_Finalize());
+            exit(EXIT_FAILURE);
+        case PO_HELP_MESSAGE:
+        case PO_VERSION_MESSAGE:
+            MPI_CHECK(MPI_Finalize());
+            exit(EXIT_SUCCESS);
+        case PO_OKAY:
+            break;
+    }
+
+    if (numprocs != 2) {
+        if (myid == 0) {
+            fprintf(stderr, "This test requires exactly two processes\n");
+        }
+
+        MPI_CHECK(MPI_Finalize());
+        exit(EXIT_FAILURE);
+    }
+
+    if (provided < required) {
+        if (myid == 0) {
+            fprintf(stderr, "--ready threads needs MPI_THREAD_MULTIPLE\n");
+        }
+
+        MPI_CHECK(MPI_Finalize());
+        exit(EXIT_FAILURE);
+    }
+
+    if (init_partition_threads(0 == myid)) {
+        if (myid == 0) {
+            fprintf(stderr, "--ready threads supports at most %d partitions\n",
+                    MAX_NUM_THREADS);
+        }
+
+        MPI_CHECK(MPI_Finalize());
+        exit(EXIT_FAILURE);
+    }
+
+    if (allocate_memory_pt2pt(&s_buf, &r_buf, myid)) {
+        /* Error allocating memory */
+        MPI_CHECK(MPI_Finalize());
+        exit(EXIT_FAILURE);
+    }
+
+    if (0 == myid) {
+        print_header(myid, BW_PART);
+        fprintf(stdout, "# Partitions: %d\n", options.partitions);
+        fprintf(stdout, "# Ready order: %s\n", READY_THREADS ==
+                options.ready_mode ? "one thread per partition" :
+                "staggered, last partition first");
+        fprintf(stdout, "# [ window size: %d ]\n", options.window_size);
+        fprintf(stdout, "%-*s%*s%*s%*s\n", 10, "# Size", FIELD_WIDTH,
+                "Partitioned (MB/s)", FIELD_WIDTH, "Isend (MB/s)",
+                FIELD_WIDTH, "Speedup");
+        fflush(stdout);
+    }
+
+    /* Bandwidth test */
+    for (size = first_message_size(1); size <= options.max_message_size;
+            size = next_message_size(size, 1)) {
+        if (size < options.partitions) {
+            continue;
+        }
+
+        set_buffer_pt2pt(s_buf, myid, options.accel, 'a', size);
+        set_buffer_pt2pt(r_buf, myid, options.accel, 'b', size);
+
+        if (size > LARGE_MESSAGE_SIZE) {
+            options.iterations = options.iterations_large;
+            options.skip = options.skip_large;
+        }
+
+        part_bw = partition_bw(s_buf, r_buf, size, myid, 1);
+        isend_bw = partition_bw(s_buf, r_buf, size, myid, 0);
+
+        if (0 == myid) {
+            fprintf(stdout, "%-*d%*.*f%*.*f%*.*f\n", 10, size, FIELD_WIDTH,
+                    FLOAT_PRECISION, part_bw, FIELD_WIDTH, FLOAT_PRECISION,
+                    isend_bw, FIELD_WIDTH, FLOAT_PRECISION,
+                    part_bw / isend_bw);
+            omb_result_begin(size, options.iterations);
+            omb_result_metric("bandwidth_mbps", part_bw);
+            omb_result_field("isend_bandwidth_mbps", isend_bw);
+            omb_result_field("speedup", part_bw / isend_bw);
+            omb_result_end();
+            fflush(stdout);
+        }
+    }
+
+    free_memory(s_buf, r_buf, myid);
+    free_partition_threads();
+    MPI_CHECK(MPI_Finalize());
+
+    return EXIT_SUCCESS;
+}
+
+/* vi: set sw=4 sts=4 tw=80: */
@@ -0,0 +1,200 @@
+#define BENCHMARK "OSU MPI%s Partitioned Latency Test"
+/*
+ * Copyright (C) 2002-2021 the Network-Based Computing Laboratory
+ * (NBCL), The Ohio State University.
+ *
+ * Contact: Dr. D. K. Panda (panda@cse.ohio-state.edu)
+ *
+ * For detailed copyright and licensing information, please refer to the
+ * copyright file COPYRIGHT in the top level OMB directory.
+ */
+
+#include <osu_util_mpi.h>
+
+/*
+ * Ping-pong where each message is split into options.partitions partitions,
+ * once with MPI_Psend_init/MPI_Precv_init and once with one MPI_Isend and
+ * MPI_Irecv per partition, so the two can be compared at every size.
+ */
+static double partition_latency (char * s_buf, char * r_buf, int size,
+        int myid, int partitioned)
+{
+    struct partition_set send_set, recv_set;
+    int i, peer = 1 - myid;
+    double t_start = 0.0, t_end = 0.0;
+
+    init_partition_set(&send_set, s_buf, size, peer, myid ? 2 : 1, 1, 1,
+            partitioned);
+    init_partition_set(&recv_set, r_buf, size, peer, myid ? 1 : 2, 0, 1,
+            partitioned);
+
+    MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
+
+    for (i = 0; i < options.iterations + options.skip; i++) {
+        if (i == options.skip) {
+            t_start = MPI_Wtime();
+        }
+
+        if (0 == myid) {
+            start_partitions(&recv_set);
+            start_partitions(&send_set);
+            ready_partitions(&send_set);
+            wait_partitions(&send_set);
+            wait_partitions(&recv_set);
+        } else {
+            start_partitions(&recv_set);
+            wait_partitions(&recv_set);
+            start_partitions(&send_set);
+            ready_partitions(&send_set);
+            wait_partitions(&send_set);
+        }
+    }
+
+    t_end = MPI_Wtime();
+
+    free_partition_set(&send_set);
+    free_partition_set(&recv_set);
+
+    return (t_end - t_start) * 1e6 / (2.0 * options.iterations);
+}
+
+int main(int argc, char *argv[])
+{
+    int myid, numprocs, provided, required;
+    int size;
+    char *s_buf, *r_buf;
+    double part_latency, isend_latency;
+    int po_ret;
+
+    options.bench = PT2PT;
+    options.subtype = LAT_PART;
+
+    set_header(HEADER);
+    set_benchmark_name("osu_partitioned_latency");
+
+    po_ret = process_options(argc, argv);
+    required = READY_THREADS == options.ready_mode ? MPI_THREAD_MULTIPLE :
+        MPI_THREAD_SINGLE;
+
+    MPI_CHECK(MPI_Init_thread(&argc, &argv, required, &provided));
+    MPI_CHECK(MPI_Comm_size(MPI_COMM_WORLD, &numprocs));
+    set_num_ranks(numprocs);
+    MPI_CHECK(MPI_Comm_rank(MPI_COMM_WORLD, &myid));
+
+    if (0 == myid) {
+        switch (po_ret) {
+            case PO_BAD_USAGE:
+                print_bad_usage_message(myid);
+                break;
+            case PO_HELP_MESSAGE:
+                print_help_message(myid);
+                break;
+            case PO_VERSION_MESSAGE:
+                print_version_message(myid);
+                MPI_CHECK(MPI_Finalize());
+                exit(EXIT_SUCCESS);
+            case PO_OKAY:
+                break;
+        }
+    }
+
+    switch (po_ret) {
+        case PO_CUDA_NOT_AVAIL:
+        case PO_OPENACC_NOT_AVAIL:
+        case PO_BAD_USAGE:
+            MPI_CHECK(MPI_Finalize());
+            exit(EXIT_FAILURE);
+        case PO_HELP_MESSAGE:
+        case PO_VERSION_MESSAGE:
+            MPI_CHECK(MPI_Finalize());
+            exit(EXIT_SUCCESS);
+        case PO_OKAY:
+            break;
+    }
+
+    if (numprocs != 2) {
+        if (myid == 0) {
+            fprintf(stderr, "This test requires exactly two processes\n");
+        }
+
+        MPI_CHECK(MPI_Finalize());
+        exit(EXIT_FAILURE);
+    }
+
+    if (provided < required) {
+        if (myid == 0) {
+            fprintf(stderr, "--ready threads needs MPI_THREAD_MULTIPLE\n");
+        }
+
+        MPI_CHECK(MPI_Finalize());
+        exit(EXIT_FAILURE);
+    }
+
+    if (init_partition_threads(1)) {
+        if (myid == 0) {
+            fprintf(stderr, "--ready threads supports at most %d partitions\n",
+                    MAX_NUM_THREADS);
+        }
+
+        MPI_CHECK(MPI_Finalize());
+        exit(EXIT_FAILURE);
+    }
+
+    if (allocate_memory_pt2pt(&s_buf, &r_buf, myid)) {
+        /* Error allocating memory */
+        MPI_CHECK(MPI_Finalize());
+        exit(EXIT_FAILURE);
+    }
+
+    if (0 == myid) {
+        print_header(myid, LAT_PART);
+        fprintf(stdout, "# Partitions: %d\n", options.partitions);
+        fprintf(stdout, "# Ready order: %s\n", READY_THREADS ==
+                options.ready_mode ? "one thread per partition" :
+                "staggered, last partition first");
+        fprintf(stdout, "%-*s%*s%*s%*s\n", 10, "# Size", FIELD_WIDTH,
+                "Partitioned (us)", FIELD_WIDTH, "Isend (us)", FIELD_WIDTH,
+                "Speedup");
+        fflush(stdout);
+    }
+
+    /* Latency test */
+    for (size = first_message_size(1); size <= options.max_message_size;
+            size = next_message_size(size, 1)) {
+        if (size < options.partitions) {
+            continue;
+        }
+
+        set_buffer_pt2pt(s_buf, myid, options.accel, 'a', size);
+        set_buffer_pt2pt(r_buf, myid, options.accel, 'b', size);
+
+        if (size > LARGE_MESSAGE_SIZE) {
+            options.iterations = options.iterations_large;
+            options.skip = options.skip_large;
+        }
+
+        part_latency = partition_latency(s_buf, r_buf, size, myid, 1);
+        isend_latency = partition_latency(s_buf, r_buf, size, myid, 0);
+
+        if (0 == myid) {
+            fprintf(stdout, "%-*d%*.*f%*.*f%*.*f\n", 10, size, FIELD_WIDTH,
+                    FLOAT_PRECISION, part_latency, FIELD_WIDTH,
+                    FLOAT_PRECISION, isend_latency, FIELD_WIDTH,
+                    FLOAT_PRECISION, isend_latency / part_latency);
+            omb_result_begin(size, options.iterations);
+            omb_result_metric("latency_us", part_latency);
+            omb_result_field("isend_latency_us", isend_latency);
+            omb_result_field("speedup", isend_latency / part_latency);
+            omb_result_end();
+            fflush(stdout);
+        }
+    }
+
+    free_memory(s_buf, r_buf, myid);
+    free_partition_threads();
+    MPI_CHECK(MPI_Finalize());
+
+    return EXIT_SUCCESS;
+}
+
+/* vi: set sw=4 sts=4 tw=80: */
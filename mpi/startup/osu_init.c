@@ -22,27 +22,27 @@ int main (int argc, char *argv[])
 {
     int myid, numprocs;
     struct timespec tp_before, tp_after;
-    long duration = 0, min, max, avg;
+    double duration, min, max, avg;
 
-    clock_gettime(CLOCK_REALTIME, &tp_before);
+    clock_gettime(CLOCK_MONOTONIC, &tp_before);
     MPI_Init(&argc, &argv);
-    clock_gettime(CLOCK_REALTIME, &tp_after);
+    clock_gettime(CLOCK_MONOTONIC, &tp_after);
 
     duration = (tp_after.tv_sec - tp_before.tv_sec) * 1e3;
-    duration += (tp_after.tv_nsec - tp_before.tv_nsec) / 1e6;
+    duration += (tp_after.tv_nsec - tp_before.tv_nsec) * 1e-6;
 
     MPI_Comm_size(MPI_COMM_WORLD, &numprocs);
     MPI_Comm_rank(MPI_COMM_WORLD, &myid);
 
-    MPI_Reduce(&duration, &min, 1, MPI_LONG, MPI_MIN, 0, MPI_COMM_WORLD);
-    MPI_Reduce(&duration, &max, 1, MPI_LONG, MPI_MAX, 0, MPI_COMM_WORLD);
-    MPI_Reduce(&duration, &avg, 1, MPI_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+    MPI_Reduce(&duration, &min, 1, MPI_DOUBLE, MPI_MIN, 0, MPI_COMM_WORLD);
+    MPI_Reduce(&duration, &max, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+    MPI_Reduce(&duration, &avg, 1, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
     avg = avg/numprocs;
 
     if (myid == 0) {
         fprintf(stdout, HEADER);
-        fprintf(stdout, "nprocs: %d, min: %ld ms, max: %ld ms, avg: %ld ms\n",
-                numprocs, min, max, avg);
+        fprintf(stdout, "nprocs: %d, min: %.2f ms, max: %.2f ms, "
+                "avg: %.2f ms\n", numprocs, min, max, avg);
         fflush(stdout);
     }
 
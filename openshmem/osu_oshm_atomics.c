@@ -109,6 +109,7 @@ print_header_local (int myid)
 {
     if (myid == 0) {
         fprintf(stdout, HEADER);
+        fprintf(stdout, "# Timer: %s\n", timer_description());
         fprintf(stdout, "%-*s%*s%*s\n", 20, "# Operation", FIELD_WIDTH,
                 "Million ops/s", FIELD_WIDTH, "Latency (us)");
         fflush(stdout);
@@ -150,584 +151,297 @@ print_operation_rate (int myid, char * operation, double rate, double lat)
     }
 }
 
-double
-benchmark_fadd (struct pe_vars v, union data_types *buffer,
-                unsigned long iterations)
-{
-    double begin, end; 
-    int i;
-    static double rate = 0, sum_rate = 0, lat = 0, sum_lat = 0;
-
-    /*
-     * Touch memory
-     */
-    memset(buffer, CHAR_MAX * drand48(), sizeof(union data_types
-                [OSHM_LOOP_ATOMIC]));
-
-    shmem_barrier_all();
+/*
+ * Each pass issues ITERATIONS atomics of one kind at consecutive elements of
+ * BUFFER on PE.  PASS counts the passes run so far.
+ */
+typedef void (*atomic_pass) (union data_types *buffer,
+                             unsigned long iterations, int pe,
+                             unsigned long pass);
 
-    if (v.me < v.pairs) {
-        int value = 1;
-        int old_value;
+static int int_value;
+static long long longlong_value;
 
-        begin = TIME();
-        for (i = 0; i < iterations; i++) { 
-            old_value = shmem_int_fadd(&(buffer[i].int_type), value, v.nxtpe);
-        }
-        end = TIME();
+static void
+fadd_pass (union data_types *buffer, unsigned long iterations, int pe,
+           unsigned long pass)
+{
+    unsigned long i;
 
-        rate = ((double)iterations * 1e6) / (end - begin);
-        lat = (end - begin) / (double)iterations;
+    for (i = 0; i < iterations; i++) {
+        shmem_int_fadd(&(buffer[i].int_type), 1, pe);
     }
-
-    shmem_double_sum_to_all(&sum_rate, &rate, 1, 0, 0, v.npes, pwrk1, psync1);
-    shmem_double_sum_to_all(&sum_lat, &lat, 1, 0, 0, v.npes, pwrk2, psync2);    
-    print_operation_rate(v.me, "shmem_int_fadd", sum_rate/1e6, sum_lat/v.pairs);
-
-    return 0;
 }
 
-double
-benchmark_fadd_longlong (struct pe_vars v, union data_types *buffer,
-                unsigned long iterations)
+static void
+fadd_longlong_pass (union data_types *buffer, unsigned long iterations, int pe,
+                    unsigned long pass)
 {
-    double begin, end; 
-    int i;
-    static double rate = 0, sum_rate = 0, lat = 0, sum_lat = 0;
-
-    /*
-     * Touch memory
-     */
-    memset(buffer, CHAR_MAX * drand48(), sizeof(union data_types
-                [OSHM_LOOP_ATOMIC]));
+    unsigned long i;
 
-    shmem_barrier_all();
-
-    if (v.me < v.pairs) {
-        long long value = 1;
-        long long old_value;
-
-        begin = TIME();
-        for (i = 0; i < iterations; i++) {
-            old_value = shmem_longlong_fadd(&(buffer[i].longlong_type), value, v.nxtpe);
-        }
-        end = TIME();
-
-        rate = ((double)iterations * 1e6) / (end - begin);
-        lat = (end - begin) / (double)iterations;
+    for (i = 0; i < iterations; i++) {
+        shmem_longlong_fadd(&(buffer[i].longlong_type), 1, pe);
     }
-
-    shmem_double_sum_to_all(&sum_rate, &rate, 1, 0, 0, v.npes, pwrk1, psync1);
-    shmem_double_sum_to_all(&sum_lat, &lat, 1, 0, 0, v.npes, pwrk2, psync2);    
-    print_operation_rate(v.me, "shmem_longlong_fadd", sum_rate/1e6, sum_lat/v.pairs);
-    return 0;
 }
 
-double
-benchmark_finc (struct pe_vars v, union data_types *buffer,
-                unsigned long iterations)
+static void
+finc_pass (union data_types *buffer, unsigned long iterations, int pe,
+           unsigned long pass)
 {
-    double begin, end; 
-    int i;
-    static double rate = 0, sum_rate = 0, lat = 0, sum_lat = 0;
-
-    /*
-     * Touch memory
-     */
-    memset(buffer, CHAR_MAX * drand48(), sizeof(union data_types
-                [OSHM_LOOP_ATOMIC]));
-
-    shmem_barrier_all();
-
-    if (v.me < v.pairs) {
-        int old_value;
-
-        begin = TIME();
-        for (i = 0; i < iterations; i++) {
-            old_value = shmem_int_finc(&(buffer[i].int_type), v.nxtpe);
-        }
-        end = TIME();
+    unsigned long i;
 
-        rate = ((double)iterations * 1e6) / (end - begin);
-        lat = (end - begin) / (double)iterations;
+    for (i = 0; i < iterations; i++) {
+        shmem_int_finc(&(buffer[i].int_type), pe);
     }
-
-    shmem_double_sum_to_all(&sum_rate, &rate, 1, 0, 0, v.npes, pwrk1, psync1);
-    shmem_double_sum_to_all(&sum_lat, &lat, 1, 0, 0, v.npes, pwrk2, psync2);
-    print_operation_rate(v.me, "shmem_int_finc", sum_rate/1e6, sum_lat/v.pairs);
-
-    return 0;
 }
 
-double
-benchmark_finc_longlong (struct pe_vars v, union data_types *buffer,
-                unsigned long iterations)
+static void
+finc_longlong_pass (union data_types *buffer, unsigned long iterations, int pe,
+                    unsigned long pass)
 {
-    double begin, end; 
-    int i;
-    static double rate = 0, sum_rate = 0, lat = 0, sum_lat = 0;
-
-    /*
-     * Touch memory
-     */
-    memset(buffer, CHAR_MAX * drand48(), sizeof(union data_types
-                [OSHM_LOOP_ATOMIC]));
+    unsigned long i;
 
-    shmem_barrier_all();
-
-    if (v.me < v.pairs) {
-        long long old_value;
-
-        begin = TIME();
-        for (i = 0; i < iterations; i++) {
-            old_value = shmem_longlong_finc(&(buffer[i].longlong_type), v.nxtpe);
-        }
-        end = TIME();
-
-        rate = ((double)iterations * 1e6) / (end - begin);
-        lat = (end - begin) / (double)iterations;
+    for (i = 0; i < iterations; i++) {
+        shmem_longlong_finc(&(buffer[i].longlong_type), pe);
     }
-
-    shmem_double_sum_to_all(&sum_rate, &rate, 1, 0, 0, v.npes, pwrk1, psync1);
-    shmem_double_sum_to_all(&sum_lat, &lat, 1, 0, 0, v.npes, pwrk2, psync2);
-    print_operation_rate(v.me, "shmem_longlong_finc", sum_rate/1e6, sum_lat/v.pairs);
-
-    return 0;
 }
 
-double
-benchmark_add (struct pe_vars v, union data_types *buffer,
-                unsigned long iterations)
+static void
+add_pass (union data_types *buffer, unsigned long iterations, int pe,
+          unsigned long pass)
 {
-    double begin, end; 
-    int i;
-    static double rate = 0, sum_rate = 0, lat = 0, sum_lat = 0;    
-
-    /*
-     * Touch memory
-     */
-    memset(buffer, CHAR_MAX * drand48(), sizeof(union data_types
-                [OSHM_LOOP_ATOMIC]));
-
-    shmem_barrier_all();
-
-    if (v.me < v.pairs) {
-        int value = INT_MAX * drand48();
-
-        begin = TIME();
-        for (i = 0; i < iterations; i++) {
-            shmem_int_add(&(buffer[i].int_type), value, v.nxtpe);
-        }
-        end = TIME();
+    unsigned long i;
 
-        rate = ((double)iterations * 1e6) / (end - begin);
-        lat = (end - begin) / (double)iterations;
+    for (i = 0; i < iterations; i++) {
+        shmem_int_add(&(buffer[i].int_type), int_value, pe);
     }
-
-    shmem_double_sum_to_all(&sum_rate, &rate, 1, 0, 0, v.npes, pwrk1, psync1);
-    shmem_double_sum_to_all(&sum_lat, &lat, 1, 0, 0, v.npes, pwrk2, psync2);
-    print_operation_rate(v.me, "shmem_int_add", sum_rate/1e6, sum_lat/v.pairs);
-
-    return 0;
 }
 
-double
-benchmark_add_longlong (struct pe_vars v, union data_types *buffer,
-                unsigned long iterations)
+static void
+add_longlong_pass (union data_types *buffer, unsigned long iterations, int pe,
+                   unsigned long pass)
 {
-    double begin, end; 
-    int i;
-    static double rate = 0, sum_rate = 0, lat = 0, sum_lat = 0;    
-
-    /*
-     * Touch memory
-     */
-    memset(buffer, CHAR_MAX * drand48(), sizeof(union data_types
-                [OSHM_LOOP_ATOMIC]));
-
-    shmem_barrier_all();
+    unsigned long i;
 
-    if (v.me < v.pairs) {
-        long long value = INT_MAX * drand48();
-
-        begin = TIME();
-        for (i = 0; i < iterations; i++) {
-            shmem_longlong_add(&(buffer[i].longlong_type), value, v.nxtpe);
-        }
-        end = TIME();
-
-        rate = ((double)iterations * 1e6) / (end - begin);
-        lat = (end - begin) / (double)iterations;
+    for (i = 0; i < iterations; i++) {
+        shmem_longlong_add(&(buffer[i].longlong_type), longlong_value, pe);
     }
-
-    shmem_double_sum_to_all(&sum_rate, &rate, 1, 0, 0, v.npes, pwrk1, psync1);
-    shmem_double_sum_to_all(&sum_lat, &lat, 1, 0, 0, v.npes, pwrk2, psync2);
-    print_operation_rate(v.me, "shmem_longlong_add", sum_rate/1e6, sum_lat/v.pairs);
-
-    return 0;
 }
 
-double
-benchmark_inc (struct pe_vars v, union data_types *buffer,
-               unsigned long iterations)
+static void
+inc_pass (union data_types *buffer, unsigned long iterations, int pe,
+          unsigned long pass)
 {
-    double begin, end; 
-    int i;
-    static double rate = 0, sum_rate = 0, lat = 0, sum_lat = 0;
-
-    /*
-     * Touch memory
-     */
-    memset(buffer, CHAR_MAX * drand48(), sizeof(union data_types
-                [OSHM_LOOP_ATOMIC]));
-
-    shmem_barrier_all();
+    unsigned long i;
 
-    if (v.me < v.pairs) {
-        begin = TIME();
-        for (i = 0; i < iterations; i++) {
-            shmem_int_inc(&(buffer[i].int_type), v.nxtpe);
-        }
-        end = TIME();
-
-        rate = ((double)iterations * 1e6) / (end - begin);
-        lat = (end - begin) / (double)iterations;
+    for (i = 0; i < iterations; i++) {
+        shmem_int_inc(&(buffer[i].int_type), pe);
     }
-
-    shmem_double_sum_to_all(&sum_rate, &rate, 1, 0, 0, v.npes, pwrk1, psync1);
-    shmem_double_sum_to_all(&sum_lat, &lat, 1, 0, 0, v.npes, pwrk2, psync2);
-    print_operation_rate(v.me, "shmem_int_inc", sum_rate/1e6, sum_lat/v.pairs);
-
-    return 0;
 }
 
-double
-benchmark_inc_longlong (struct pe_vars v, union data_types *buffer,
-                        unsigned long iterations)
+static void
+inc_longlong_pass (union data_types *buffer, unsigned long iterations, int pe,
+                   unsigned long pass)
 {
-    double begin, end; 
-    int i;
-    static double rate = 0, sum_rate = 0, lat = 0, sum_lat = 0;
-
-    /*
-     * Touch memory
-     */
-    memset(buffer, CHAR_MAX * drand48(), sizeof(union data_types
-                [OSHM_LOOP_ATOMIC]));
-
-    shmem_barrier_all();
+    unsigned long i;
 
-    if (v.me < v.pairs) {
-        begin = TIME();
-        for (i = 0; i < iterations; i++) {
-            shmem_longlong_inc(&(buffer[i].longlong_type), v.nxtpe);
-        }
-        end = TIME();
-
-        rate = ((double)iterations * 1e6) / (end - begin);
-        lat = (end - begin) / (double)iterations;
+    for (i = 0; i < iterations; i++) {
+        shmem_longlong_inc(&(buffer[i].longlong_type), pe);
     }
-
-    shmem_double_sum_to_all(&sum_rate, &rate, 1, 0, 0, v.npes, pwrk1, psync1);
-    shmem_double_sum_to_all(&sum_lat, &lat, 1, 0, 0, v.npes, pwrk2, psync2);
-    print_operation_rate(v.me, "shmem_longlong_inc", sum_rate/1e6, sum_lat/v.pairs);
-
-    return 0;
 }
 
-double
-benchmark_swap (struct pe_vars v, union data_types *buffer,
-                unsigned long iterations)
+/*
+ * The target elements start out holding PE, and every pass swaps them
+ * between PE and the origin's value, so each cswap finds its condition met
+ * however many passes the batching repeats.
+ */
+static void
+cswap_pass (union data_types *buffer, unsigned long iterations, int pe,
+            unsigned long pass)
 {
-    double begin, end; 
-    int i;
-    static double rate = 0, sum_rate = 0, lat = 0, sum_lat = 0;
-
-    /*
-     * Touch memory
-     */
-    memset(buffer, CHAR_MAX * drand48(), sizeof(union data_types
-                [OSHM_LOOP_ATOMIC]));
+    int cond = pass % 2 ? int_value : pe;
+    int value = pass % 2 ? pe : int_value;
+    unsigned long i;
 
-    shmem_barrier_all();
-
-    if (v.me < v.pairs) {
-        int value = INT_MAX * drand48();
-        int old_value;
-
-        begin = TIME();
-        for (i = 0; i < iterations; i++) {
-            old_value = shmem_int_swap(&(buffer[i].int_type), value, v.nxtpe);
-        }
-        end = TIME();
-
-        rate = ((double)iterations * 1e6) / (end - begin);
-        lat = (end - begin) / (double)iterations;        
+    for (i = 0; i < iterations; i++) {
+        shmem_int_cswap(&(buffer[i].int_type), cond, value, pe);
     }
-
-    shmem_double_sum_to_all(&sum_rate, &rate, 1, 0, 0, v.npes, pwrk1, psync1);
-    shmem_double_sum_to_all(&sum_lat, &lat, 1, 0, 0, v.npes, pwrk2, psync2);
-    print_operation_rate(v.me, "shmem_int_swap", sum_rate/1e6, sum_lat/v.pairs);
-
-    return 0;
 }
 
-double
-benchmark_swap_longlong (struct pe_vars v, union data_types *buffer,
-                         unsigned long iterations)
+static void
+cswap_longlong_pass (union data_types *buffer, unsigned long iterations,
+                     int pe, unsigned long pass)
 {
-    double begin, end; 
-    int i;
-    static double rate = 0, sum_rate = 0, lat = 0, sum_lat = 0;
-
-    /*
-     * Touch memory
-     */
-    memset(buffer, CHAR_MAX * drand48(), sizeof(union data_types
-                [OSHM_LOOP_ATOMIC]));
+    long long cond = pass % 2 ? longlong_value : pe;
+    long long value = pass % 2 ? pe : longlong_value;
+    unsigned long i;
 
-    shmem_barrier_all();
-
-    if (v.me < v.pairs) {
-        long long value = INT_MAX * drand48();
-        long long old_value;
-
-        begin = TIME();
-        for (i = 0; i < iterations; i++) {
-            old_value = shmem_longlong_swap(&(buffer[i].longlong_type), value, v.nxtpe);
-        }
-        end = TIME();
-
-        rate = ((double)iterations * 1e6) / (end - begin);
-        lat = (end - begin) / (double)iterations;        
+    for (i = 0; i < iterations; i++) {
+        shmem_longlong_cswap(&(buffer[i].longlong_type), cond, value, pe);
     }
-
-    shmem_double_sum_to_all(&sum_rate, &rate, 1, 0, 0, v.npes, pwrk1, psync1);
-    shmem_double_sum_to_all(&sum_lat, &lat, 1, 0, 0, v.npes, pwrk2, psync2);
-    print_operation_rate(v.me, "shmem_longlong_swap", sum_rate/1e6, sum_lat/v.pairs);
-
-    return 0;
 }
 
-double
-benchmark_cswap (struct pe_vars v, union data_types *buffer,
-                 unsigned long iterations)
+static void
+swap_pass (union data_types *buffer, unsigned long iterations, int pe,
+           unsigned long pass)
 {
-    double begin, end; 
-    int i;
-    static double rate = 0, sum_rate = 0, lat = 0, sum_lat = 0;
+    unsigned long i;
 
-    /*
-     * Touch memory
-     */
-    for (i=0; i<OSHM_LOOP_ATOMIC; i++) {
-        buffer[i].int_type = v.me;
+    for (i = 0; i < iterations; i++) {
+        shmem_int_swap(&(buffer[i].int_type), int_value, pe);
     }
+}
 
-    shmem_barrier_all();
-
-    if (v.me < v.pairs) {
-        int cond = v.nxtpe;
-        int value = INT_MAX * drand48();
-        int old_value;
+static void
+swap_longlong_pass (union data_types *buffer, unsigned long iterations, int pe,
+                    unsigned long pass)
+{
+    unsigned long i;
 
-        begin = TIME();
-        for (i = 0; i < iterations; i++) {
-            old_value = shmem_int_cswap(&(buffer[i].int_type), cond, value, v.nxtpe);
-        }
-        end = TIME();
-		
-        rate = ((double)iterations * 1e6) / (end - begin);
-        lat = (end - begin) / (double)iterations;        
+    for (i = 0; i < iterations; i++) {
+        shmem_longlong_swap(&(buffer[i].longlong_type), longlong_value, pe);
     }
-	
-    shmem_double_sum_to_all(&sum_rate, &rate, 1, 0, 0, v.npes, pwrk1, psync1);
-    shmem_double_sum_to_all(&sum_lat, &lat, 1, 0, 0, v.npes, pwrk2, psync2);
-    print_operation_rate(v.me, "shmem_int_cswap", sum_rate/1e6, sum_lat/v.pairs);
-
-    return 0;
 }
 
-double
-benchmark_cswap_longlong (struct pe_vars v, union data_types *buffer,
-                          unsigned long iterations)
+static void
+set_pass (union data_types *buffer, unsigned long iterations, int pe,
+          unsigned long pass)
 {
-    double begin, end; 
-    int i;
-    static double rate = 0, sum_rate = 0, lat = 0, sum_lat = 0;
+    unsigned long i;
 
-    /*
-     * Touch memory
-     */
-    for (i=0; i<OSHM_LOOP_ATOMIC; i++) {
-        buffer[i].int_type = v.me;
+    for (i = 0; i < iterations; i++) {
+        shmem_int_set(&(buffer[i].int_type), 1, pe);
     }
+}
 
-    shmem_barrier_all();
-
-
-    if (v.me < v.pairs) {
-        long long cond = v.nxtpe;
-        long long value = INT_MAX * drand48();
-        long long old_value;
-
-        begin = TIME();
-        for (i = 0; i < iterations; i++) {
-            old_value = shmem_longlong_cswap(&(buffer[i].longlong_type), cond, value, v.nxtpe);
-        }
-        end = TIME();
+static void
+set_longlong_pass (union data_types *buffer, unsigned long iterations, int pe,
+                   unsigned long pass)
+{
+    unsigned long i;
 
-        rate = ((double)iterations * 1e6) / (end - begin);
-        lat = (end - begin) / (double)iterations;        
+    for (i = 0; i < iterations; i++) {
+        shmem_longlong_set(&(buffer[i].longlong_type), 1, pe);
     }
-
-    shmem_double_sum_to_all(&sum_rate, &rate, 1, 0, 0, v.npes, pwrk1, psync1);
-    shmem_double_sum_to_all(&sum_lat, &lat, 1, 0, 0, v.npes, pwrk2, psync2);
-    print_operation_rate(v.me, "shmem_longlong_cswap", sum_rate/1e6, sum_lat/v.pairs);
-
-    return 0;
 }
 
-
-double
-benchmark_fetch (struct pe_vars v, union data_types *buffer,
-               unsigned long iterations)
+static void
+fetch_pass (union data_types *buffer, unsigned long iterations, int pe,
+            unsigned long pass)
 {
-    double begin, end; 
-    int i;
-    static double rate = 0, sum_rate = 0, lat = 0, sum_lat = 0;
-
-    /*
-     * Touch memory
-     */
-    memset(buffer, CHAR_MAX * drand48(), sizeof(union data_types
-                [OSHM_LOOP_ATOMIC]));
-	
-
-    shmem_barrier_all();
+    unsigned long i;
 
-    if (v.me < v.pairs) {
-        begin = TIME();
-        for (i = 0; i < iterations; i++) {
-            shmem_int_fetch(&buffer[i].int_type, v.nxtpe);
-        }
-        end = TIME();
-
-        rate = ((double)iterations * 1e6) / (end - begin);
-        lat = (end - begin) / (double)iterations;
+    for (i = 0; i < iterations; i++) {
+        shmem_int_fetch(&(buffer[i].int_type), pe);
     }
+}
 
-    shmem_double_sum_to_all(&sum_rate, &rate, 1, 0, 0, v.npes, pwrk1, psync1);
-    shmem_double_sum_to_all(&sum_lat, &lat, 1, 0, 0, v.npes, pwrk2, psync2);
-    print_operation_rate(v.me, "shmem_int_fetch", sum_rate/1e6, sum_lat/v.pairs);
+static void
+fetch_longlong_pass (union data_types *buffer, unsigned long iterations,
+                     int pe, unsigned long pass)
+{
+    unsigned long i;
 
-    return 0;
+    for (i = 0; i < iterations; i++) {
+        shmem_longlong_fetch(&(buffer[i].longlong_type), pe);
+    }
 }
 
-double
-benchmark_fetch_longlong (struct pe_vars v, union data_types *buffer,
-                        unsigned long iterations)
+static void
+cswap_touch (struct pe_vars v, union data_types *buffer)
 {
-    double begin, end; 
     int i;
-    static double rate = 0, sum_rate = 0, lat = 0, sum_lat = 0;
-
-    /*
-     * Touch memory
-     */
-    memset(buffer, CHAR_MAX * drand48(), sizeof(union data_types
-                [OSHM_LOOP_ATOMIC]));
-
-    shmem_barrier_all();
-
-    if (v.me < v.pairs) {
-        begin = TIME();
-        for (i = 0; i < iterations; i++) {
-            int res = shmem_longlong_fetch(&(buffer[i].longlong_type), v.nxtpe);
-        }
-        end = TIME();
 
-        rate = ((double)iterations * 1e6) / (end - begin);
-        lat = (end - begin) / (double)iterations;
+    for (i = 0; i < OSHM_LOOP_ATOMIC; i++) {
+        buffer[i].int_type = v.me;
     }
-
- 
-    shmem_double_sum_to_all(&sum_rate, &rate, 1, 0, 0, v.npes, pwrk1, psync1);
-    shmem_double_sum_to_all(&sum_lat, &lat, 1, 0, 0, v.npes, pwrk2, psync2);
-    print_operation_rate(v.me, "shmem_longlong_fetch", sum_rate/1e6, sum_lat/v.pairs);
-
-    return 0;
 }
 
-
-double
-benchmark_set (struct pe_vars v, union data_types *buffer,
-                unsigned long iterations)
+static void
+cswap_longlong_touch (struct pe_vars v, union data_types *buffer)
 {
-    double begin, end; 
     int i;
-    static double rate = 0, sum_rate = 0, lat = 0, sum_lat = 0;
-
-    /*
-     * Touch memory
-     */
-    memset(buffer, CHAR_MAX * drand48(), sizeof(union data_types
-                [OSHM_LOOP_ATOMIC]));
-
-    shmem_barrier_all();
-
-    if (v.me < v.pairs) {
-        int value = 1;
 
-        begin = TIME();
-        for (i = 0; i < iterations; i++) { 
-            shmem_int_set(&(buffer[i].int_type), value, v.nxtpe);
-        }
-        end = TIME();
-
-        rate = ((double)iterations * 1e6) / (end - begin);
-        lat = (end - begin) / (double)iterations;
+    for (i = 0; i < OSHM_LOOP_ATOMIC; i++) {
+        buffer[i].longlong_type = v.me;
     }
+}
 
-    shmem_double_sum_to_all(&sum_rate, &rate, 1, 0, 0, v.npes, pwrk1, psync1);
-    shmem_double_sum_to_all(&sum_lat, &lat, 1, 0, 0, v.npes, pwrk2, psync2);    
-    print_operation_rate(v.me, "shmem_int_set", sum_rate/1e6, sum_lat/v.pairs);
+struct atomic_test {
+    char * operation;
+    atomic_pass run;
+    void (*touch) (struct pe_vars v, union data_types *buffer);
+};
 
-    return 0;
-}
+static struct atomic_test const atomic_tests[] = {
+    {"shmem_int_fadd", fadd_pass, NULL},
+    {"shmem_int_finc", finc_pass, NULL},
+    {"shmem_int_add", add_pass, NULL},
+    {"shmem_int_inc", inc_pass, NULL},
+    {"shmem_int_cswap", cswap_pass, cswap_touch},
+    {"shmem_int_swap", swap_pass, NULL},
+    {"shmem_int_set", set_pass, NULL},
+    {"shmem_int_fetch", fetch_pass, NULL},
+    {"shmem_longlong_fadd", fadd_longlong_pass, NULL},
+    {"shmem_longlong_finc", finc_longlong_pass, NULL},
+    {"shmem_longlong_add", add_longlong_pass, NULL},
+    {"shmem_longlong_inc", inc_longlong_pass, NULL},
+    {"shmem_longlong_cswap", cswap_longlong_pass, cswap_longlong_touch},
+    {"shmem_longlong_swap", swap_longlong_pass, NULL},
+    {"shmem_longlong_set", set_longlong_pass, NULL},
+    {"shmem_longlong_fetch", fetch_longlong_pass, NULL},
+};
 
+/*
+ * Time passes of TEST, repeated in batches until the timed region is long
+ * enough for the timer, and print the rate and latency summed over all pairs.
+ */
 double
-benchmark_set_longlong (struct pe_vars v, union data_types *buffer,
-                unsigned long iterations)
+benchmark_atomic (struct pe_vars v, union data_types *buffer,
+                  unsigned long iterations, struct atomic_test const * test)
 {
-    double begin, end; 
-    int i;
+    double begin, end;
+    unsigned long batch, next, k, pass = 0;
     static double rate = 0, sum_rate = 0, lat = 0, sum_lat = 0;
 
     /*
      * Touch memory
      */
-    memset(buffer, CHAR_MAX * drand48(), sizeof(union data_types
-                [OSHM_LOOP_ATOMIC]));
+    if (test->touch) {
+        test->touch(v, buffer);
+    } else {
+        memset(buffer, CHAR_MAX * drand48(), sizeof(union data_types
+                    [OSHM_LOOP_ATOMIC]));
+    }
+
+    /* never a PE number, so cswap always changes the element */
+    int_value = v.npes + INT_MAX / 2 * drand48();
+    longlong_value = int_value;
 
     shmem_barrier_all();
 
     if (v.me < v.pairs) {
-        long long value = 1;
+        for (batch = 1; ; batch = next) {
+            begin = TIME();
+            for (k = 0; k < batch; k++) {
+                test->run(buffer, iterations, v.nxtpe, pass++);
+            }
+            end = TIME();
 
-        begin = TIME();
-        for (i = 0; i < iterations; i++) {
-            shmem_longlong_set(&(buffer[i].longlong_type), value, v.nxtpe);
+            if ((next = timer_batch(end - begin, batch)) == batch) {
+                break;
+            }
         }
-        end = TIME();
 
-        rate = ((double)iterations * 1e6) / (end - begin);
-        lat = (end - begin) / (double)iterations;
+        lat = timer_elapsed(begin, end) / ((double)iterations * batch);
+        rate = 1e6 / lat;
     }
 
     shmem_double_sum_to_all(&sum_rate, &rate, 1, 0, 0, v.npes, pwrk1, psync1);
-    shmem_double_sum_to_all(&sum_lat, &lat, 1, 0, 0, v.npes, pwrk2, psync2);    
-    print_operation_rate(v.me, "shmem_longlong_set", sum_rate/1e6, sum_lat/v.pairs);
+    shmem_double_sum_to_all(&sum_lat, &lat, 1, 0, 0, v.npes, pwrk2, psync2);
+    print_operation_rate(v.me, test->operation, sum_rate/1e6,
+            sum_lat/v.pairs);
+
     return 0;
 }
 
@@ -735,6 +449,7 @@ benchmark_set_longlong (struct pe_vars v, union data_types *buffer,
 void
 benchmark (struct pe_vars v, union data_types *msg_buffer)
 {
+    size_t t;
 
     srand(v.me);
 
@@ -753,23 +468,9 @@ benchmark (struct pe_vars v, union data_types *msg_buffer)
     /*
      * Performance with atomics
      */ 
-    benchmark_fadd(v, msg_buffer, OSHM_LOOP_ATOMIC);
-    benchmark_finc(v, msg_buffer, OSHM_LOOP_ATOMIC);
-    benchmark_add(v, msg_buffer, OSHM_LOOP_ATOMIC);
-    benchmark_inc(v, msg_buffer, OSHM_LOOP_ATOMIC);
-    benchmark_cswap(v, msg_buffer, OSHM_LOOP_ATOMIC);
-    benchmark_swap(v, msg_buffer, OSHM_LOOP_ATOMIC);
-	benchmark_set(v, msg_buffer, OSHM_LOOP_ATOMIC);
-	benchmark_fetch(v, msg_buffer, OSHM_LOOP_ATOMIC);
-    
-    benchmark_fadd_longlong(v, msg_buffer, OSHM_LOOP_ATOMIC);
-    benchmark_finc_longlong(v, msg_buffer, OSHM_LOOP_ATOMIC);
-    benchmark_add_longlong(v, msg_buffer, OSHM_LOOP_ATOMIC);
-    benchmark_inc_longlong(v, msg_buffer, OSHM_LOOP_ATOMIC);
-    benchmark_cswap_longlong(v, msg_buffer, OSHM_LOOP_ATOMIC);
-    benchmark_swap_longlong(v, msg_buffer, OSHM_LOOP_ATOMIC);
-	benchmark_set_longlong(v, msg_buffer, OSHM_LOOP_ATOMIC);
-	benchmark_fetch_longlong(v, msg_buffer, OSHM_LOOP_ATOMIC);
+    for (t = 0; t < sizeof(atomic_tests) / sizeof(atomic_tests[0]); t++) {
+        benchmark_atomic(v, msg_buffer, OSHM_LOOP_ATOMIC, &atomic_tests[t]);
+    }
 }
 
 int
@@ -785,6 +486,7 @@ main (int argc, char *argv[])
      */
     v = init_openshmem();
     check_usage(v.me, v.npes, argc, argv);
+    init_timer();
 
     for (i = 0; i < _SHMEM_REDUCE_SYNC_SIZE; i += 1) {
         psync1[i] = _SHMEM_SYNC_VALUE;
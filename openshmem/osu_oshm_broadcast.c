@@ -50,6 +50,9 @@ int main(int argc, char *argv[])
     numprocs = _num_pes();
 #endif
 
+    set_benchmark_name("osu_oshm_broadcast");
+    set_num_ranks(numprocs);
+
     po_ret = process_options(argc, argv);
 
     switch (po_ret) {
@@ -39,6 +39,9 @@ init_openshmem (void)
 	v.me = _my_pe();
     v.npes = _num_pes();
 #endif
+
+    set_benchmark_name("osu_oshm_put_mr");
+    set_num_ranks(v.npes);
     
     v.pairs = v.npes / 2;
     v.nxtpe = v.me < v.pairs ? v.me + v.pairs : v.me - v.pairs;
@@ -152,6 +155,11 @@ print_message_rate (int myid, int size, double rate)
         fprintf(stdout, "%-*d%*.*f\n", 10, size, FIELD_WIDTH, FLOAT_PRECISION,
                 rate);
         fflush(stdout);
+
+        omb_result_begin(size, size < LARGE_MESSAGE_SIZE ?
+                OSHM_LOOP_SMALL_MR : OSHM_LOOP_LARGE_MR);
+        omb_result_field("messages_per_sec", rate);
+        omb_result_end();
     }
 }
 
@@ -41,6 +41,9 @@ int main(int argc, char *argv[])
     numprocs = _num_pes();
 #endif
 
+    set_benchmark_name("osu_oshm_put_nb");
+    set_num_ranks(numprocs);
+
     if(numprocs != 2) {
         if(myid == 0) {
             fprintf(stderr, "This test requires exactly two processes\n");
@@ -139,6 +142,9 @@ int main(int argc, char *argv[])
 
             fprintf(stdout, "%-*d%*.*f\n", 10, size, FIELD_WIDTH,
                     FLOAT_PRECISION, latency);
+            omb_result_begin(size, loop);
+            omb_result_field("latency_us", latency);
+            omb_result_end();
             fflush(stdout);
         }
     }
@@ -92,6 +92,9 @@ int main(int argc, char *argv[])
     numprocs = _num_pes();
 #endif
 
+    set_benchmark_name("osu_oshm_put_overlap");
+    set_num_ranks(numprocs);
+
     if(numprocs != 2) {
         if(myid == 0) {
             fprintf(stderr, "This test requires exactly two processes\n");
@@ -243,6 +246,14 @@ int main(int argc, char *argv[])
                 LOCAL_WIDTH, FLOAT_PRECISION, overlap);
 
             fflush(stdout);
+
+            omb_result_begin(size, loop);
+            omb_result_field("compute_us", tcomp_total/loop);
+            omb_result_field("init_us", init_time/loop);
+            omb_result_field("wait_us", wait_time/loop);
+            omb_result_field("comm_us", latency_in_secs);
+            omb_result_field("overlap_pct", overlap);
+            omb_result_end();
         }
     }
 
@@ -29,6 +29,9 @@ int main(int argc, char *argv[])
 
     options.bench = UPC;
 
+    set_benchmark_name("osu_upc_all_broadcast");
+    set_num_ranks(THREADS);
+
     po_ret = process_options(argc, argv);
 
     max_msg_size = options.max_message_size;
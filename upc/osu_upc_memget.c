@@ -23,6 +23,9 @@ int main(int argc, char **argv)
     int iamsender = 0;
     int i;
 
+    set_benchmark_name("osu_upc_memget");
+    set_num_ranks(THREADS);
+
     if( THREADS == 1 ) {
         if(MYTHREAD == 0) {
             fprintf(stderr, "This test requires at least two UPC threads\n");
@@ -81,6 +84,9 @@ int main(int argc, char **argv)
                 double latency = (t_end - t_start)/(1.0 * loop);
                 fprintf(stdout, "%-*d%*.*f\n", 10, size, FIELD_WIDTH,
                         FLOAT_PRECISION, latency);
+                omb_result_begin(size, loop);
+                omb_result_field("latency_us", latency);
+                omb_result_end();
                 fflush(stdout);
             }
         } else 
@@ -36,6 +36,9 @@ main (int argc, char **argv)
 
     options.bench = UPCXX;
 
+    set_benchmark_name("osu_upcxx_alltoall");
+    set_num_ranks(ranks());
+
     po_ret = process_options(argc, argv);
 
     full = options.show_full;
@@ -30,6 +30,9 @@ main (int argc, char **argv)
     int iamsender = 0;
     int i;
 
+    set_benchmark_name("osu_upcxx_async_copy_get");
+    set_num_ranks(ranks());
+
     if (ranks() == 1) {
         if (myrank() == 0) {
             fprintf(stderr, "This test requires at least two UPC threads\n");
@@ -111,6 +114,9 @@ main (int argc, char **argv)
                 double latency = (t_end - t_start)/(1.0 * loop);
                 fprintf(stdout, "%-*d%*.*f\n", 10, size, FIELD_WIDTH,
                         FLOAT_PRECISION, latency);
+                omb_result_begin(size, loop);
+                omb_result_field("latency_us", latency);
+                omb_result_end();
                 fflush(stdout);
             }
         } else {
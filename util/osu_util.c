@@ -10,6 +10,11 @@
 
 #include "osu_util.h"
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <x86intrin.h>
+#endif
+
 #ifdef _ENABLE_OPENACC_
 #include <openacc.h>
 #endif
@@ -24,6 +29,27 @@ struct options_t options;
 
 struct bad_usage_t bad_usage;
 
+/*
+ * Machine-readable result records.  Each record is one JSON object per line
+ * or one CSV row, written to options.output_file (appended) or stdout.
+ */
+#define OUTPUT_MAX_FIELDS 32
+#define OUTPUT_ARGS_LEN 1024
+#define OUTPUT_HEADER_LEN 2048
+
+static int benchmark_ranks = 0;
+static int output_configured = 0;
+static FILE * output_stream = NULL;
+static time_t output_timestamp;
+static char output_args[OUTPUT_ARGS_LEN];
+static char output_csv_header[OUTPUT_HEADER_LEN];
+static int result_size;
+static size_t result_iterations;
+static int result_num_fields;
+static int result_metric = -1;
+static char const * result_names[OUTPUT_MAX_FIELDS];
+static double result_values[OUTPUT_MAX_FIELDS];
+
 void
 print_header(int rank, int full)
 {
@@ -46,6 +72,12 @@ print_header(int rank, int full)
                         break;
                 }
 
+                if (options.persistent) {
+                    fprintf(stdout, "# Persistent requests (MPI_Send_init/MPI_Recv_init)\n");
+                }
+                print_host_memory_policy();
+                print_cache_state();
+
                 switch (options.accel) {
                     case CUDA:
                     case OPENACC:
@@ -59,7 +91,10 @@ print_header(int rank, int full)
                         if (options.subtype == BW && options.bench != MBW_MR) {
                             fprintf(stdout, "%-*s%*s\n", 10, "# Size", FIELD_WIDTH, "Bandwidth (MB/s)");
                         } else if (options.subtype == LAT) {
-                            fprintf(stdout, "%-*s%*s\n", 10, "# Size", FIELD_WIDTH, "Latency (us)");
+                            fprintf(stdout, "%-*s%*s", 10, "# Size", FIELD_WIDTH, "Latency (us)");
+                            print_header_cache();
+                            print_header_percentiles();
+                            fprintf(stdout, "\n");
                         }
                         fflush(stdout);
                 }
@@ -68,6 +103,7 @@ print_header(int rank, int full)
         case COLLECTIVE :
             if (rank == 0) {
                 fprintf(stdout, HEADER, "");
+                print_host_memory_policy();
 
                 if (options.show_size) {
                     fprintf(stdout, "%-*s", 10, "# Size");
@@ -96,6 +132,145 @@ print_header(int rank, int full)
     }
 }
 
+void print_header_percentiles (void)
+{
+    if (options.adaptive) {
+        fprintf(stdout, "%*s", FIELD_WIDTH, "CI95(%)");
+    }
+
+    if (options.show_percentiles) {
+        fprintf(stdout, "%*s", FIELD_WIDTH, "P50 Latency(us)");
+        fprintf(stdout, "%*s", FIELD_WIDTH, "P90 Latency(us)");
+        fprintf(stdout, "%*s", FIELD_WIDTH, "P99 Latency(us)");
+        fprintf(stdout, "%*s", FIELD_WIDTH, "P99.9 Latency(us)");
+    }
+}
+
+void print_host_memory_policy (void)
+{
+    static char const * pages[] = {
+        "default pages",
+        "transparent huge pages",
+        "2M hugetlbfs pages",
+        "1G hugetlbfs pages"
+    };
+
+    if (PAGE_DEFAULT == options.page_policy &&
+            NUMA_NONE == options.numa_policy && !options.prefault) {
+        return;
+    }
+
+    fprintf(stdout, "# Host memory: %s", pages[options.page_policy]);
+    if (options.prefault) {
+        fprintf(stdout, ", prefaulted");
+    }
+
+    switch (options.numa_policy) {
+        case NUMA_LOCAL:
+            fprintf(stdout, ", local NUMA node");
+            break;
+        case NUMA_REMOTE:
+            fprintf(stdout, ", next NUMA node");
+            break;
+        case NUMA_INTERLEAVE:
+            fprintf(stdout, ", interleaved over NUMA nodes");
+            break;
+        case NUMA_NODE:
+            fprintf(stdout, ", NUMA node %d", options.numa_node);
+            break;
+        default:
+            break;
+    }
+    fprintf(stdout, "\n");
+}
+
+/* largest cache reported by sysconf, or by sysfs where sysconf has none */
+size_t cache_llc_size (void)
+{
+    char path[64];
+    unsigned long value;
+    char unit;
+    size_t size = 0;
+    FILE *fp;
+    int i;
+
+    if (options.llc_size) {
+        return options.llc_size;
+    }
+
+#ifdef _SC_LEVEL3_CACHE_SIZE
+    if (sysconf(_SC_LEVEL3_CACHE_SIZE) > 0) {
+        return sysconf(_SC_LEVEL3_CACHE_SIZE);
+    }
+#endif
+
+    for (i = 0; i < 8; i++) {
+        snprintf(path, sizeof(path),
+                "/sys/devices/system/cpu/cpu0/cache/index%d/size", i);
+        if (NULL == (fp = fopen(path, "r"))) {
+            break;
+        }
+        unit = '\0';
+        if (fscanf(fp, "%lu%c", &value, &unit) >= 1) {
+            value *= 'K' == unit ? 1024 : 'M' == unit ? 1024 * 1024 : 1;
+            size = MAX(size, value);
+        }
+        fclose(fp);
+    }
+
+    return size ? size : DEF_LLC_SIZE;
+}
+
+void print_header_cache (void)
+{
+    if (CACHE_HOT != options.cache_state) {
+        fprintf(stdout, "%*s", FIELD_WIDTH, "Cold Latency(us)");
+    }
+
+    if (FRESH_NONE != options.fresh_buffers) {
+        fprintf(stdout, "%*s", FIELD_WIDTH, "Fresh Latency(us)");
+    }
+}
+
+void print_cache_state (void)
+{
+    switch (options.cache_state) {
+        case CACHE_COLD:
+            fprintf(stdout, "# Cache state: hot, and cold from a pool of at "
+                    "least twice the %zu KB LLC\n", cache_llc_size() / 1024);
+            break;
+        case CACHE_FLUSH:
+#ifdef CACHE_FLUSH_INSN
+            fprintf(stdout, "# Cache state: hot, and cold with buffers "
+                    "flushed by " CACHE_FLUSH_INSN " before each iteration\n");
+#else
+            fprintf(stdout, "# Cache state: hot, and cold with an eviction "
+                    "pool of at least twice the %zu KB LLC written before each "
+                    "iteration\n", cache_llc_size() / 1024);
+#endif
+            break;
+        default:
+            break;
+    }
+
+    switch (options.fresh_buffers) {
+        case FRESH_MALLOC:
+            fprintf(stdout, "# Fresh buffers: malloc and free around every "
+                    "iteration\n");
+            break;
+        case FRESH_MMAP:
+            fprintf(stdout, "# Fresh buffers: mmap and munmap around every "
+                    "iteration\n");
+            break;
+        case FRESH_POOL:
+            fprintf(stdout, "# Fresh buffers: rotating through a %zu MB "
+                    "pool\n", options.fresh_pool_size / (1024 * 1024));
+            break;
+        default:
+            break;
+    }
+}
+
 void print_data (int rank, int full, int size, double avg_time,
                  double min_time, double max_time, int iterations)
 {
@@ -146,6 +321,92 @@ set_max_message_size (long long value)
     return 0;
 }
 
+static int
+compare_size (void const * a, void const * b)
+{
+    size_t x = *(size_t const *)a, y = *(size_t const *)b;
+
+    return (x > y) - (x < y);
+}
+
+/* SIZE[,SIZE...]: run exactly these sizes, in ascending order */
+static int
+set_message_size_list (char *val_str)
+{
+    char *token, *end;
+    long long value;
+    int i, n = 1;
+
+    for (i = 0; val_str[i]; i++) {
+        n += (val_str[i] == ',');
+    }
+
+    free(options.size_list);
+    options.size_list = malloc(n * sizeof(size_t));
+    if (NULL == options.size_list) {
+        return -1;
+    }
+
+    n = 0;
+    for (token = strtok(val_str, ","); token; token = strtok(NULL, ",")) {
+        value = strtoll(token, &end, 10);
+        if (end == token || *end || 0 > value) {
+            return -1;
+        }
+        options.size_list[n++] = value;
+    }
+
+    if (!n) {
+        return -1;
+    }
+
+    qsort(options.size_list, n, sizeof(size_t), compare_size);
+    for (i = 1, options.size_list_len = 1; i < n; i++) {
+        if (options.size_list[i] != options.size_list[i - 1]) {
+            options.size_list[options.size_list_len++] = options.size_list[i];
+        }
+    }
+
+    options.size_step = SIZE_STEP_LIST;
+    options.min_message_size = options.size_list[0];
+    options.max_message_size = options.size_list[options.size_list_len - 1];
+
+    return 0;
+}
+
+/* MIN:MAX:+STEP adds STEP bytes, MIN:MAX:*FACTOR (or xFACTOR) multiplies */
+static int
+set_message_size_step (char *val_str)
+{
+    char *val1, *val2, *val3, *end;
+
+    val1 = strtok(val_str, ":");
+    val2 = strtok(NULL, ":");
+    val3 = strtok(NULL, ":");
+
+    if (!val1 || !val2 || !val3 || set_min_message_size(atoll(val1)) ||
+            set_max_message_size(atoll(val2))) {
+        return -1;
+    }
+
+    options.size_step_value = strtod(val3 + 1, &end);
+    if (end == val3 + 1 || *end) {
+        return -1;
+    }
+
+    if ('+' == val3[0] && options.size_step_value >= 1) {
+        options.size_step = SIZE_STEP_LINEAR;
+        options.size_step_value = floor(options.size_step_value);
+    } else if (('*' == val3[0] || 'x' == val3[0]) &&
+            options.size_step_value > 1) {
+        options.size_step = SIZE_STEP_GEOMETRIC;
+    } else {
+        return -1;
+    }
+
+    return 0;
+}
+
 static int
 set_message_size (char *val_str)
 {
@@ -153,12 +414,18 @@ set_message_size (char *val_str)
     int i, count = 0;
     char *val1, *val2;
 
+    if (strchr(val_str, ',')) {
+        return set_message_size_list(val_str);
+    }
+
     for (i=0; val_str[i]; i++) {
         if (val_str[i] == ':')
             count++;
     }
 
-    if (!count) {
+    if (count == 2) {
+        return set_message_size_step(val_str);
+    } else if (!count) {
         retval = set_max_message_size(atoll(val_str));
     } else if (count == 1) {
         val1 = strtok(val_str, ":");
@@ -329,6 +596,268 @@ static int set_max_imbalace_factor (double value){
     return 0; 
 }
 
+/* benchmarks whose timed loops call adaptive_begin/adaptive_check */
+int adaptive_supported (void)
+{
+    return (options.bench == COLLECTIVE &&
+            (options.subtype == LAT || options.subtype == LAT_MULTI)) ||
+           (options.bench == PT2PT && options.subtype == LAT);
+}
+
+/* benchmarks that call record_latency_sample for every timed operation */
+int percentiles_supported (void)
+{
+    return (options.bench == COLLECTIVE && options.subtype != NBC) ||
+           (options.bench == PT2PT && options.subtype == LAT) ||
+           (options.bench == ONE_SIDED && options.subtype == LAT_HOTSPOT);
+}
+
+/* benchmarks that place their pairs with init_pairing */
+int pairing_supported (void)
+{
+    return 0 != (options.features & FEATURE_PAIRING);
+}
+
+/* blocking and windowed point-to-point loops that can use persistent requests */
+int persistent_supported (void)
+{
+    return options.bench == PT2PT &&
+        (options.subtype == LAT || options.subtype == BW);
+}
+
+/* benchmarks that add a cold-cache or fresh-buffer pass to every message size */
+int cache_supported (void)
+{
+    return 0 != (options.features & FEATURE_CACHE);
+}
+
+/* MPI benchmarks whose buffers come from allocate_host_buffer */
+int host_memory_supported (void)
+{
+    return options.bench != OSHM && options.bench != UPC &&
+        options.bench != UPCXX && options.subtype != LAT_HOTSPOT;
+}
+
+/* collective loops that separate their iterations with iteration_sync */
+int iteration_sync_supported (void)
+{
+    return 0 != (options.features & FEATURE_ITERATION_SYNC);
+}
+
+char const * ddt_names[DDT_NUM_TYPES] = {
+    "vector", "indexed", "subarray", "struct"
+};
+
+char const * wildcard_names[MATCH_NUM_WILDCARDS] = {
+    "none", "source", "tag"
+};
+
+/* comma-separated list of NAMES, e.g. vector,struct, as a bitmask in MASK */
+static int set_name_list (char const * list, char const ** names, int num,
+        int * mask)
+{
+    size_t len;
+    int t;
+
+    *mask = 0;
+
+    for (; *list; list += len) {
+        list += strspn(list, ",");
+        len = strcspn(list, ",");
+        for (t = 0; t < num; t++) {
+            if (len && strlen(names[t]) == len &&
+                    0 == strncmp(names[t], list, len)) {
+                *mask |= 1 << t;
+                break;
+            }
+        }
+        if (len && num == t) {
+            return -1;
+        }
+    }
+
+    return 0 == *mask ? -1 : 0;
+}
+
+/* auto or a comma-separated list of CPU ids */
+static int set_pin_threads (char const * cpus)
+{
+    char const * p;
+
+    options.pin_threads = 1;
+    options.thread_cpus = NULL;
+
+    if (0 == strcmp(cpus, "auto")) {
+        return 0;
+    }
+
+    /* digits only, with no empty entry before, between or after commas */
+    for (p = cpus; *p; p++) {
+        if (',' == *p) {
+            if (p == cpus || ',' == p[1] || '\0' == p[1]) {
+                return -1;
+            }
+        } else if (*p < '0' || *p > '9') {
+            return -1;
+        }
+    }
+
+    if ('\0' == cpus[0]) {
+        return -1;
+    }
+
+    options.thread_cpus = cpus;
+
+    return 0;
+}
+
+/* block, intra-socket, cross-socket, cross-node, random[:SEED] or map:FILE */
+static int set_pairing (char const * mode)
+{
+    static struct {
+        char const * name;
+        enum pairing pairing;
+    } const modes[] = {
+        {"block", PAIRING_BLOCK},
+        {"intra-socket", PAIRING_INTRA_SOCKET},
+        {"cross-socket", PAIRING_CROSS_SOCKET},
+        {"cross-node", PAIRING_CROSS_NODE},
+        {"random", PAIRING_RANDOM},
+        {"map", PAIRING_MAP},
+    };
+    char const * arg = strchr(mode, ':');
+    size_t len = arg ? (size_t)(arg - mode) : strlen(mode);
+    char * end;
+    size_t i;
+
+    for (i = 0; i < sizeof(modes) / sizeof(modes[0]); i++) {
+        if (strlen(modes[i].name) == len &&
+                0 == strncmp(modes[i].name, mode, len)) {
+            break;
+        }
+    }
+
+    if (i == sizeof(modes) / sizeof(modes[0])) {
+        return -1;
+    }
+
+    switch (modes[i].pairing) {
+        case PAIRING_RANDOM:
+            if (arg) {
+                options.pairing_seed = strtoul(arg + 1, &end, 10);
+                if (end == arg + 1 || *end) {
+                    return -1;
+                }
+            }
+            break;
+        case PAIRING_MAP:
+            if (NULL == arg || '\0' == arg[1]) {
+                return -1;
+            }
+            options.pairing_map = arg + 1;
+            break;
+        default:
+            if (arg) {
+                return -1;
+            }
+            break;
+    }
+
+    options.pairing = modes[i].pairing;
+
+    return 0;
+}
+
+/* barrier, window or window:USEC */
+static int set_iteration_sync (char const * mode)
+{
+    char * end;
+
+    if (0 == strcmp(mode, "barrier")) {
+        options.iteration_sync = ITERATION_SYNC_BARRIER;
+        return 0;
+    }
+
+    if (strncmp(mode, "window", 6)) {
+        return -1;
+    }
+
+    options.iteration_sync = ITERATION_SYNC_WINDOW;
+    options.sync_window = 0.0;
+
+    if (':' == mode[6]) {
+        options.sync_window = strtod(mode + 7, &end);
+        if (end == mode + 7 || *end || options.sync_window <= 0) {
+            return -1;
+        }
+    } else if (mode[6]) {
+        return -1;
+    }
+
+    return 0;
+}
+
+/*
+ * PATTERN is one of default, uniform, normal, exponential, pareto, late[:RANK],
+ * node or trace:FILE
+ */
+static int set_arrival_pattern (char const * pattern)
+{
+    static struct {
+        char const * name;
+        enum arrival_pattern pattern;
+    } const patterns[] = {
+        {"default", ARRIVAL_DEFAULT},
+        {"uniform", ARRIVAL_UNIFORM},
+        {"normal", ARRIVAL_NORMAL},
+        {"exponential", ARRIVAL_EXPONENTIAL},
+        {"pareto", ARRIVAL_PARETO},
+        {"late", ARRIVAL_LATE},
+        {"node", ARRIVAL_NODE},
+        {"trace", ARRIVAL_TRACE},
+    };
+    char const * arg = strchr(pattern, ':');
+    size_t len = arg ? (size_t)(arg - pattern) : strlen(pattern);
+    size_t i;
+
+    for (i = 0; i < sizeof(patterns) / sizeof(patterns[0]); i++) {
+        if (strlen(patterns[i].name) == len &&
+                0 == strncmp(patterns[i].name, pattern, len)) {
+            break;
+        }
+    }
+
+    if (i == sizeof(patterns) / sizeof(patterns[0])) {
+        return -1;
+    }
+
+    switch (patterns[i].pattern) {
+        case ARRIVAL_LATE:
+            if (arg) {
+                options.arrival_rank = atoi(arg + 1);
+                if (options.arrival_rank < 0) {
+                    return -1;
+                }
+            }
+            break;
+        case ARRIVAL_TRACE:
+            if (NULL == arg || '\0' == arg[1]) {
+                return -1;
+            }
+            options.arrival_trace = arg + 1;
+            break;
+        default:
+            if (arg) {
+                return -1;
+            }
+            break;
+    }
+
+    options.arrival_pattern = patterns[i].pattern;
+
+    return 0;
+}
+
 static int set_validate (int value)
 {
     if (value < 0 || value > 1) {
@@ -396,43 +925,349 @@ void set_benchmark_name (const char * name)
     benchmark_name = name;
 }
 
-void enable_accel_support (void)
+void set_num_ranks (int num_ranks)
 {
-    accel_enabled = ((CUDA_ENABLED || OPENACC_ENABLED || ROCM_ENABLED) &&
-            !(options.subtype == LAT_MT || options.subtype == LAT_MP));
+    benchmark_ranks = num_ranks;
 }
 
-int process_options (int argc, char *argv[])
+int set_output_format (const char * format)
 {
-    extern char * optarg;
-    extern int optind, optopt;
+    if (0 == strncasecmp(format, "text", 10)) {
+        options.output_format = OUTPUT_TEXT;
+    } else if (0 == strncasecmp(format, "json", 10)) {
+        options.output_format = OUTPUT_JSON;
+    } else if (0 == strncasecmp(format, "csv", 10)) {
+        options.output_format = OUTPUT_CSV;
+    } else {
+        return -1;
+    }
 
-    char const * optstring = NULL;
-    int c, ret = PO_OKAY;
+    return 0;
+}
 
-    int option_index = 0;
+/*
+ * The environment provides the defaults so that benchmarks which do not go
+ * through process_options can still produce records; command line options
+ * override it.
+ */
+static void configure_output (void)
+{
+    char *str = NULL;
 
-    static struct option long_options[] = {
-            {"help",            no_argument,        0,  'h'},
-            {"version",         no_argument,        0,  'v'},
-            {"full",            no_argument,        0,  'f'},
-            {"message-size",    required_argument,  0,  'm'},
-            {"window-size",     required_argument,  0,  'W'},
-            {"num-test-calls",  required_argument,  0,  't'},
-            {"iterations",      required_argument,  0,  'i'},
-            {"warmup",          required_argument,  0,  'x'},
-            {"array-size",      required_argument,  0,  'a'},
-            {"sync-option",     required_argument,  0,  's'},
-            {"win-options",     required_argument,  0,  'w'},
-            {"mem-limit",       required_argument,  0,  'M'},
-            {"accelerator",     required_argument,  0,  'd'},
-            {"cuda-target",     required_argument,  0,  'r'},
-            {"print-rate",      required_argument,  0,  'R'},
-            {"num-pairs",       required_argument,  0,  'p'},
+    if ((str = getenv("OMB_OUTPUT_FORMAT")) != NULL) {
+        if (set_output_format(str)) {
+            fprintf(stderr, "Ignoring invalid OMB_OUTPUT_FORMAT [%s], "
+                    "use text, json or csv\n", str);
+        }
+    }
+
+    if ((str = getenv("OMB_OUTPUT_FILE")) != NULL) {
+        options.output_file = str;
+    }
+
+    output_configured = 1;
+}
+
+static void save_output_args (int argc, char *argv[])
+{
+    int i;
+    size_t len = 0;
+
+    output_args[0] = '\0';
+    for (i = 1; i < argc && len < OUTPUT_ARGS_LEN; i++) {
+        len += snprintf(output_args + len, OUTPUT_ARGS_LEN - len, "%s%s",
+                        (i > 1) ? " " : "", argv[i]);
+    }
+}
+
+static int open_output_stream (void)
+{
+    if (NULL != output_stream) {
+        return 0;
+    }
+
+    if (NULL == options.output_file || 0 == strcmp(options.output_file, "-")) {
+        output_stream = stdout;
+    } else if ((output_stream = fopen(options.output_file, "a+")) == NULL) {
+        fprintf(stderr, "Could not open output file [%s], disabling %s "
+                "output\n", options.output_file,
+                OUTPUT_JSON == options.output_format ? "JSON" : "CSV");
+        options.output_format = OUTPUT_TEXT;
+        return 1;
+    }
+
+    output_timestamp = time(NULL);
+
+    return 0;
+}
+
+static void print_json_string (const char * str)
+{
+    fputc('"', output_stream);
+    for (; str && *str; str++) {
+        if ('"' == *str || '\\' == *str) {
+            fputc('\\', output_stream);
+            fputc(*str, output_stream);
+        } else if ((unsigned char)*str < 0x20) {
+            fprintf(output_stream, "\\u%04x", *str);
+        } else {
+            fputc(*str, output_stream);
+        }
+    }
+    fputc('"', output_stream);
+}
+
+static void print_json_record (void)
+{
+    int i;
+
+    fprintf(output_stream, "{\"benchmark\":");
+    print_json_string(benchmark_name);
+#ifdef PACKAGE_VERSION
+    fprintf(output_stream, ",\"version\":\"%s\"", PACKAGE_VERSION);
+#endif
+    fprintf(output_stream, ",\"timestamp\":%ld", (long)output_timestamp);
+    if (benchmark_ranks) {
+        fprintf(output_stream, ",\"ranks\":%d", benchmark_ranks);
+    } else {
+        fprintf(output_stream, ",\"ranks\":null");
+    }
+    fprintf(output_stream, ",\"size\":%d,\"iterations\":%lu", result_size,
+            (unsigned long)result_iterations);
+
+    for (i = 0; i < result_num_fields; i++) {
+        fprintf(output_stream, ",");
+        print_json_string(result_names[i]);
+        if (isfinite(result_values[i])) {
+            fprintf(output_stream, ":%.10g", result_values[i]);
+        } else {
+            fprintf(output_stream, ":null");
+        }
+    }
+
+    fprintf(output_stream, ",\"options\":");
+    print_json_string(output_args);
+    fprintf(output_stream, "}\n");
+}
+
+/*
+ * A CSV header is written whenever the set of fields changes, unless the
+ * file being appended to already starts with the same header.
+ */
+static void print_csv_header (void)
+{
+    char header[OUTPUT_HEADER_LEN];
+    char line[OUTPUT_HEADER_LEN];
+    size_t len;
+    int i;
+
+    len = snprintf(header, OUTPUT_HEADER_LEN,
+                   "benchmark,version,timestamp,ranks,size,iterations");
+    for (i = 0; i < result_num_fields && len < OUTPUT_HEADER_LEN; i++) {
+        len += snprintf(header + len, OUTPUT_HEADER_LEN - len, ",%s",
+                        result_names[i]);
+    }
+    if (len < OUTPUT_HEADER_LEN) {
+        snprintf(header + len, OUTPUT_HEADER_LEN - len, ",options\n");
+    }
+
+    if (0 == strcmp(header, output_csv_header)) {
+        return;
+    }
+
+    if ('\0' == output_csv_header[0] && stdout != output_stream) {
+        rewind(output_stream);
+        if (fgets(line, OUTPUT_HEADER_LEN, output_stream) &&
+                0 == strcmp(line, header)) {
+            strcpy(output_csv_header, header);
+            return;
+        }
+    }
+
+    fputs(header, output_stream);
+    strcpy(output_csv_header, header);
+}
+
+static void print_csv_record (void)
+{
+    char const * str;
+    int i;
+
+    print_csv_header();
+
+    fprintf(output_stream, "%s,", benchmark_name ? benchmark_name : "");
+#ifdef PACKAGE_VERSION
+    fprintf(output_stream, "%s", PACKAGE_VERSION);
+#endif
+    fprintf(output_stream, ",%ld,", (long)output_timestamp);
+    if (benchmark_ranks) {
+        fprintf(output_stream, "%d", benchmark_ranks);
+    }
+    fprintf(output_stream, ",%d,%lu", result_size,
+            (unsigned long)result_iterations);
+
+    for (i = 0; i < result_num_fields; i++) {
+        fprintf(output_stream, ",%.10g", result_values[i]);
+    }
+
+    fputs(",\"", output_stream);
+    for (str = output_args; *str; str++) {
+        if ('"' == *str) {
+            fputc('"', output_stream);
+        }
+        fputc(*str, output_stream);
+    }
+    fputs("\"\n", output_stream);
+}
+
+void omb_result_begin (int size, size_t iterations)
+{
+    if (!output_configured) {
+        configure_output();
+    }
+
+    result_size = size;
+    result_iterations = iterations;
+    result_num_fields = 0;
+    result_metric = -1;
+}
+
+void omb_result_field (const char * name, double value)
+{
+    if (result_num_fields < OUTPUT_MAX_FIELDS) {
+        result_names[result_num_fields] = name;
+        result_values[result_num_fields] = value;
+        result_num_fields++;
+    }
+}
+
+/* Record a field that is also the metric -m refinement follows */
+void omb_result_metric (const char * name, double value)
+{
+    if (result_num_fields < OUTPUT_MAX_FIELDS) {
+        result_metric = result_num_fields;
+    }
+    omb_result_field(name, value);
+}
+
+void omb_result_end (void)
+{
+    if (OUTPUT_TEXT == options.output_format || open_output_stream()) {
+        return;
+    }
+
+    /* appending needs the stream positioned at the end after a header check */
+    fseek(output_stream, 0, SEEK_END);
+
+    if (OUTPUT_JSON == options.output_format) {
+        print_json_record();
+    } else {
+        print_csv_record();
+    }
+
+    fflush(output_stream);
+}
+
+/*
+ * The metric recorded with omb_result_metric for the last message size, which
+ * -m refinement follows.  Each record is handed out only once.
+ */
+int omb_take_result (int *size, double *value)
+{
+    if (result_metric < 0) {
+        return 0;
+    }
+
+    *size = result_size;
+    *value = result_values[result_metric];
+    result_metric = -1;
+
+    return 1;
+}
+
+/* Print a "size value" row and record it under the given field name */
+void print_result (int size, const char * name, double value)
+{
+    fprintf(stdout, "%-*d%*.*f\n", 10, size, FIELD_WIDTH, FLOAT_PRECISION,
+            value);
+
+    omb_result_begin(size, options.iterations);
+    omb_result_metric(name, value);
+    omb_result_end();
+}
+
+void enable_accel_support (void)
+{
+    accel_enabled = ((CUDA_ENABLED || OPENACC_ENABLED || ROCM_ENABLED) &&
+            !(options.subtype == LAT_MT || options.subtype == LAT_MP ||
+              options.subtype == BW_MT || options.subtype == LAT_PART ||
+              options.subtype == BW_PART || options.subtype == LAT_DDT ||
+              options.subtype == BW_DDT || options.subtype == LAT_MATCH));
+}
+
+int process_options (int argc, char *argv[])
+{
+    extern char * optarg;
+    extern int optind, optopt;
+
+    char const * optstring = NULL;
+    int c, ret = PO_OKAY;
+
+    int option_index = 0;
+
+    static struct option long_options[] = {
+            {"help",            no_argument,        0,  'h'},
+            {"version",         no_argument,        0,  'v'},
+            {"full",            no_argument,        0,  'f'},
+            {"message-size",    required_argument,  0,  'm'},
+            {"window-size",     required_argument,  0,  'W'},
+            {"num-test-calls",  required_argument,  0,  't'},
+            {"iterations",      required_argument,  0,  'i'},
+            {"warmup",          required_argument,  0,  'x'},
+            {"array-size",      required_argument,  0,  'a'},
+            {"sync-option",     required_argument,  0,  's'},
+            {"win-options",     required_argument,  0,  'w'},
+            {"mem-limit",       required_argument,  0,  'M'},
+            {"accelerator",     required_argument,  0,  'd'},
+            {"cuda-target",     required_argument,  0,  'r'},
+            {"print-rate",      required_argument,  0,  'R'},
+            {"num-pairs",       required_argument,  0,  'p'},
             {"vary-window",     required_argument,  0,  'V'},
             {"validation",      required_argument,  0,  'c'},
             {"buffer-num",      required_argument,  0,  'b'},
             {"max-i-f",         required_argument,  0,  'F'},
+            {"arrival-pattern", required_argument,  0,  'A'},
+            {"percentiles",     no_argument,        0,  'P'},
+            {"collectives",     required_argument,  0,  'l'},
+            {"output-format",   required_argument,  0,  LONG_OPT_OUTPUT_FORMAT},
+            {"output-file",     required_argument,  0,  LONG_OPT_OUTPUT_FILE},
+            {"delay-mode",      required_argument,  0,  LONG_OPT_DELAY_MODE},
+            {"iteration-sync",  required_argument,  0,  LONG_OPT_ITERATION_SYNC},
+            {"target-ci",       required_argument,  0,  LONG_OPT_TARGET_CI},
+            {"time-budget",     required_argument,  0,  LONG_OPT_TIME_BUDGET},
+            {"refine",          required_argument,  0,  LONG_OPT_REFINE},
+            {"pairing",         required_argument,  0,  LONG_OPT_PAIRING},
+            {"persistent",      no_argument,        0,  LONG_OPT_PERSISTENT},
+            {"thread-comm",     required_argument,  0,  LONG_OPT_THREAD_COMM},
+            {"pin-threads",     required_argument,  0,  LONG_OPT_PIN_THREADS},
+            {"comm-hints",      no_argument,        0,  LONG_OPT_COMM_HINTS},
+            {"partitions",      required_argument,  0,  LONG_OPT_PARTITIONS},
+            {"ready",           required_argument,  0,  LONG_OPT_READY},
+            {"rma-op",          required_argument,  0,  LONG_OPT_RMA_OP},
+            {"targets",         required_argument,  0,  LONG_OPT_TARGETS},
+            {"table-size",      required_argument,  0,  LONG_OPT_TABLE_SIZE},
+            {"batch",           required_argument,  0,  LONG_OPT_BATCH},
+            {"page-policy",     required_argument,  0,  LONG_OPT_PAGE_POLICY},
+            {"numa",            required_argument,  0,  LONG_OPT_NUMA},
+            {"prefault",        no_argument,        0,  LONG_OPT_PREFAULT},
+            {"cache",           required_argument,  0,  LONG_OPT_CACHE},
+            {"fresh-buffers",   required_argument,  0,  LONG_OPT_FRESH_BUFFERS},
+            {"ddt",             required_argument,  0,  LONG_OPT_DDT},
+            {"block",           required_argument,  0,  LONG_OPT_BLOCK},
+            {"stride",          required_argument,  0,  LONG_OPT_STRIDE},
+            {"depth",           required_argument,  0,  LONG_OPT_DEPTH},
+            {"wildcard",        required_argument,  0,  LONG_OPT_WILDCARD},
+            {0,                 0,                  0,  0},
     };
 
     enable_accel_support();
@@ -442,29 +1277,46 @@ int process_options (int argc, char *argv[])
             if (options.subtype == BW) {
                 optstring = "+:x:i:t:m:d:W:hvb";
             } else {
-                optstring = "+:x:i:m:d:hv";
+                optstring = "+:x:i:m:d:hvP";
             }
         } else{
             if (options.subtype == LAT_MT) {
                 optstring = "+:hvm:x:i:t:";
+            } else if (options.subtype == BW_MT) {
+                optstring = "+:hvm:x:i:t:W:";
+            } else if (options.subtype == LAT_PART) {
+                optstring = "+:hvm:x:i:";
+            } else if (options.subtype == BW_PART) {
+                optstring = "+:hvm:x:i:W:";
+            } else if (options.subtype == LAT_DDT) {
+                optstring = "+:hvm:x:i:";
+            } else if (options.subtype == BW_DDT) {
+                optstring = "+:hvm:x:i:W:";
+            } else if (options.subtype == LAT_MATCH) {
+                optstring = "+:hvx:i:";
             } else if (options.subtype == LAT_MP) {
                 optstring = "+:hvm:x:i:t:";
             } else if (options.subtype == BW) {
                 optstring = "+:hvm:x:i:t:W:b:";
             } else {
-                optstring = "+:hvm:x:i:b:";
+                optstring = "+:hvm:x:i:M:b:P";
             }
         }
     } else if (options.bench == COLLECTIVE) {
         if (options.subtype == LAT) { /* Blocking */
-            optstring = "+:hvfm:i:x:M:a:c:";
+            optstring = "+:hvfm:i:x:M:a:c:P";
             if (accel_enabled) {
-                optstring = (CUDA_KERNEL_ENABLED) ? "+:d:hvfm:i:x:M:r:a:c:" : "+:d:hvfm:i:x:M:a:c:";
+                optstring = (CUDA_KERNEL_ENABLED) ? "+:d:hvfm:i:x:M:r:a:c:P" : "+:d:hvfm:i:x:M:a:c:P";
             }
         } else if (options.subtype == LAT_PAP) { /* PAP-Aware */
-            optstring = "+:hvfm:i:x:M:a:c:F:";
+            optstring = "+:hvfm:i:x:M:a:c:F:A:P";
+            if (accel_enabled) {
+                optstring = (CUDA_KERNEL_ENABLED) ? "+:d:hvfm:i:x:M:r:a:c:F:A:P" : "+:d:hvfm:i:x:M:a:c:F:A:P";
+            }
+        } else if (options.subtype == LAT_MULTI) { /* Multi-Collective */
+            optstring = "+:hvfm:i:x:M:l:P";
             if (accel_enabled) {
-                optstring = (CUDA_KERNEL_ENABLED) ? "+:d:hvfm:i:x:M:r:a:c:F:" : "+:d:hvfm:i:x:M:a:c:F:";
+                optstring = "+:d:hvfm:i:x:M:l:P";
             }
         } else { /* Non-Blocking */
             optstring = "+:hvfm:i:x:M:t:a:c";
@@ -475,6 +1327,12 @@ int process_options (int argc, char *argv[])
     } else if (options.bench == ONE_SIDED) {
         if(options.subtype == BW) {
             optstring = (accel_enabled) ? "+:w:s:hvm:d:x:i:W:" : "+:w:s:hvm:x:i:W:";
+        } else if (options.subtype == LAT_WIN || options.subtype == LAT_SHM) {
+            optstring = "+:hvm:x:i:";
+        } else if (options.subtype == LAT_HOTSPOT) {
+            optstring = "+:hvx:i:P";
+        } else if (options.subtype == GUPS) {
+            optstring = "+:w:s:hvx:i:c:";
         } else {
             optstring = (accel_enabled) ? "+:w:s:hvm:d:x:i:" : "+:w:s:hvm:x:i:";
         }
@@ -492,6 +1350,15 @@ int process_options (int argc, char *argv[])
     options.accel = NONE;
     options.show_size = 1;
     options.show_full = 0;
+    options.show_percentiles = 0;
+    options.size_step = SIZE_STEP_DOUBLE;
+    options.size_step_value = 2.0;
+    options.size_list = NULL;
+    options.size_list_len = 0;
+    options.refine_threshold = 0.0;
+    options.adaptive = 0;
+    options.target_ci = ADAPTIVE_TARGET_CI;
+    options.time_budget = ADAPTIVE_TIME_BUDGET;
     options.num_probes = 0;
     options.device_array_size = 32;
     options.target = CPU;
@@ -509,17 +1376,72 @@ int process_options (int argc, char *argv[])
     options.validate = 0;
     options.buf_num = SINGLE;
     options.max_imbalance_factor = 0.0;
+    options.arrival_pattern = ARRIVAL_DEFAULT;
+    options.arrival_rank = -1;
+    options.arrival_trace = NULL;
+    options.persistent = 0;
+    options.thread_comm = THREAD_COMM_SHARED;
+    options.comm_hints = 0;
+    options.partitions = DEF_NUM_PARTITIONS;
+    options.ready_mode = READY_STAGGERED;
+    options.rma_op = RMA_OP_FOP;
+    options.rma_targets = 1;
+    options.table_size = DEF_GUPS_TABLE_SIZE;
+    options.batch = DEF_GUPS_BATCH;
+    options.ddt_types = (1 << DDT_NUM_TYPES) - 1;
+    options.ddt_block = DEF_DDT_BLOCK;
+    options.ddt_stride = 0;
+    options.match_depth = DEF_MATCH_DEPTH;
+    options.wildcards = (1 << MATCH_NUM_WILDCARDS) - 1;
+    options.page_policy = PAGE_DEFAULT;
+    options.numa_policy = NUMA_NONE;
+    options.numa_node = 0;
+    options.prefault = 0;
+    options.cache_state = CACHE_HOT;
+    options.llc_size = 0;
+    options.fresh_buffers = FRESH_NONE;
+    options.fresh_pool_size = DEF_FRESH_POOL_SIZE;
+    options.pin_threads = 0;
+    options.thread_cpus = NULL;
+    options.pairing = PAIRING_BLOCK;
+    options.pairing_seed = 1;
+    options.pairing_map = NULL;
+    options.delay_mode = DELAY_SPIN;
+    options.iteration_sync = ITERATION_SYNC_BARRIER;
+    options.sync_window = 0.0;
+    options.coll_list = NULL;
+    options.output_format = OUTPUT_TEXT;
+    options.output_file = NULL;
+    configure_output();
+    save_output_args(argc, argv);
 
     options.src = 'H';
     options.dst = 'H';
 
     switch (options.subtype) {
+        case BW_MT:
+            options.num_threads = DEF_NUM_THREADS;
+            options.sender_thread = -1;
+        case BW_PART:
+        case BW_DDT:
         case BW:
             options.iterations = BW_LOOP_SMALL;
             options.skip = BW_SKIP_SMALL;
             options.iterations_large = BW_LOOP_LARGE;
             options.skip_large = BW_SKIP_LARGE;
             break;
+        case LAT_WIN:
+            options.iterations = WIN_LOOP;
+            options.skip = WIN_SKIP;
+            options.iterations_large = WIN_LOOP;
+            options.skip_large = WIN_SKIP;
+            break;
+        case GUPS:
+            options.iterations = GUPS_LOOP;
+            options.skip = GUPS_SKIP;
+            options.iterations_large = GUPS_LOOP;
+            options.skip_large = GUPS_SKIP;
+            break;
         case LAT_MT:
             options.num_threads = DEF_NUM_THREADS;
             options.min_message_size = 0;
@@ -529,6 +1451,12 @@ int process_options (int argc, char *argv[])
             options.min_message_size = 0;
             options.sender_processes = DEF_NUM_PROCESSES;
         case LAT_PAP:
+        case LAT_MULTI:
+        case LAT_PART:
+        case LAT_DDT:
+        case LAT_MATCH:
+        case LAT_SHM:
+        case LAT_HOTSPOT:
         case LAT:
         case NBC:
             if (options.bench == COLLECTIVE) {
@@ -568,6 +1496,8 @@ int process_options (int argc, char *argv[])
     while ((c = getopt_long(argc, argv, optstring, long_options, &option_index)) != -1) {
         bad_usage.opt = c;
         bad_usage.optarg = NULL;
+        bad_usage.optname = (c >= LONG_OPT_OUTPUT_FORMAT) ?
+            long_options[option_index].name : NULL;
         bad_usage.message = NULL;
 
         switch(c) {
@@ -576,6 +1506,12 @@ int process_options (int argc, char *argv[])
             case 'v':
                 return PO_VERSION_MESSAGE;
             case 'm':
+                /* these sweep origin counts or table updates, not sizes */
+                if (options.subtype == LAT_HOTSPOT || options.subtype == GUPS) {
+                    bad_usage.message = "Message sizes are not supported by this benchmark";
+                    bad_usage.optarg = optarg;
+                    return PO_BAD_USAGE;
+                }
                 if (set_message_size(optarg)) {
                     bad_usage.message = "Invalid Message Size";
                     bad_usage.optarg = optarg;
@@ -592,7 +1528,7 @@ int process_options (int argc, char *argv[])
                         return PO_BAD_USAGE;
                     }
                 } else if (options.bench == PT2PT) {
-                    if (options.subtype == LAT_MT) {
+                    if (options.subtype == LAT_MT || options.subtype == BW_MT) {
                         if (set_threads(optarg)){
                             bad_usage.message = "Invalid Number of Threads";
                             bad_usage.optarg = optarg;
@@ -656,6 +1592,13 @@ int process_options (int argc, char *argv[])
             case 'f':
                 options.show_full = 1;
                 break;
+            case 'P':
+                if (!percentiles_supported()) {
+                    bad_usage.message = "Percentiles are not supported by this benchmark";
+                    return PO_BAD_USAGE;
+                }
+                options.show_percentiles = 1;
+                break;
             case 'M':
                 /*
                  * This function does not error but prints a warning message if
@@ -765,6 +1708,359 @@ int process_options (int argc, char *argv[])
                     return PO_BAD_USAGE;
                 }
                 break;
+            case LONG_OPT_OUTPUT_FORMAT:
+                if (set_output_format(optarg)) {
+                    bad_usage.message = "Please use text, json or csv for output format";
+                    bad_usage.optarg = optarg;
+                    return PO_BAD_USAGE;
+                }
+                break;
+            case LONG_OPT_OUTPUT_FILE:
+                options.output_file = optarg;
+                break;
+            case LONG_OPT_DELAY_MODE:
+                if (options.subtype != LAT_PAP) {
+                    bad_usage.message = "Delay modes are only supported by the PAP benchmarks";
+                    return PO_BAD_USAGE;
+                } else if (0 == strcmp(optarg, "spin")) {
+                    options.delay_mode = DELAY_SPIN;
+                } else if (0 == strcmp(optarg, "hybrid")) {
+                    options.delay_mode = DELAY_HYBRID;
+                } else if (0 == strcmp(optarg, "sleep")) {
+                    options.delay_mode = DELAY_SLEEP;
+                } else {
+                    bad_usage.message = "Please use spin, hybrid or sleep for delay mode";
+                    bad_usage.optarg = optarg;
+                    return PO_BAD_USAGE;
+                }
+                break;
+            case LONG_OPT_ITERATION_SYNC:
+                if (!iteration_sync_supported()) {
+                    bad_usage.message = "Iteration sync is not supported by this benchmark";
+                    return PO_BAD_USAGE;
+                } else if (set_iteration_sync(optarg)) {
+                    bad_usage.message = "Please use barrier or window[:USEC] for iteration sync";
+                    bad_usage.optarg = optarg;
+                    return PO_BAD_USAGE;
+                }
+                break;
+            case LONG_OPT_TARGET_CI:
+                options.target_ci = atof(optarg);
+                options.adaptive = 1;
+                if (!adaptive_supported()) {
+                    bad_usage.message = "Adaptive iterations are not supported by this benchmark";
+                    bad_usage.optarg = optarg;
+                    return PO_BAD_USAGE;
+                }
+                if (options.target_ci <= 0) {
+                    bad_usage.message = "Invalid confidence interval target";
+                    bad_usage.optarg = optarg;
+                    return PO_BAD_USAGE;
+                }
+                break;
+            case LONG_OPT_TIME_BUDGET:
+                options.time_budget = atof(optarg);
+                options.adaptive = 1;
+                if (!adaptive_supported()) {
+                    bad_usage.message = "Adaptive iterations are not supported by this benchmark";
+                    bad_usage.optarg = optarg;
+                    return PO_BAD_USAGE;
+                }
+                if (options.time_budget <= 0) {
+                    bad_usage.message = "Invalid time budget";
+                    bad_usage.optarg = optarg;
+                    return PO_BAD_USAGE;
+                }
+                break;
+            case LONG_OPT_REFINE:
+                options.refine_threshold = atof(optarg);
+                if (options.refine_threshold <= 0 ||
+                        options.subtype == LAT_MT || options.subtype == LAT_MP ||
+                        options.subtype == BW_MT ||
+                        options.subtype == LAT_MATCH ||
+                        options.subtype == LAT_WIN ||
+                        options.subtype == LAT_HOTSPOT ||
+                        options.subtype == GUPS ||
+                        options.bench == MBW_MR || options.bench == OSHM ||
+                        options.bench == UPC || options.bench == UPCXX) {
+                    bad_usage.message = "Invalid refinement threshold or benchmark";
+                    bad_usage.optarg = optarg;
+                    return PO_BAD_USAGE;
+                }
+                break;
+            case LONG_OPT_THREAD_COMM:
+                if (options.subtype != LAT_MT && options.subtype != BW_MT) {
+                    bad_usage.message = "Per-thread communication is only supported by the multi-threaded benchmarks";
+                    bad_usage.optarg = optarg;
+                    return PO_BAD_USAGE;
+                }
+                if (0 == strcmp(optarg, "shared")) {
+                    options.thread_comm = THREAD_COMM_SHARED;
+                } else if (0 == strcmp(optarg, "tag")) {
+                    options.thread_comm = THREAD_COMM_TAG;
+                } else if (0 == strcmp(optarg, "dup")) {
+                    options.thread_comm = THREAD_COMM_DUP;
+                } else {
+                    bad_usage.message = "Please use shared, tag or dup for thread communication";
+                    bad_usage.optarg = optarg;
+                    return PO_BAD_USAGE;
+                }
+                break;
+            case LONG_OPT_PIN_THREADS:
+                if ((options.subtype != LAT_MT && options.subtype != BW_MT) ||
+                        set_pin_threads(optarg)) {
+                    bad_usage.message = "Please use auto or a list of CPUs to pin the threads of a multi-threaded benchmark";
+                    bad_usage.optarg = optarg;
+                    return PO_BAD_USAGE;
+                }
+                break;
+            case LONG_OPT_COMM_HINTS:
+                if (options.subtype != BW_MT) {
+                    bad_usage.message = "Communicator hints are only supported by osu_mbw_mr_mt";
+                    return PO_BAD_USAGE;
+                }
+                options.comm_hints = 1;
+                break;
+            case LONG_OPT_PARTITIONS:
+                options.partitions = atoi(optarg);
+                if ((options.subtype != LAT_PART && options.subtype != BW_PART) ||
+                        options.partitions < 1 ||
+                        options.partitions > MAX_NUM_PARTITIONS) {
+                    bad_usage.message = "Invalid number of partitions or benchmark";
+                    bad_usage.optarg = optarg;
+                    return PO_BAD_USAGE;
+                }
+                break;
+            case LONG_OPT_READY:
+                if (options.subtype != LAT_PART && options.subtype != BW_PART) {
+                    bad_usage.message = "Partition readiness is only supported by the partitioned benchmarks";
+                    bad_usage.optarg = optarg;
+                    return PO_BAD_USAGE;
+                }
+                if (0 == strcmp(optarg, "threads")) {
+                    options.ready_mode = READY_THREADS;
+                } else if (0 == strcmp(optarg, "staggered")) {
+                    options.ready_mode = READY_STAGGERED;
+                } else {
+                    bad_usage.message = "Please use threads or staggered for partition readiness";
+                    bad_usage.optarg = optarg;
+                    return PO_BAD_USAGE;
+                }
+                break;
+            case LONG_OPT_RMA_OP:
+                if (options.subtype != LAT_HOTSPOT && options.subtype != GUPS) {
+                    bad_usage.message = "RMA operation selection is not supported by this benchmark";
+                    bad_usage.optarg = optarg;
+                    return PO_BAD_USAGE;
+                }
+                if (0 == strcmp(optarg, "fop")) {
+                    options.rma_op = RMA_OP_FOP;
+                } else if (0 == strcmp(optarg, "cas") && GUPS != options.subtype) {
+                    options.rma_op = RMA_OP_CAS;
+                } else if (0 == strcmp(optarg, "acc")) {
+                    options.rma_op = RMA_OP_ACC;
+                } else {
+                    bad_usage.message = GUPS == options.subtype ?
+                        "Please use fop or acc for the RMA operation" :
+                        "Please use fop, cas or acc for the RMA operation";
+                    bad_usage.optarg = optarg;
+                    return PO_BAD_USAGE;
+                }
+                break;
+            case LONG_OPT_TARGETS:
+                options.rma_targets = atoi(optarg);
+                if (options.subtype != LAT_HOTSPOT || options.rma_targets < 1) {
+                    bad_usage.message = "Invalid number of targets or benchmark";
+                    bad_usage.optarg = optarg;
+                    return PO_BAD_USAGE;
+                }
+                break;
+            case LONG_OPT_PAGE_POLICY:
+                if (!host_memory_supported()) {
+                    bad_usage.message = "Host memory placement is not supported by this benchmark";
+                    bad_usage.optarg = optarg;
+                    return PO_BAD_USAGE;
+                }
+                if (0 == strcmp(optarg, "default")) {
+                    options.page_policy = PAGE_DEFAULT;
+                } else if (0 == strcmp(optarg, "thp")) {
+                    options.page_policy = PAGE_THP;
+                } else if (0 == strcmp(optarg, "2m")) {
+                    options.page_policy = PAGE_HUGE_2M;
+                } else if (0 == strcmp(optarg, "1g")) {
+                    options.page_policy = PAGE_HUGE_1G;
+                } else {
+                    bad_usage.message = "Please use default, thp, 2m or 1g for the page policy";
+                    bad_usage.optarg = optarg;
+                    return PO_BAD_USAGE;
+                }
+                break;
+            case LONG_OPT_NUMA:
+                if (!host_memory_supported()) {
+                    bad_usage.message = "Host memory placement is not supported by this benchmark";
+                    bad_usage.optarg = optarg;
+                    return PO_BAD_USAGE;
+                }
+                if (0 == strcmp(optarg, "local")) {
+                    options.numa_policy = NUMA_LOCAL;
+                } else if (0 == strcmp(optarg, "remote")) {
+                    options.numa_policy = NUMA_REMOTE;
+                } else if (0 == strcmp(optarg, "interleave")) {
+                    options.numa_policy = NUMA_INTERLEAVE;
+                } else if (isdigit((unsigned char)optarg[0])) {
+                    options.numa_policy = NUMA_NODE;
+                    options.numa_node = atoi(optarg);
+                } else {
+                    bad_usage.message = "Please use local, remote, interleave or a node number for NUMA placement";
+                    bad_usage.optarg = optarg;
+                    return PO_BAD_USAGE;
+                }
+                break;
+            case LONG_OPT_PREFAULT:
+                if (!host_memory_supported()) {
+                    bad_usage.message = "Host memory placement is not supported by this benchmark";
+                    bad_usage.optarg = optarg;
+                    return PO_BAD_USAGE;
+                }
+                options.prefault = 1;
+                break;
+            case LONG_OPT_CACHE:
+                if (!cache_supported()) {
+                    bad_usage.message = "Cache state selection is not supported by this benchmark";
+                    bad_usage.optarg = optarg;
+                    return PO_BAD_USAGE;
+                }
+                if (0 == strcmp(optarg, "hot")) {
+                    options.cache_state = CACHE_HOT;
+                } else if (0 == strcmp(optarg, "flush")) {
+                    options.cache_state = CACHE_FLUSH;
+                } else if (0 == strncmp(optarg, "cold", 4) &&
+                        ('\0' == optarg[4] || (':' == optarg[4] &&
+                        0 < atoll(optarg + 5)))) {
+                    options.cache_state = CACHE_COLD;
+                    options.llc_size = optarg[4] ? atoll(optarg + 5) : 0;
+                } else {
+                    bad_usage.message = "Please use hot, cold[:LLC_BYTES] or flush for the cache state";
+                    bad_usage.optarg = optarg;
+                    return PO_BAD_USAGE;
+                }
+                break;
+            case LONG_OPT_FRESH_BUFFERS:
+                if (!cache_supported()) {
+                    bad_usage.message = "Fresh buffers are not supported by this benchmark";
+                    bad_usage.optarg = optarg;
+                    return PO_BAD_USAGE;
+                }
+                if (0 == strcmp(optarg, "malloc")) {
+                    options.fresh_buffers = FRESH_MALLOC;
+                } else if (0 == strcmp(optarg, "mmap")) {
+                    options.fresh_buffers = FRESH_MMAP;
+                } else if (0 == strncmp(optarg, "pool", 4) &&
+                        ('\0' == optarg[4] || (':' == optarg[4] &&
+                        0 < atoll(optarg + 5)))) {
+                    options.fresh_buffers = FRESH_POOL;
+                    if (optarg[4]) {
+                        options.fresh_pool_size = atoll(optarg + 5);
+                    }
+                } else {
+                    bad_usage.message = "Please use malloc, mmap or pool[:BYTES] for fresh buffers";
+                    bad_usage.optarg = optarg;
+                    return PO_BAD_USAGE;
+                }
+                break;
+            case LONG_OPT_DDT:
+                if ((options.subtype != LAT_DDT && options.subtype != BW_DDT) ||
+                        set_name_list(optarg, ddt_names, DDT_NUM_TYPES,
+                            &options.ddt_types)) {
+                    bad_usage.message = "Please use a comma-separated list of vector, indexed, subarray and struct";
+                    bad_usage.optarg = optarg;
+                    return PO_BAD_USAGE;
+                }
+                break;
+            case LONG_OPT_BLOCK:
+                options.ddt_block = atoll(optarg);
+                if ((options.subtype != LAT_DDT && options.subtype != BW_DDT) ||
+                        options.ddt_block < 1 ||
+                        options.ddt_block > INT_MAX) {
+                    bad_usage.message = "Invalid block size or benchmark";
+                    bad_usage.optarg = optarg;
+                    return PO_BAD_USAGE;
+                }
+                break;
+            case LONG_OPT_STRIDE:
+                options.ddt_stride = atoll(optarg);
+                if ((options.subtype != LAT_DDT && options.subtype != BW_DDT) ||
+                        options.ddt_stride < 1 ||
+                        options.ddt_stride > INT_MAX) {
+                    bad_usage.message = "Invalid stride or benchmark";
+                    bad_usage.optarg = optarg;
+                    return PO_BAD_USAGE;
+                }
+                break;
+            case LONG_OPT_DEPTH:
+                options.match_depth = atoi(optarg);
+                if (options.subtype != LAT_MATCH || options.match_depth < 1) {
+                    bad_usage.message = "Invalid queue depth or benchmark";
+                    bad_usage.optarg = optarg;
+                    return PO_BAD_USAGE;
+                }
+                break;
+            case LONG_OPT_WILDCARD:
+                if (options.subtype != LAT_MATCH ||
+                        set_name_list(optarg, wildcard_names,
+                            MATCH_NUM_WILDCARDS, &options.wildcards)) {
+                    bad_usage.message = "Please use a comma-separated list of none, source and tag";
+                    bad_usage.optarg = optarg;
+                    return PO_BAD_USAGE;
+                }
+                break;
+            case LONG_OPT_TABLE_SIZE:
+                options.table_size = atoll(optarg);
+                if (options.subtype != GUPS || options.table_size < sizeof(uint64_t)) {
+                    bad_usage.message = "Invalid table size or benchmark";
+                    bad_usage.optarg = optarg;
+                    return PO_BAD_USAGE;
+                }
+                break;
+            case LONG_OPT_BATCH:
+                options.batch = atoi(optarg);
+                if (options.subtype != GUPS || options.batch < 1) {
+                    bad_usage.message = "Invalid batch size or benchmark";
+                    bad_usage.optarg = optarg;
+                    return PO_BAD_USAGE;
+                }
+                break;
+            case LONG_OPT_PERSISTENT:
+                if (!persistent_supported()) {
+                    bad_usage.message = "Persistent requests are not supported by this benchmark";
+                    return PO_BAD_USAGE;
+                }
+                options.persistent = 1;
+                break;
+            case LONG_OPT_PAIRING:
+                if (!pairing_supported()) {
+                    bad_usage.message = "Pair placement is not supported by this benchmark";
+                    bad_usage.optarg = optarg;
+                    return PO_BAD_USAGE;
+                }
+                if (set_pairing(optarg)) {
+                    bad_usage.message = "Please use block, intra-socket, cross-socket, cross-node, random[:SEED] or map:FILE for pairing";
+                    bad_usage.optarg = optarg;
+                    return PO_BAD_USAGE;
+                }
+                break;
+            case 'l':
+                options.coll_list = optarg;
+                break;
+            case 'A':
+                if (options.subtype != LAT_PAP ||
+                        set_arrival_pattern(optarg)) {
+                    bad_usage.message = "Invalid arrival pattern or benchmark";
+                    bad_usage.optarg = optarg;
+
+                    return PO_BAD_USAGE;
+                }
+                break;
             case 'F':
                 if (options.bench == COLLECTIVE && options.subtype == LAT_PAP) {
                     if(set_max_imbalace_factor((double) atoi(optarg))){
@@ -786,6 +2082,43 @@ int process_options (int argc, char *argv[])
         }
     }
 
+    if (0 == options.ddt_stride) {
+        options.ddt_stride = 2 * options.ddt_block;
+    } else if (options.ddt_stride < options.ddt_block) {
+        bad_usage.message = "The stride must not be smaller than the block";
+        bad_usage.opt = LONG_OPT_STRIDE;
+        bad_usage.optname = "stride";
+        bad_usage.optarg = NULL;
+        return PO_BAD_USAGE;
+    }
+
+    if (FRESH_NONE != options.fresh_buffers &&
+            (NONE != options.accel || options.persistent)) {
+        bad_usage.message = "Fresh buffers need host memory and no persistent requests";
+        bad_usage.opt = LONG_OPT_FRESH_BUFFERS;
+        bad_usage.optname = "fresh-buffers";
+        bad_usage.optarg = FRESH_POOL == options.fresh_buffers ? "pool" :
+            FRESH_MMAP == options.fresh_buffers ? "mmap" : "malloc";
+        return PO_BAD_USAGE;
+    }
+
+    if (CACHE_HOT != options.cache_state &&
+            (NONE != options.accel || options.persistent)) {
+        bad_usage.message = "A cold cache pass needs host buffers and no persistent requests";
+        bad_usage.opt = LONG_OPT_CACHE;
+        bad_usage.optname = "cache";
+        bad_usage.optarg = CACHE_COLD == options.cache_state ? "cold" : "flush";
+        return PO_BAD_USAGE;
+    }
+
+    if (ITERATION_SYNC_WINDOW == options.iteration_sync && options.validate) {
+        bad_usage.message = "Window synchronization cannot be combined with validation";
+        bad_usage.opt = LONG_OPT_ITERATION_SYNC;
+        bad_usage.optname = "iteration-sync";
+        bad_usage.optarg = "window";
+        return PO_BAD_USAGE;
+    }
+
     if (accel_enabled) {
         if ((optind + 2) == argc) {
             options.src = argv[optind][0];
@@ -880,26 +2213,313 @@ int setAccel(char buf_type)
 }
 
 
-double getMicrosecondTimeStamp()
+/*
+ * All benchmark timestamps go through one clock chosen by init_timer(): the
+ * TSC when the CPU reports it as invariant and two calibration windows
+ * against CLOCK_MONOTONIC agree, otherwise clock_gettime(CLOCK_MONOTONIC).
+ * OMB_TIMER=tsc|clock_gettime overrides the choice.  The resolution and
+ * call overhead of the chosen clock are measured once so that short timed
+ * regions can be batched and corrected.
+ */
+#define TIMER_CALIBRATION_NS 10000000L
+#define TIMER_PROBES 1000
+
+static int timer_initialized = 0;
+static int timer_use_tsc = 0;
+static double timer_ticks_per_sec = 1e9;
+static uint64_t timer_base = 0;
+static double timer_resolution_us = 0.0;
+static double timer_overhead_us = 0.0;
+
+static uint64_t monotonic_ns (void)
 {
-    double retval;
-    struct timeval tv;
-    if (gettimeofday(&tv, NULL)) {
-        perror("gettimeofday");
-        abort();
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static inline uint64_t timer_ticks (void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    if (timer_use_tsc) {
+        return __rdtsc();
     }
-    retval = ((double)tv.tv_sec) * 1000000 + tv.tv_usec;
-    return retval;
+#endif
+    return monotonic_ns();
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+static int tsc_invariant (void)
+{
+    unsigned int eax, ebx, ecx, edx;
+
+    if (!__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx)) {
+        return 0;
+    }
+
+    return (edx >> 8) & 1;
+}
+
+static double measure_tsc_rate (void)
+{
+    uint64_t ns_start, ns_end, tsc_start, tsc_end;
+
+    ns_start = monotonic_ns();
+    tsc_start = __rdtsc();
+    do {
+        ns_end = monotonic_ns();
+    } while (ns_end - ns_start < TIMER_CALIBRATION_NS);
+    tsc_end = __rdtsc();
+
+    return (tsc_end - tsc_start) * 1e9 / (ns_end - ns_start);
+}
+#endif
+
+void init_timer (void)
+{
+    char const * str = getenv("OMB_TIMER");
+    int want_tsc = (NULL == str || !strcmp(str, "tsc"));
+    uint64_t prev, now, step, min_step = UINT64_MAX;
+    double start;
+    int i;
+
+    timer_use_tsc = 0;
+    timer_ticks_per_sec = 1e9;
+
+    if (NULL != str && !want_tsc && strcmp(str, "clock_gettime")) {
+        fprintf(stderr, "Warning: unknown OMB_TIMER \"%s\", "
+                "use tsc or clock_gettime\n", str);
+    }
+
+#if defined(__x86_64__) || defined(__i386__)
+    if (want_tsc && tsc_invariant()) {
+        double rate1 = measure_tsc_rate();
+        double rate2 = measure_tsc_rate();
+
+        /* reject a TSC that drifts between two calibration windows */
+        if (rate1 > 0 && fabs(rate1 - rate2) < 0.001 * rate1) {
+            timer_use_tsc = 1;
+            timer_ticks_per_sec = (rate1 + rate2) / 2;
+        }
+    }
+#endif
+
+    if (NULL != str && want_tsc && !timer_use_tsc) {
+        fprintf(stderr, "Warning: OMB_TIMER=tsc needs an invariant, stable "
+                "TSC, using clock_gettime\n");
+    }
+
+    timer_base = timer_ticks();
+    timer_initialized = 1;
+
+    /* smallest non-zero step and average cost of back-to-back reads */
+    prev = timer_ticks();
+    for (i = 0; i < TIMER_PROBES; i++) {
+        now = timer_ticks();
+        step = now - prev;
+        if (step > 0 && step < min_step) {
+            min_step = step;
+        }
+        prev = now;
+    }
+
+    start = timer_now();
+    for (i = 0; i < TIMER_PROBES; i++) {
+        timer_now();
+    }
+    timer_overhead_us = (timer_now() - start) / (TIMER_PROBES + 1);
+    timer_resolution_us = min_step == UINT64_MAX ? timer_overhead_us :
+        min_step * 1e6 / timer_ticks_per_sec;
+}
+
+double timer_now (void)
+{
+    if (!timer_initialized) {
+        init_timer();
+    }
+
+    return (timer_ticks() - timer_base) * 1e6 / timer_ticks_per_sec;
+}
+
+double timer_resolution (void)
+{
+    return timer_resolution_us;
+}
+
+double timer_overhead (void)
+{
+    return timer_overhead_us;
+}
+
+double timer_elapsed (double begin, double end)
+{
+    return MAX(end - begin - timer_overhead_us, timer_resolution_us);
+}
+
+unsigned long timer_batch (double elapsed, unsigned long batch)
+{
+    double span = TIMER_BATCH_SPAN * MAX(timer_resolution_us,
+            timer_overhead_us);
+    double needed;
+
+    if (elapsed >= span) {
+        return batch;
+    }
+
+    needed = elapsed > 0 ? ceil(batch * span / elapsed) : TIMER_BATCH_MAX;
+
+    return (unsigned long)MIN(needed, TIMER_BATCH_MAX);
+}
+
+char const * timer_description (void)
+{
+    static char description[128];
+
+    if (!timer_initialized) {
+        init_timer();
+    }
+
+    if (timer_use_tsc) {
+        snprintf(description, sizeof(description),
+                "invariant TSC at %.3f GHz, resolution %.1f ns, overhead "
+                "%.1f ns", timer_ticks_per_sec * 1e-9,
+                timer_resolution_us * 1e3, timer_overhead_us * 1e3);
+    } else {
+        snprintf(description, sizeof(description),
+                "clock_gettime(CLOCK_MONOTONIC), resolution %.1f ns, "
+                "overhead %.1f ns", timer_resolution_us * 1e3,
+                timer_overhead_us * 1e3);
+    }
+
+    return description;
+}
+
+
+/*
+ * Sense-reversing barrier for the threads of one process.  Waiting threads
+ * spin instead of sleeping on a condition variable, so the wake-up latency
+ * of the scheduler does not end up between message sizes.
+ */
+void spin_barrier_init (struct spin_barrier * barrier, int count)
+{
+    barrier->count = count;
+    barrier->arrived = 0;
+    barrier->sense = 0;
+}
+
+void spin_barrier_wait (struct spin_barrier * barrier, int * local_sense)
+{
+    int sense = !*local_sense;
+
+    *local_sense = sense;
+
+    if (__atomic_add_fetch(&barrier->arrived, 1, __ATOMIC_ACQ_REL) ==
+            barrier->count) {
+        __atomic_store_n(&barrier->arrived, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&barrier->sense, sense, __ATOMIC_RELEASE);
+        return;
+    }
+
+    while (__atomic_load_n(&barrier->sense, __ATOMIC_ACQUIRE) != sense) {
+        cpu_relax();
+    }
+}
+
+/* one iteration of a busy-wait loop */
+void cpu_relax (void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#endif
+}
+
+
+/*
+ * Injected delays busy-wait on the clock calibrated by init_timer().  The
+ * hybrid mode sleeps for the part of the delay that nanosleep can cover
+ * without overshooting and spins for the rest.
+ */
+#define DELAY_SLEEP_PROBE_NS 50000L
+#define DELAY_SLEEP_PROBES 5
+
+static double delay_sleep_overshoot = 0.0;
+
+void init_delay (void)
+{
+    struct timespec req = {0, DELAY_SLEEP_PROBE_NS};
+    uint64_t start;
+    double overshoot;
+    int i;
+
+    if (!timer_initialized) {
+        init_timer();
+    }
+
+    delay_sleep_overshoot = 0.0;
+    if (DELAY_HYBRID == options.delay_mode) {
+        for (i = 0; i < DELAY_SLEEP_PROBES; i++) {
+            start = monotonic_ns();
+            nanosleep(&req, NULL);
+            overshoot = (monotonic_ns() - start - DELAY_SLEEP_PROBE_NS) *
+                1e-9;
+            delay_sleep_overshoot = MAX(delay_sleep_overshoot, overshoot);
+        }
+    }
+}
+
+void inject_delay (double seconds)
+{
+    uint64_t start, end;
+    double sleep_time;
+    struct timespec req;
+
+    if (seconds <= 0) {
+        return;
+    }
+
+    if (DELAY_SLEEP == options.delay_mode) {
+        usleep((useconds_t)(seconds * 1e6));
+        return;
+    }
+
+    start = timer_ticks();
+    end = start + (uint64_t)(seconds * timer_ticks_per_sec);
+
+    sleep_time = seconds - 2 * delay_sleep_overshoot;
+    if (DELAY_HYBRID == options.delay_mode && sleep_time > 0) {
+        req.tv_sec = (time_t)sleep_time;
+        req.tv_nsec = (long)((sleep_time - req.tv_sec) * 1e9);
+        nanosleep(&req, NULL);
+    }
+
+    while (timer_ticks() < end) {
+        cpu_relax();
+    }
+}
+
+char const * delay_description (void)
+{
+    switch (options.delay_mode) {
+        case DELAY_SLEEP:
+            return "usleep";
+        case DELAY_HYBRID:
+            return timer_use_tsc ? "nanosleep then spin on TSC" :
+                "nanosleep then spin on clock_gettime";
+        default:
+            return timer_use_tsc ? "spin on TSC" : "spin on clock_gettime";
+    }
+}
+
+double getMicrosecondTimeStamp()
+{
+    return timer_now();
 }
 
 void wtime(double *t)
 {
-    static int sec = -1;
-    struct timeval tv;
-    //gettimeofday(&tv, (void *)0);
-    gettimeofday(&tv, 0);
-    if (sec < 0) sec = tv.tv_sec;
-    *t = (tv.tv_sec - sec)*1.0e+6 + tv.tv_usec;
+    *t = timer_now();
 }
 
 
@@ -21,13 +21,17 @@
 #include <stdio.h>
 #include <math.h>
 #include <string.h>
+#include <strings.h>
+#include <ctype.h>
 #include <stdint.h>
 #include <getopt.h>
 #include <pthread.h>
 #include <inttypes.h>
 #include <sys/time.h>
 #include <limits.h>
+#include <float.h>
 #include <sys/types.h>
+#include <time.h>
 
 #ifdef _ENABLE_CUDA_
 #include "cuda.h"
@@ -129,7 +133,7 @@ do {                                                                    \
 } while (0)
 #endif
 
-#define TIME() getMicrosecondTimeStamp()
+#define TIME() timer_now()
 double getMicrosecondTimeStamp();
 
 void print_header_coll (int rank, int full) __attribute__((unused));
@@ -138,6 +142,19 @@ void print_data (int rank, int full, int size, double avg_time, double
 min_time, double max_time, int iterations) __attribute__((unused));
 void print_data_nbc (int rank, int full, int size, double ovrl, double
 cpu, double comm, double wait, double init, int iterations);
+void print_header_percentiles (void);
+void print_host_memory_policy (void);
+void print_header_cache (void);
+void print_cache_state (void);
+size_t cache_llc_size (void);
+int cache_supported (void);
+int adaptive_supported (void);
+int percentiles_supported (void);
+int pairing_supported (void);
+int persistent_supported (void);
+int iteration_sync_supported (void);
+int host_memory_supported (void);
+int omb_take_result (int *size, double *value);
 
 void allocate_host_arrays();
 
@@ -160,6 +177,10 @@ enum mpi_req{
 #define LAT_SKIP_SMALL 100
 #define LAT_LOOP_LARGE 1000
 #define LAT_SKIP_LARGE 10
+#define WIN_LOOP 100
+#define WIN_SKIP 10
+#define GUPS_LOOP 65536
+#define GUPS_SKIP 1024
 #define COLL_LOOP_SMALL 1000
 #define COLL_SKIP_SMALL 100
 #define COLL_LOOP_LARGE 100
@@ -171,6 +192,9 @@ enum mpi_req{
 #define OSHM_LOOP_SMALL_MR 500
 #define OSHM_LOOP_LARGE_MR 50
 #define OSHM_LOOP_ATOMIC 500
+#define ADAPTIVE_MIN_ITERATIONS 32
+#define ADAPTIVE_TARGET_CI 1.0
+#define ADAPTIVE_TIME_BUDGET 10.0
 
 #define MAX_MESSAGE_SIZE (1 << 22)
 #define MAX_MSG_SIZE_PT2PT (1<<20)
@@ -179,6 +203,7 @@ enum mpi_req{
 #define LARGE_MESSAGE_SIZE 8192
 
 #define MAX_ALIGNMENT 65536
+
 #define MAX_MEM_LIMIT (512*1024*1024)
 #define MAX_MEM_LOWER_LIMIT (1*1024*1024)
 #define WINDOW_SIZE_LARGE 64
@@ -225,10 +250,126 @@ enum test_subtype {
     LAT,
     LAT_MT,
     LAT_MP,
+    BW_MT,
+    LAT_PART,
+    BW_PART,
+    LAT_WIN,
+    LAT_SHM,
+    LAT_HOTSPOT,
+    GUPS,
+    LAT_DDT,
+    BW_DDT,
+    LAT_MATCH,
     LAT_PAP,
+    LAT_MULTI,
     NBC,
 };
 
+/* what a benchmark supports beyond its type, set before process_options */
+enum bench_feature {
+    FEATURE_ITERATION_SYNC = 1 << 0,
+    FEATURE_PAIRING = 1 << 1,
+    FEATURE_CACHE = 1 << 2
+};
+
+enum delay_mode {
+    DELAY_SPIN,
+    DELAY_HYBRID,
+    DELAY_SLEEP
+};
+
+enum size_step {
+    SIZE_STEP_DOUBLE,
+    SIZE_STEP_LINEAR,
+    SIZE_STEP_GEOMETRIC,
+    SIZE_STEP_LIST
+};
+
+enum iteration_sync {
+    ITERATION_SYNC_BARRIER,
+    ITERATION_SYNC_WINDOW
+};
+
+enum thread_comm {
+    THREAD_COMM_SHARED,
+    THREAD_COMM_TAG,
+    THREAD_COMM_DUP
+};
+
+enum ready_mode {
+    READY_THREADS,
+    READY_STAGGERED
+};
+
+enum page_policy {
+    PAGE_DEFAULT,
+    PAGE_THP,
+    PAGE_HUGE_2M,
+    PAGE_HUGE_1G
+};
+
+enum numa_policy {
+    NUMA_NONE,
+    NUMA_LOCAL,
+    NUMA_REMOTE,
+    NUMA_INTERLEAVE,
+    NUMA_NODE
+};
+
+enum cache_state {
+    CACHE_HOT,
+    CACHE_COLD,
+    CACHE_FLUSH
+};
+
+enum fresh_buffers {
+    FRESH_NONE,
+    FRESH_MALLOC,
+    FRESH_MMAP,
+    FRESH_POOL
+};
+
+enum ddt_type {
+    DDT_VECTOR,
+    DDT_INDEXED,
+    DDT_SUBARRAY,
+    DDT_STRUCT,
+    DDT_NUM_TYPES
+};
+
+enum match_wildcard {
+    MATCH_EXACT,
+    MATCH_ANY_SOURCE,
+    MATCH_ANY_TAG,
+    MATCH_NUM_WILDCARDS
+};
+
+enum rma_op {
+    RMA_OP_FOP,
+    RMA_OP_CAS,
+    RMA_OP_ACC
+};
+
+enum pairing {
+    PAIRING_BLOCK,
+    PAIRING_INTRA_SOCKET,
+    PAIRING_CROSS_SOCKET,
+    PAIRING_CROSS_NODE,
+    PAIRING_RANDOM,
+    PAIRING_MAP
+};
+
+enum arrival_pattern {
+    ARRIVAL_DEFAULT,
+    ARRIVAL_UNIFORM,
+    ARRIVAL_NORMAL,
+    ARRIVAL_EXPONENTIAL,
+    ARRIVAL_PARETO,
+    ARRIVAL_LATE,
+    ARRIVAL_NODE,
+    ARRIVAL_TRACE
+};
+
 enum test_synctype {
     ALL_SYNC,
     ACTIVE_SYNC
@@ -259,17 +400,66 @@ enum buffer_num {
     MULTIPLE
 };
 
+enum output_format {
+    OUTPUT_TEXT,
+    OUTPUT_JSON,
+    OUTPUT_CSV
+};
+
+/* Long-only options, numbered past the range of short option characters */
+enum long_opt {
+    LONG_OPT_OUTPUT_FORMAT = 256,
+    LONG_OPT_OUTPUT_FILE,
+    LONG_OPT_DELAY_MODE,
+    LONG_OPT_ITERATION_SYNC,
+    LONG_OPT_TARGET_CI,
+    LONG_OPT_TIME_BUDGET,
+    LONG_OPT_REFINE,
+    LONG_OPT_PAIRING,
+    LONG_OPT_PERSISTENT,
+    LONG_OPT_THREAD_COMM,
+    LONG_OPT_PIN_THREADS,
+    LONG_OPT_COMM_HINTS,
+    LONG_OPT_PARTITIONS,
+    LONG_OPT_READY,
+    LONG_OPT_RMA_OP,
+    LONG_OPT_TARGETS,
+    LONG_OPT_TABLE_SIZE,
+    LONG_OPT_BATCH,
+    LONG_OPT_PAGE_POLICY,
+    LONG_OPT_NUMA,
+    LONG_OPT_PREFAULT,
+    LONG_OPT_CACHE,
+    LONG_OPT_FRESH_BUFFERS,
+    LONG_OPT_DDT,
+    LONG_OPT_BLOCK,
+    LONG_OPT_STRIDE,
+    LONG_OPT_DEPTH,
+    LONG_OPT_WILDCARD,
+};
+
 /*variables*/
 extern char const *win_info[20];
 extern char const *sync_info[20];
+extern char const *ddt_names[];
+extern char const *wildcard_names[];
 
 struct options_t {
     enum accel_type accel;
     enum target_type target;
     int show_size;
     int show_full;
+    int show_percentiles;
+    int adaptive;
+    double target_ci;
+    double time_budget;
     size_t min_message_size;
     size_t max_message_size;
+    enum size_step size_step;
+    double size_step_value;
+    size_t *size_list;
+    int size_list_len;
+    double refine_threshold;
     size_t iterations;
     size_t iterations_large;
     size_t max_mem_limit;
@@ -281,6 +471,7 @@ struct options_t {
 
     enum benchmark_type bench;
     enum test_subtype  subtype;
+    unsigned features;
     enum test_synctype synctype;
 
     char src;
@@ -291,6 +482,29 @@ struct options_t {
 
     int num_threads;
     int sender_thread;
+    enum thread_comm thread_comm;
+    int comm_hints;
+    int partitions;
+    enum ready_mode ready_mode;
+    enum rma_op rma_op;
+    int rma_targets;
+    size_t table_size;
+    int batch;
+    int ddt_types;
+    size_t ddt_block;
+    size_t ddt_stride;
+    int match_depth;
+    int wildcards;
+    enum page_policy page_policy;
+    enum numa_policy numa_policy;
+    int numa_node;
+    int prefault;
+    enum cache_state cache_state;
+    size_t llc_size;
+    enum fresh_buffers fresh_buffers;
+    size_t fresh_pool_size;
+    int pin_threads;
+    char const * thread_cpus;
     int num_processes;
     int sender_processes;
     char managedSend;
@@ -302,14 +516,28 @@ struct options_t {
     int window_varied;
     int print_rate;
     int pairs;
+    int persistent;
+    enum pairing pairing;
+    unsigned long pairing_seed;
+    char const * pairing_map;
     int validate;
     enum buffer_num buf_num;
     double max_imbalance_factor;
+    enum arrival_pattern arrival_pattern;
+    int arrival_rank;
+    char const * arrival_trace;
+    enum delay_mode delay_mode;
+    enum iteration_sync iteration_sync;
+    double sync_window;
+    char const * coll_list;
+    enum output_format output_format;
+    char const * output_file;
 };
 
 struct bad_usage_t{
     char const * message;
     char const * optarg;
+    char const * optname;
     int opt;
 };
 
@@ -331,12 +559,79 @@ int setAccel(char);
  */
 void set_header (const char * header);
 void set_benchmark_name (const char * name);
+void set_num_ranks (int num_ranks);
 void enable_accel_support (void);
 
+/*
+ * Machine-Readable Output
+ */
+int set_output_format (const char * format);
+void omb_result_begin (int size, size_t iterations);
+void omb_result_field (const char * name, double value);
+void omb_result_metric (const char * name, double value);
+void omb_result_end (void);
+void print_result (int size, const char * name, double value);
+
+/*
+ * Timer
+ */
+#define TIMER_BATCH_SPAN 1000
+#define TIMER_BATCH_MAX 1024
+
+void init_timer (void);
+double timer_now (void);
+double timer_resolution (void);
+double timer_overhead (void);
+double timer_elapsed (double begin, double end);
+unsigned long timer_batch (double elapsed, unsigned long batch);
+char const * timer_description (void);
+
+/*
+ * Thread Synchronization
+ */
+struct spin_barrier {
+    int count;
+    int arrived;
+    int sense;
+};
+
+void spin_barrier_init (struct spin_barrier * barrier, int count);
+void spin_barrier_wait (struct spin_barrier * barrier, int * local_sense);
+void cpu_relax (void);
+
+/*
+ * Delay Injection
+ */
+void init_delay (void);
+void inject_delay (double seconds);
+char const * delay_description (void);
+
 #define DEF_NUM_THREADS 2
 #define MIN_NUM_THREADS 1
 #define MAX_NUM_THREADS 128
 
+#define DEF_NUM_PARTITIONS 8
+#define MAX_NUM_PARTITIONS 1024
+
+#define DEF_GUPS_TABLE_SIZE (1 << 23)
+#define DEF_GUPS_BATCH 64
+
+#define DEF_DDT_BLOCK 8
+#define DEF_MATCH_DEPTH 4096
+
+/* assumed last-level cache size when neither sysconf nor sysfs report one */
+#define DEF_LLC_SIZE (32 * 1024 * 1024)
+
+/* fresh-buffer pool, meant to exceed the registration cache of the library */
+#define DEF_FRESH_POOL_SIZE (1024 * 1024 * 1024)
+
+/* user-level instruction that evicts a line from every cache level */
+#if defined(__SSE2__)
+#define CACHE_FLUSH_INSN "clflush"
+#elif defined(__aarch64__)
+#define CACHE_FLUSH_INSN "dc civac"
+#endif
+
 #define DEF_NUM_PROCESSES 2
 #define MIN_NUM_PROCESSES 1
 #define MAX_NUM_PROCESSES 128
@@ -8,7 +8,15 @@
  * copyright file COPYRIGHT in the top level directory.
  */
 
+#define _GNU_SOURCE
 #include "osu_util_mpi.h"
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 MPI_Request request[MAX_REQ_NUM];
 MPI_Status  reqstat[MAX_REQ_NUM];
@@ -28,6 +36,101 @@ MPI_Aint disp_local;
 #define DIM 25
 static float **a, *x, *y;
 
+/*
+ * Per-iteration latency samples are binned into a log-linear histogram with
+ * LAT_HIST_SUB bins per power of two, covering 2^LAT_HIST_MIN_EXP us up to
+ * 2^(LAT_HIST_MIN_EXP + LAT_HIST_OCTAVES) us, plus an underflow and an
+ * overflow bin.  The histogram travels together with count/sum/min/max so
+ * that one MPI_Reduce is enough to aggregate all ranks.
+ */
+#define LAT_HIST_SUB_BITS 3
+#define LAT_HIST_SUB (1 << LAT_HIST_SUB_BITS)
+#define LAT_HIST_MIN_EXP (-4)
+#define LAT_HIST_OCTAVES 28
+#define LAT_HIST_BINS (LAT_HIST_OCTAVES * LAT_HIST_SUB + 2)
+
+#define LAT_STAT_COUNT 0
+#define LAT_STAT_SUM 1
+#define LAT_STAT_MIN 2
+#define LAT_STAT_MAX 3
+#define LAT_STAT_HIST 4
+#define LAT_STAT_LEN (LAT_STAT_HIST + LAT_HIST_BINS)
+
+static double *lat_samples = NULL;
+static size_t lat_samples_max = 0, lat_samples_count = 0;
+static double lat_stats[LAT_STAT_LEN];
+static MPI_Datatype lat_stats_type = MPI_DATATYPE_NULL;
+static MPI_Op lat_stats_op = MPI_OP_NULL;
+
+/*
+ * In adaptive mode every rank keeps a running mean and variance (Welford) of
+ * its timed iterations.  The iteration count starts at
+ * ADAPTIVE_MIN_ITERATIONS and grows by a quarter at each checkpoint until the
+ * 95% confidence interval of every rank's mean is within options.target_ci
+ * percent, or the time budget of the message size is spent.
+ */
+#define ADAPTIVE_Z95 1.96
+
+static struct {
+    double count;
+    double mean;
+    double m2;
+    double start;
+    double ci;
+} adaptive_state;
+
+/*
+ * Iterations separated by a barrier start as skewed as the barrier exits.
+ * With --iteration-sync=window every rank instead starts iteration k at the
+ * agreed global time start + k * length.  The warmup iterations still use
+ * the barrier and measure how long an iteration takes; at the end of the
+ * warmup the ranks agree on the window length (twice the slowest average
+ * iteration plus the clock error, unless given) and the first start time.
+ * A rank that reaches a window after its start marks that iteration missed.
+ */
+#define SYNC_WINDOW_SCALE 2.0
+#define SYNC_WINDOW_DEFAULT 1e-3
+
+static struct {
+    double start;
+    double length;
+    double last;
+    double period_sum;
+    int period_count;
+    int calls;
+    unsigned char *missed;
+    unsigned char *missed_any;
+    size_t missed_len;
+    double missed_pct;
+} sync_state;
+
+/*
+ * With --cache cold or flush every message size gets a second, cold pass.
+ * In cold mode each of its iterations takes fresh buffers from a pool of at
+ * least twice the last-level cache, so a buffer has been evicted by the time
+ * it is reused. In flush mode the usual buffers are evicted before each
+ * iteration, by CACHE_FLUSH_INSN or, lacking one, by writing the pool.
+ *
+ * --fresh-buffers adds a pass whose buffers are used for the first time in
+ * every iteration, so the registration cache of the library misses: they
+ * come from malloc or mmap and are kept until the end of the pass, so that
+ * no address comes back within it, or until they hold options.max_mem_limit
+ * bytes, when the oldest are released. Otherwise they rotate through the
+ * same pool, sized to exceed the registration cache.
+ */
+static struct {
+    char *base;
+    size_t len;
+    double latency;
+    double fresh_latency;
+    void **fresh;
+    size_t *fresh_len;
+    size_t fresh_held;
+    int fresh_first;
+    int fresh_count;
+    int fresh_max;
+} cache_pool;
+
 #ifdef _ENABLE_CUDA_
 CUcontext cuContext;
 #endif
@@ -131,6 +234,15 @@ void *align_buffer (void * ptr, unsigned long align_size)
 }
 
 
+static void print_help_host_memory (void)
+{
+    fprintf(stdout, "  --page-policy POLICY        back host buffers with default pages, transparent huge\n");
+    fprintf(stdout, "                              pages (thp), or 2M or 1G hugetlbfs pages (2m, 1g)\n");
+    fprintf(stdout, "  --numa NODE                 bind host buffers to the local or remote NUMA node,\n");
+    fprintf(stdout, "                              interleave them over all nodes, or use node NODE\n");
+    fprintf(stdout, "  --prefault                  fault in every page of the host buffers at allocation\n");
+}
+
 void usage_one_sided (char const * name)
 {
     if (accel_enabled) {
@@ -151,49 +263,84 @@ void usage_one_sided (char const * name)
     }
     fprintf(stdout, "\n");
 
+    if (options.subtype != LAT_WIN && options.subtype != LAT_SHM &&
+        options.subtype != LAT_HOTSPOT) {
 #if MPI_VERSION >= 3
-    fprintf(stdout, "  -w --win-option <win_option>\n");
-    fprintf(stdout, "            <win_option> can be any of the follows:\n");
-    fprintf(stdout, "            create            use MPI_Win_create to create an MPI Window object\n");
-    if (accel_enabled) {
-        fprintf(stdout, "            allocate          use MPI_Win_allocate to create an MPI Window object (not valid when using device memory)\n");
-    } else {
-        fprintf(stdout, "            allocate          use MPI_Win_allocate to create an MPI Window object\n");
-    }
-    fprintf(stdout, "            dynamic           use MPI_Win_create_dynamic to create an MPI Window object\n");
-    fprintf(stdout, "\n");
+        fprintf(stdout, "  -w --win-option <win_option>\n");
+        fprintf(stdout, "            <win_option> can be any of the follows:\n");
+        fprintf(stdout, "            create            use MPI_Win_create to create an MPI Window object\n");
+        if (accel_enabled) {
+            fprintf(stdout, "            allocate          use MPI_Win_allocate to create an MPI Window object (not valid when using device memory)\n");
+        } else {
+            fprintf(stdout, "            allocate          use MPI_Win_allocate to create an MPI Window object\n");
+        }
+        fprintf(stdout, "            dynamic           use MPI_Win_create_dynamic to create an MPI Window object\n");
+        fprintf(stdout, "\n");
 #endif
 
-    fprintf(stdout, "  -s, --sync-option <sync_option>\n");
-    fprintf(stdout, "            <sync_option> can be any of the follows:\n");
-    fprintf(stdout, "            pscw              use Post/Start/Complete/Wait synchronization calls \n");
-    fprintf(stdout, "            fence             use MPI_Win_fence synchronization call\n");
-    if (options.synctype == ALL_SYNC) {
-        fprintf(stdout, "            lock              use MPI_Win_lock/unlock synchronizations calls\n");
+        fprintf(stdout, "  -s, --sync-option <sync_option>\n");
+        fprintf(stdout, "            <sync_option> can be any of the follows:\n");
+        fprintf(stdout, "            pscw              use Post/Start/Complete/Wait synchronization calls \n");
+        fprintf(stdout, "            fence             use MPI_Win_fence synchronization call\n");
+        if (options.synctype == ALL_SYNC) {
+            fprintf(stdout, "            lock              use MPI_Win_lock/unlock synchronizations calls\n");
 #if MPI_VERSION >= 3
-        fprintf(stdout, "            flush             use MPI_Win_flush synchronization call\n");
-        fprintf(stdout, "            flush_local       use MPI_Win_flush_local synchronization call\n");
-        fprintf(stdout, "            lock_all          use MPI_Win_lock_all/unlock_all synchronization calls\n");
+            fprintf(stdout, "            flush             use MPI_Win_flush synchronization call\n");
+            fprintf(stdout, "            flush_local       use MPI_Win_flush_local synchronization call\n");
+            fprintf(stdout, "            lock_all          use MPI_Win_lock_all/unlock_all synchronization calls\n");
 #endif
+        }
+        fprintf(stdout, "\n");
     }
-    fprintf(stdout, "\n");
-    if (options.show_size) {
+    if (options.show_size && options.subtype != LAT_HOTSPOT &&
+        options.subtype != GUPS) {
         fprintf(stdout, "  -m, --message-size          [MIN:]MAX  set the minimum and/or the maximum message size to MIN and/or MAX\n");
         fprintf(stdout, "                              bytes respectively. Examples:\n");
         fprintf(stdout, "                              -m 128      // min = default, max = 128\n");
         fprintf(stdout, "                              -m 2:128    // min = 2, max = 128\n");
         fprintf(stdout, "                              -m 2:       // min = 2, max = default\n");
+        fprintf(stdout, "                              -m 3,3072,49152     // exactly these sizes\n");
+        fprintf(stdout, "                              -m 1024:65536:+1024 // linear steps of 1024\n");
+        fprintf(stdout, "                              -m 1:65536:*1.5     // geometric steps of 1.5x\n");
         fprintf(stdout, "  -M, --mem-limit SIZE        set per process maximum memory consumption to SIZE bytes\n");
         fprintf(stdout, "                              (default %d)\n", MAX_MEM_LIMIT);
     }
     fprintf(stdout, "  -x, --warmup ITER           number of warmup iterations to skip before timing"
-                   "(default 100)\n");
+                   "(default %d)\n", LAT_WIN == options.subtype ? WIN_SKIP :
+                   (GUPS == options.subtype ? GUPS_SKIP : 100));
     
     if(options.subtype == BW) {
         fprintf(stdout, "  -W, --window-size SIZE      set number of messages to send before synchronization (default 64)\n");
     }
     
-    fprintf(stdout, "  -i, --iterations ITER       number of iterations for timing (default 10000)\n");
+    fprintf(stdout, "  -i, --iterations ITER       number of iterations for timing (default %d)\n",
+            LAT_WIN == options.subtype ? WIN_LOOP :
+            (GUPS == options.subtype ? GUPS_LOOP : 10000));
+
+    if (options.subtype == LAT_HOTSPOT) {
+        fprintf(stdout, "  --rma-op OP                 operation each origin issues: fop (MPI_Fetch_and_op,\n");
+        fprintf(stdout, "                              default), cas (MPI_Compare_and_swap) or acc (MPI_Accumulate)\n");
+        fprintf(stdout, "  --targets K                 spread the origins over the first K ranks (default 1)\n");
+        fprintf(stdout, "  -P, --percentiles           report P50/P90/P99/P99.9 latency over all operations and\n");
+        fprintf(stdout, "                              origins, and a log2 latency histogram per origin count\n");
+    }
+
+    if (options.subtype == GUPS) {
+        fprintf(stdout, "                              (-x and -i count updates per process)\n");
+        fprintf(stdout, "  --rma-op OP                 update with fop (MPI_Fetch_and_op, default) or\n");
+        fprintf(stdout, "                              acc (MPI_Accumulate)\n");
+        fprintf(stdout, "  --table-size SIZE           bytes of table on each process (default %d)\n",
+                DEF_GUPS_TABLE_SIZE);
+        fprintf(stdout, "  --batch B                   largest number of updates between synchronizations;\n");
+        fprintf(stdout, "                              batches of 1, 2, 4, ... B are measured (default %d)\n",
+                DEF_GUPS_BATCH);
+        fprintf(stdout, "  -c, --validation 0|1        replay the updates afterwards and count table words\n");
+        fprintf(stdout, "                              that did not return to their initial value (default 0)\n");
+    }
+
+    if (options.subtype != LAT_HOTSPOT) {
+        print_help_host_memory();
+    }
 
     fprintf(stdout, "  -h, --help                  print this help message\n");
     fflush(stdout);
@@ -263,6 +410,8 @@ void usage_mbw_mr()
     fprintf(stdout, "Options:\n");
     fprintf(stdout, "  -R=<0,1>, --print-rate         Print uni-directional message rate (default 1)\n");
     fprintf(stdout, "  -p=<pairs>, --num-pairs        Number of pairs involved (default np / 2)\n");
+    fprintf(stdout, "  --pairing MODE                 Pair placement: block (default), intra-socket,\n");
+    fprintf(stdout, "                                 cross-socket, cross-node, random[:SEED] or map:FILE\n");
     fprintf(stdout, "  -W=<window>, --window-size     Number of messages sent before acknowledgement (default 64)\n");
     fprintf(stdout, "                                 [cannot be used with -v]\n");
     fprintf(stdout, "  -V, --vary-window              Vary the window size (default no)\n");
@@ -275,6 +424,9 @@ void usage_mbw_mr()
         fprintf(stdout, "                              -m 128      // min = default, max = 128\n");
         fprintf(stdout, "                              -m 2:128    // min = 2, max = 128\n");
         fprintf(stdout, "                              -m 2:       // min = 2, max = default\n");
+        fprintf(stdout, "                              -m 3,3072,49152     // exactly these sizes\n");
+        fprintf(stdout, "                              -m 1024:65536:+1024 // linear steps of 1024\n");
+        fprintf(stdout, "                              -m 1:65536:*1.5     // geometric steps of 1.5x\n");
         fprintf(stdout, "  -M, --mem-limit SIZE        set per process maximum memory consumption to SIZE bytes\n");
         fprintf(stdout, "                              (default %d)\n", MAX_MEM_LIMIT);
     }
@@ -282,6 +434,7 @@ void usage_mbw_mr()
         fprintf(stdout, "  -d, --accelerator  TYPE     use accelerator device buffers, which can be of TYPE `cuda', \n");
         fprintf(stdout, "                              `managed', `openacc', or `rocm' (uses standard host buffers if not specified)\n");
     }
+    print_help_host_memory();
     fprintf(stdout, "  -h, --help                     Print this help\n");
     fprintf(stdout, "\n");
     fprintf(stdout, "  Note: This benchmark relies on block ordering of the ranks.  Please see\n");
@@ -295,7 +448,13 @@ void print_bad_usage_message (int rank)
         return;
     }
 
-    if (bad_usage.optarg) {
+    if (bad_usage.optname && bad_usage.optarg) {
+        fprintf(stderr, "%s [--%s %s]\n\n", bad_usage.message,
+                bad_usage.optname, bad_usage.optarg);
+    } else if (bad_usage.optname) {
+        fprintf(stderr, "%s [--%s]\n\n", bad_usage.message,
+                bad_usage.optname);
+    } else if (bad_usage.optarg) {
         fprintf(stderr, "%s [-%c %s]\n\n", bad_usage.message,
                 (char)bad_usage.opt, bad_usage.optarg);
     } else {
@@ -327,7 +486,7 @@ void print_help_message (int rank)
     }
 
     if (((options.bench == PT2PT) || (options.bench == MBW_MR)) &&
-        (LAT_MT != options.subtype) && (LAT_MP != options.subtype)) {
+        (LAT == options.subtype || BW == options.subtype)) {
         fprintf(stdout, "  -b, --buffer-num            Use different buffers to perform data transfer (default single)\n");
         fprintf(stdout, "                              Options: single, multiple\n");
     }
@@ -343,6 +502,9 @@ void print_help_message (int rank)
         fprintf(stdout, "                              -m 128      // min = default, max = 128\n");
         fprintf(stdout, "                              -m 2:128    // min = 2, max = 128\n");
         fprintf(stdout, "                              -m 2:       // min = 2, max = default\n");
+        fprintf(stdout, "                              -m 3,3072,49152     // exactly these sizes\n");
+        fprintf(stdout, "                              -m 1024:65536:+1024 // linear steps of 1024\n");
+        fprintf(stdout, "                              -m 1:65536:*1.5     // geometric steps of 1.5x\n");
         fprintf(stdout, "  -M, --mem-limit SIZE        set per process maximum memory consumption to SIZE bytes\n");
         fprintf(stdout, "                              (default %d)\n", MAX_MEM_LIMIT);
     }
@@ -351,7 +513,79 @@ void print_help_message (int rank)
     fprintf(stdout, "                              messages, 100 for large messages)\n");
     fprintf(stdout, "  -x, --warmup ITER           set number of warmup iterations to skip before timing (default 200)\n");
 
-    if (options.subtype == BW) {
+    if (percentiles_supported() && options.subtype != LAT_HOTSPOT) {
+        fprintf(stdout, "  -P, --percentiles           report P50/P90/P99/P99.9 latency over all iterations and\n");
+        fprintf(stdout, "                              ranks, and a log2 latency histogram per message size\n");
+    }
+
+    if (adaptive_supported()) {
+        fprintf(stdout, "  --target-ci PCT             adaptive iterations: repeat each message size until the 95%%\n");
+        fprintf(stdout, "                              confidence interval of the mean is within PCT%% (default %g)\n",
+                ADAPTIVE_TARGET_CI);
+        fprintf(stdout, "  --time-budget SEC           adaptive iterations: stop each message size after SEC\n");
+        fprintf(stdout, "                              seconds even if the target is not met (default %g)\n",
+                ADAPTIVE_TIME_BUDGET);
+    }
+
+    if (options.subtype != LAT_MT && options.subtype != LAT_MP &&
+        options.subtype != LAT_MATCH && options.bench != MBW_MR) {
+        fprintf(stdout, "  --refine PCT                after the sweep, bisect size intervals where the result\n");
+        fprintf(stdout, "                              departs from the neighbouring trend by more than PCT%%\n");
+    }
+
+    if (persistent_supported()) {
+        fprintf(stdout, "  --persistent                create MPI_Send_init/MPI_Recv_init requests once per\n");
+        fprintf(stdout, "                              message size and start them in every iteration\n");
+    }
+
+    if (cache_supported()) {
+        fprintf(stdout, "  --cache STATE               also time every message size with cold caches, reported\n");
+        fprintf(stdout, "                              next to the hot result: cold rotates through buffers\n");
+        fprintf(stdout, "                              filling twice the LLC (cold:BYTES sets the LLC size),\n");
+        fprintf(stdout, "                              flush evicts the buffers before each iteration;\n");
+        fprintf(stdout, "                              hot (default) runs the hot pass only\n");
+        fprintf(stdout, "  --fresh-buffers MODE        also time every message size with buffers used for the\n");
+        fprintf(stdout, "                              first time, from malloc or mmap around each iteration,\n");
+        fprintf(stdout, "                              or from a rotating pool (pool[:BYTES], default 1 GB)\n");
+    }
+
+    if (pairing_supported()) {
+        fprintf(stdout, "  --pairing MODE              place pairs by rank blocks (block, default), on one\n");
+        fprintf(stdout, "                              socket (intra-socket), across sockets of a node\n");
+        fprintf(stdout, "                              (cross-socket), across nodes (cross-node), randomly\n");
+        fprintf(stdout, "                              (random[:SEED]) or from \"A B\" lines (map:FILE)\n");
+    }
+
+    fprintf(stdout, "  --output-format FORMAT      also write results as text (default), json (one object per\n");
+    fprintf(stdout, "                              line) or csv; defaults to $OMB_OUTPUT_FORMAT\n");
+    fprintf(stdout, "  --output-file FILE          append json/csv results to FILE instead of stdout;\n");
+    fprintf(stdout, "                              defaults to $OMB_OUTPUT_FILE\n");
+    print_help_host_memory();
+
+    if (options.subtype == LAT_PAP) {
+        fprintf(stdout, "  -F, --max-i-f FACTOR        delay arrivals by up to FACTOR times the point-to-point\n");
+        fprintf(stdout, "                              latency of the message size (default 0)\n");
+        fprintf(stdout, "  -A, --arrival-pattern PAT   distribution of the per-rank arrival delays, one of\n");
+        fprintf(stdout, "                              default, uniform, normal, exponential, pareto,\n");
+        fprintf(stdout, "                              late[:RANK], node or trace:FILE (default: rank 0 first,\n");
+        fprintf(stdout, "                              rank 1 at FACTOR, others uniform)\n");
+        fprintf(stdout, "  --delay-mode MODE           inject arrival delays by busy-waiting (spin, default),\n");
+        fprintf(stdout, "                              sleeping then spinning (hybrid) or usleep (sleep)\n");
+    }
+
+    if (iteration_sync_supported()) {
+        fprintf(stdout, "  --iteration-sync MODE       separate iterations with MPI_Barrier (barrier, default) or\n");
+        fprintf(stdout, "                              start them in globally clock-synchronized windows\n");
+        fprintf(stdout, "                              (window[:USEC], length measured during warmup by default)\n");
+    }
+
+    if (options.subtype == LAT_MULTI) {
+        fprintf(stdout, "  -l, --collectives LIST      run the comma separated LIST of collectives in this job,\n");
+        fprintf(stdout, "                              e.g. allreduce,bcast,alltoall (default: all)\n");
+    }
+
+    if (options.subtype == BW || options.subtype == BW_MT ||
+        options.subtype == BW_PART || options.subtype == BW_DDT) {
         fprintf(stdout, "  -W, --window-size SIZE      set number of messages to send before synchronization (default 64)\n");
     }
 
@@ -381,6 +615,51 @@ void print_help_message (int rank)
         fprintf(stdout, "                              -t 4        // receiver threads = 4 and sender threads = 1\n");
         fprintf(stdout, "                              -t 4:6      // sender threads = 4 and receiver threads = 6\n");
         fprintf(stdout, "                              -t 2:       // not defined\n");
+        fprintf(stdout, "  --thread-comm MODE          threads share MPI_COMM_WORLD and split the iterations\n");
+        fprintf(stdout, "                              (shared, default), or sender thread i runs its own\n");
+        fprintf(stdout, "                              ping-pong with receiver thread i on tag i (tag) or on\n");
+        fprintf(stdout, "                              its own duplicate of MPI_COMM_WORLD (dup)\n");
+        fprintf(stdout, "  --pin-threads CPUS          pin thread i to the i-th CPU of the comma-separated\n");
+        fprintf(stdout, "                              list CPUS, or of the process's CPU set with auto\n");
+    }
+
+    if (LAT_DDT == options.subtype || BW_DDT == options.subtype) {
+        fprintf(stdout, "  --ddt LIST                  datatypes to run, a comma-separated list of vector,\n");
+        fprintf(stdout, "                              indexed, subarray and struct (default: all)\n");
+        fprintf(stdout, "  --block BYTES               contiguous bytes per block (default %d)\n",
+                DEF_DDT_BLOCK);
+        fprintf(stdout, "  --stride BYTES              distance from one block to the next (default twice\n");
+        fprintf(stdout, "                              the block)\n");
+    }
+
+    if (LAT_MATCH == options.subtype) {
+        fprintf(stdout, "  --depth N                   time queues of 0, 1, 2, 4, ... N non-matching entries\n");
+        fprintf(stdout, "                              (default %d)\n", DEF_MATCH_DEPTH);
+        fprintf(stdout, "  --wildcard LIST             receive wildcards to run, a comma-separated list of\n");
+        fprintf(stdout, "                              none, source (MPI_ANY_SOURCE) and tag (MPI_ANY_TAG)\n");
+        fprintf(stdout, "                              (default: all)\n");
+    }
+
+    if (LAT_PART == options.subtype || BW_PART == options.subtype) {
+        fprintf(stdout, "  --partitions P              split each message into P partitions (default %d, max %d)\n",
+                DEF_NUM_PARTITIONS, MAX_NUM_PARTITIONS);
+        fprintf(stdout, "  --ready MODE                partitions are marked ready by one thread from the\n");
+        fprintf(stdout, "                              last partition to the first (staggered, default), or\n");
+        fprintf(stdout, "                              partition p by thread p of the sender (threads)\n");
+    }
+
+    if (BW_MT == options.subtype) {
+        fprintf(stdout, "  -t, --num_threads           N[:N]  set the number of threads of each process\n");
+        fprintf(stdout, "                              min: %d default: %d, max: %d. Sender thread i streams\n",
+                MIN_NUM_THREADS, DEF_NUM_THREADS, MAX_NUM_THREADS);
+        fprintf(stdout, "                              to receiver thread i\n");
+        fprintf(stdout, "  --thread-comm MODE          threads share MPI_COMM_WORLD and one tag (shared,\n");
+        fprintf(stdout, "                              default), use tag i on MPI_COMM_WORLD (tag), or\n");
+        fprintf(stdout, "                              each use a duplicate of MPI_COMM_WORLD (dup)\n");
+        fprintf(stdout, "  --pin-threads CPUS          pin thread i to the i-th CPU of the comma-separated\n");
+        fprintf(stdout, "                              list CPUS, or of the process's CPU set with auto\n");
+        fprintf(stdout, "  --comm-hints                duplicate the communicators with the MPI-4 info hints\n");
+        fprintf(stdout, "                              mpi_assert_allow_overtaking and mpi_assert_no_any_tag\n");
     }
 
     if (LAT_MP == options.subtype) {
@@ -405,7 +684,13 @@ void print_help_message_get_acc_lat (int rank)
         return;
     }
 
-    if (bad_usage.optarg) {
+    if (bad_usage.optname && bad_usage.optarg) {
+        fprintf(stderr, "%s [--%s %s]\n\n", bad_usage.message,
+                bad_usage.optname, bad_usage.optarg);
+    } else if (bad_usage.optname) {
+        fprintf(stderr, "%s [--%s]\n\n", bad_usage.message,
+                bad_usage.optname);
+    } else if (bad_usage.optarg) {
         fprintf(stderr, "%s [-%c %s]\n\n", bad_usage.message,
                 (char)bad_usage.opt, bad_usage.optarg);
     } else {
@@ -421,6 +706,9 @@ void print_help_message_get_acc_lat (int rank)
         fprintf(stdout, "                              -m 128      // min = default, max = 128\n");
         fprintf(stdout, "                              -m 2:128    // min = 2, max = 128\n");
         fprintf(stdout, "                              -m 2:       // min = 2, max = default\n");
+        fprintf(stdout, "                              -m 3,3072,49152     // exactly these sizes\n");
+        fprintf(stdout, "                              -m 1024:65536:+1024 // linear steps of 1024\n");
+        fprintf(stdout, "                              -m 1:65536:*1.5     // geometric steps of 1.5x\n");
         fprintf(stdout, "  -M, --mem-limit SIZE        set per process maximum memory consumption to SIZE bytes\n");
         fprintf(stdout, "                              (default %d)\n", MAX_MEM_LIMIT);
     }
@@ -468,6 +756,7 @@ void print_header_one_sided (int rank, enum WINDOW win, enum SYNC sync)
                 win_info[win]);
         fprintf(stdout, "# Synchronization: %s\n",
                 sync_info[sync]);
+        print_host_memory_policy();
 
         switch (options.accel) {
             case CUDA:
@@ -514,6 +803,23 @@ void print_version_message (int rank)
     fflush(stdout);
 }
 
+static void print_header_sync (void)
+{
+    if (ITERATION_SYNC_WINDOW == options.iteration_sync) {
+        fprintf(stdout, "%*s", FIELD_WIDTH, "Missed Windows(%)");
+    }
+}
+
+static void print_stats_sync (void)
+{
+    if (ITERATION_SYNC_WINDOW == options.iteration_sync) {
+        fprintf(stdout, "%*.*f", FIELD_WIDTH, FLOAT_PRECISION,
+                sync_state.missed_pct);
+        omb_result_field("sync_window_us", sync_state.length * 1e6);
+        omb_result_field("missed_windows_pct", sync_state.missed_pct);
+    }
+}
+
 void print_preamble_nbc (int rank)
 {
     if (rank) {
@@ -540,6 +846,7 @@ void print_preamble_nbc (int rank)
             break;
     }
 
+    print_host_memory_policy();
     fprintf(stdout, "# Overall = Coll. Init + Compute + MPI_Test + MPI_Wait\n\n");
 
     if (options.show_size) {
@@ -557,13 +864,15 @@ void print_preamble_nbc (int rank)
         fprintf(stdout, "%*s", FIELD_WIDTH, "Pure Comm.(us)");
         fprintf(stdout, "%*s", FIELD_WIDTH, "Min Comm.(us)");
         fprintf(stdout, "%*s", FIELD_WIDTH, "Max Comm.(us)");
-        fprintf(stdout, "%*s\n", FIELD_WIDTH, "Overlap(%)");
+        fprintf(stdout, "%*s", FIELD_WIDTH, "Overlap(%)");
 
     } else {
         fprintf(stdout, "%*s", FIELD_WIDTH, "Compute(us)");
         fprintf(stdout, "%*s", FIELD_WIDTH, "Pure Comm.(us)");
-        fprintf(stdout, "%*s\n", FIELD_WIDTH, "Overlap(%)");
+        fprintf(stdout, "%*s", FIELD_WIDTH, "Overlap(%)");
     }
+    print_header_sync();
+    fprintf(stdout, "\n");
 
     fflush(stdout);
 }
@@ -587,6 +896,15 @@ void display_nbc_params()
     }
 }
 
+static void print_header_skew (void)
+{
+    if (LAT_PAP == options.subtype) {
+        fprintf(stdout, "%*s", FIELD_WIDTH, "LastArr-Exit(us)");
+        fprintf(stdout, "%*s", FIELD_WIDTH, "Arrival Skew(us)");
+        fprintf(stdout, "%*s", FIELD_WIDTH, "Exit Skew(us)");
+    }
+}
+
 void print_preamble (int rank)
 {
     if (rank) {
@@ -610,6 +928,9 @@ void print_preamble (int rank)
             break;
     }
 
+    print_host_memory_policy();
+    print_cache_state();
+
     if (options.show_size) {
         fprintf(stdout, "%-*s", 10, "# Size");
         fprintf(stdout, "%*s", FIELD_WIDTH, "Avg Latency(us)");
@@ -618,14 +939,20 @@ void print_preamble (int rank)
     } else {
         fprintf(stdout, "# Avg Latency(us)");
     }
+    print_header_cache();
 
     if (options.show_full) {
         fprintf(stdout, "%*s", FIELD_WIDTH, "Min Latency(us)");
         fprintf(stdout, "%*s", FIELD_WIDTH, "Max Latency(us)");
-        fprintf(stdout, "%*s\n", 12, "Iterations");
-        if (options.validate)
-            fprintf(stdout, "%*s", FIELD_WIDTH, "Errors");
+        fprintf(stdout, "%*s", 12, "Iterations");
+        print_header_skew();
+        print_header_sync();
+        print_header_percentiles();
+        fprintf(stdout, "\n");
     } else {
+        print_header_skew();
+        print_header_sync();
+        print_header_percentiles();
         fprintf(stdout, "\n");
     }
 
@@ -702,6 +1029,14 @@ void calculate_and_print_stats(int rank, int size, int numprocs,
 
 }
 
+static void record_comm_size (MPI_Comm comm)
+{
+    int comm_size;
+
+    MPI_CHECK(MPI_Comm_size(comm, &comm_size));
+    set_num_ranks(comm_size);
+}
+
 void print_stats_nbc (int rank, int size, double overall_time,
                  double cpu_time, double avg_comm_time,
                  double min_comm_time, double max_comm_time,
@@ -730,7 +1065,7 @@ void print_stats_nbc (int rank, int size, double overall_time,
     }
 
     if (options.show_full) {
-        fprintf(stdout, "%*.*f%*.*f%*.*f%*.*f%*.*f%*.*f%*.*f%*.*f\n",
+        fprintf(stdout, "%*.*f%*.*f%*.*f%*.*f%*.*f%*.*f%*.*f%*.*f",
                 FIELD_WIDTH, FLOAT_PRECISION, (cpu_time - test_time),
                 FIELD_WIDTH, FLOAT_PRECISION, init_time,
                 FIELD_WIDTH, FLOAT_PRECISION, test_time,
@@ -742,59 +1077,2121 @@ void print_stats_nbc (int rank, int size, double overall_time,
     } else {
         fprintf(stdout, "%*.*f", FIELD_WIDTH, FLOAT_PRECISION, (cpu_time - test_time));
         fprintf(stdout, "%*.*f", FIELD_WIDTH, FLOAT_PRECISION, avg_comm_time);
-        fprintf(stdout, "%*.*f\n", FIELD_WIDTH, FLOAT_PRECISION, overlap);
+        fprintf(stdout, "%*.*f", FIELD_WIDTH, FLOAT_PRECISION, overlap);
+    }
+
+    record_comm_size(MPI_COMM_WORLD);
+    omb_result_begin(size, options.iterations);
+    omb_result_metric("overall_us", overall_time);
+    omb_result_field("compute_us", cpu_time - test_time);
+    omb_result_field("init_us", init_time);
+    omb_result_field("test_us", test_time);
+    omb_result_field("wait_us", wait_time);
+    omb_result_field("comm_us", avg_comm_time);
+    omb_result_field("min_comm_us", min_comm_time);
+    omb_result_field("max_comm_us", max_comm_time);
+    omb_result_field("overlap_pct", overlap);
+    print_stats_sync();
+    fprintf(stdout, "\n");
+    omb_result_end();
+
+    fflush(stdout);
+}
+
+void print_stats (int rank, int size, double avg_time, double min_time, double max_time)
+{
+    if (rank) {
+        return;
+    }
+
+    if (options.show_size) {
+        fprintf(stdout, "%-*d", 10, size);
+        fprintf(stdout, "%*.*f", FIELD_WIDTH, FLOAT_PRECISION, avg_time);
+    } else {
+        fprintf(stdout, "%*.*f", 17, FLOAT_PRECISION, avg_time);
+    }
+
+    if (CACHE_HOT != options.cache_state) {
+        fprintf(stdout, "%*.*f", FIELD_WIDTH, FLOAT_PRECISION,
+                cache_pool.latency);
+    }
+
+    if (FRESH_NONE != options.fresh_buffers) {
+        fprintf(stdout, "%*.*f", FIELD_WIDTH, FLOAT_PRECISION,
+                cache_pool.fresh_latency);
+    }
+
+    if (options.show_full) {
+        fprintf(stdout, "%*.*f%*.*f%*lu",
+                FIELD_WIDTH, FLOAT_PRECISION, min_time,
+                FIELD_WIDTH, FLOAT_PRECISION, max_time,
+                12, options.iterations);
+    }
+
+    record_comm_size(MPI_COMM_WORLD);
+    omb_result_begin(size, options.iterations);
+    omb_result_metric("latency_us", avg_time);
+    omb_result_field("min_latency_us", min_time);
+    omb_result_field("max_latency_us", max_time);
+    if (CACHE_HOT != options.cache_state) {
+        omb_result_field("cold_latency_us", cache_pool.latency);
+    }
+    if (FRESH_NONE != options.fresh_buffers) {
+        omb_result_field("fresh_latency_us", cache_pool.fresh_latency);
+    }
+    print_stats_sync();
+    print_latency_dist(rank);
+    omb_result_end();
+
+    fflush(stdout);
+}
+
+void print_stats_validate(int rank, int size, double avg_time, double min_time,
+            double max_time, int errors)
+{
+    if (rank) {
+        return;
+    }
+
+    if (options.show_size) {
+        fprintf(stdout, "%-*d", 10, size);
+        fprintf(stdout, "%*.*f", FIELD_WIDTH, FLOAT_PRECISION, avg_time);
+    } else {
+        fprintf(stdout, "%*.*f", 17, FLOAT_PRECISION, avg_time);
+    }
+    fprintf(stdout, "%*d", FIELD_WIDTH, errors);
+
+    if (options.show_full) {
+        fprintf(stdout, "%*.*f%*.*f%*lu",
+                FIELD_WIDTH, FLOAT_PRECISION, min_time,
+                FIELD_WIDTH, FLOAT_PRECISION, max_time,
+                12, options.iterations);
+    }
+
+    record_comm_size(MPI_COMM_WORLD);
+    omb_result_begin(size, options.iterations);
+    omb_result_metric("latency_us", avg_time);
+    omb_result_field("min_latency_us", min_time);
+    omb_result_field("max_latency_us", max_time);
+    omb_result_field("errors", errors);
+    print_latency_dist(rank);
+    omb_result_end();
+    fflush(stdout);
+}
+
+void adaptive_begin (void)
+{
+    if (!options.adaptive) {
+        return;
+    }
+
+    adaptive_state.count = 0.0;
+    adaptive_state.mean = 0.0;
+    adaptive_state.m2 = 0.0;
+    adaptive_state.ci = 0.0;
+    adaptive_state.start = MPI_Wtime();
+
+    options.iterations = ADAPTIVE_MIN_ITERATIONS;
+}
+
+static void adaptive_record (double latency)
+{
+    double delta;
+
+    if (!options.adaptive) {
+        return;
+    }
+
+    adaptive_state.count += 1.0;
+    delta = latency - adaptive_state.mean;
+    adaptive_state.mean += delta / adaptive_state.count;
+    adaptive_state.m2 += delta * (latency - adaptive_state.mean);
+}
+
+/*
+ * Call at the end of every iteration I.  At the last iteration of the
+ * current count the ranks agree whether to stop; otherwise the count grows
+ * and the loop keeps going.
+ */
+void adaptive_check (MPI_Comm comm, int i)
+{
+    double local[2], global[2];
+    double n = adaptive_state.count;
+
+    if (!options.adaptive || i + 1 != (int)(options.skip + options.iterations)) {
+        return;
+    }
+
+    /* ranks without timed samples do not constrain the stop */
+    local[0] = 0.0;
+    if (n > 1 && adaptive_state.mean > 0) {
+        local[0] = ADAPTIVE_Z95 * sqrt(adaptive_state.m2 / (n - 1) / n) /
+            adaptive_state.mean * 100.0;
+    }
+    local[1] = MPI_Wtime() - adaptive_state.start;
+
+    MPI_CHECK(MPI_Allreduce(local, global, 2, MPI_DOUBLE, MPI_MAX, comm));
+    adaptive_state.ci = global[0];
+
+    if (global[0] > options.target_ci && global[1] < options.time_budget) {
+        options.iterations += MAX(ADAPTIVE_MIN_ITERATIONS,
+                options.iterations / 4);
+    }
+}
+
+int allocate_latency_samples (void)
+{
+    if (!options.show_percentiles) {
+        return 0;
+    }
+
+    lat_samples_max = MAX(options.iterations, options.iterations_large);
+    lat_samples_count = 0;
+    lat_samples = malloc(lat_samples_max * sizeof(double));
+
+    if (NULL == lat_samples) {
+        fprintf(stderr, "Could not allocate latency sample buffer\n");
+        return 1;
+    }
+
+    MPI_CHECK(MPI_Type_contiguous(LAT_STAT_LEN, MPI_DOUBLE, &lat_stats_type));
+    MPI_CHECK(MPI_Type_commit(&lat_stats_type));
+
+    return 0;
+}
+
+void free_latency_samples (void)
+{
+    if (NULL == lat_samples) {
+        return;
+    }
+
+    free(lat_samples);
+    lat_samples = NULL;
+    lat_samples_max = 0;
+
+    MPI_CHECK(MPI_Type_free(&lat_stats_type));
+    if (MPI_OP_NULL != lat_stats_op) {
+        MPI_CHECK(MPI_Op_free(&lat_stats_op));
+    }
+}
+
+void record_latency_sample (double latency)
+{
+    double *grown;
+
+    adaptive_record(latency);
+
+    /* adaptive runs have no fixed iteration count to size the buffer */
+    if (options.adaptive && lat_samples && lat_samples_count == lat_samples_max) {
+        grown = realloc(lat_samples, 2 * lat_samples_max * sizeof(double));
+        if (grown) {
+            lat_samples = grown;
+            lat_samples_max *= 2;
+        }
+    }
+
+    if (lat_samples_count < lat_samples_max) {
+        lat_samples[lat_samples_count++] = latency;
+    }
+}
+
+static int lat_hist_bin (double latency)
+{
+    int exp, octave;
+    double mant;
+
+    if (latency < ldexp(1.0, LAT_HIST_MIN_EXP)) {
+        return 0;
+    }
+
+    /* latency = mant * 2^exp with mant in [0.5, 1) */
+    mant = frexp(latency, &exp);
+    octave = exp - 1 - LAT_HIST_MIN_EXP;
+    if (octave >= LAT_HIST_OCTAVES) {
+        return LAT_HIST_BINS - 1;
+    }
+
+    return 1 + octave * LAT_HIST_SUB + (int)((2.0 * mant - 1.0) * LAT_HIST_SUB);
+}
+
+static double lat_hist_lower (int bin)
+{
+    if (0 == bin) {
+        return 0.0;
+    } else if (LAT_HIST_BINS - 1 == bin) {
+        return ldexp(1.0, LAT_HIST_MIN_EXP + LAT_HIST_OCTAVES);
+    }
+
+    return ldexp(1.0 + (double)((bin - 1) % LAT_HIST_SUB) / LAT_HIST_SUB,
+                 LAT_HIST_MIN_EXP + (bin - 1) / LAT_HIST_SUB);
+}
+
+static void lat_stats_merge (void *in, void *inout, int *len, MPI_Datatype *type)
+{
+    double *src = (double *)in, *dst = (double *)inout;
+    int i, j;
+
+    for (i = 0; i < *len; i++, src += LAT_STAT_LEN, dst += LAT_STAT_LEN) {
+        dst[LAT_STAT_COUNT] += src[LAT_STAT_COUNT];
+        dst[LAT_STAT_SUM] += src[LAT_STAT_SUM];
+        dst[LAT_STAT_MIN] = MIN(dst[LAT_STAT_MIN], src[LAT_STAT_MIN]);
+        dst[LAT_STAT_MAX] = MAX(dst[LAT_STAT_MAX], src[LAT_STAT_MAX]);
+        for (j = LAT_STAT_HIST; j < LAT_STAT_LEN; j++) {
+            dst[j] += src[j];
+        }
+    }
+}
+
+void reduce_latency_samples (MPI_Comm comm)
+{
+    double local[LAT_STAT_LEN];
+    size_t i;
+
+    if (NULL == lat_samples) {
+        return;
+    }
+
+    if (MPI_OP_NULL == lat_stats_op) {
+        MPI_CHECK(MPI_Op_create(lat_stats_merge, 1, &lat_stats_op));
+    }
+
+    memset(local, 0, sizeof(local));
+    local[LAT_STAT_MIN] = DBL_MAX;
+
+    for (i = 0; i < lat_samples_count; i++) {
+        local[LAT_STAT_COUNT] += 1.0;
+        local[LAT_STAT_SUM] += lat_samples[i];
+        local[LAT_STAT_MIN] = MIN(local[LAT_STAT_MIN], lat_samples[i]);
+        local[LAT_STAT_MAX] = MAX(local[LAT_STAT_MAX], lat_samples[i]);
+        local[LAT_STAT_HIST + lat_hist_bin(lat_samples[i])] += 1.0;
+    }
+
+    MPI_CHECK(MPI_Reduce(local, lat_stats, 1, lat_stats_type, lat_stats_op, 0,
+                comm));
+    lat_samples_count = 0;
+}
+
+/* Percentile q of the merged samples, interpolated within its bin */
+static double lat_percentile (double q)
+{
+    double *hist = lat_stats + LAT_STAT_HIST;
+    double target, cum = 0.0, lo, hi;
+    int bin;
+
+    if (0 == lat_stats[LAT_STAT_COUNT]) {
+        return 0.0;
+    }
+
+    target = MAX(1.0, ceil(q * lat_stats[LAT_STAT_COUNT]));
+
+    for (bin = 0; bin < LAT_HIST_BINS; bin++) {
+        if (cum + hist[bin] >= target) {
+            lo = MAX(lat_hist_lower(bin), lat_stats[LAT_STAT_MIN]);
+            hi = (bin < LAT_HIST_BINS - 1) ? lat_hist_lower(bin + 1) :
+                    lat_stats[LAT_STAT_MAX];
+            hi = MIN(hi, lat_stats[LAT_STAT_MAX]);
+            return lo + (hi - lo) * (target - cum) / hist[bin];
+        }
+        cum += hist[bin];
     }
 
-    fflush(stdout);
+    return lat_stats[LAT_STAT_MAX];
+}
+
+/* One comment line per size, collapsing sub-bins into powers of two */
+static void print_latency_histogram (void)
+{
+    double *hist = lat_stats + LAT_STAT_HIST;
+    double count;
+    int octave, j;
+
+    fprintf(stdout, "# Histogram(us):");
+
+    if (hist[0]) {
+        fprintf(stdout, " <%g:%.0f", lat_hist_lower(1), hist[0]);
+    }
+
+    for (octave = 0; octave < LAT_HIST_OCTAVES; octave++) {
+        count = 0;
+        for (j = 0; j < LAT_HIST_SUB; j++) {
+            count += hist[1 + octave * LAT_HIST_SUB + j];
+        }
+        if (count) {
+            fprintf(stdout, " [%g,%g):%.0f",
+                    ldexp(1.0, LAT_HIST_MIN_EXP + octave),
+                    ldexp(1.0, LAT_HIST_MIN_EXP + octave + 1), count);
+        }
+    }
+
+    if (hist[LAT_HIST_BINS - 1]) {
+        fprintf(stdout, " >=%g:%.0f", lat_hist_lower(LAT_HIST_BINS - 1),
+                hist[LAT_HIST_BINS - 1]);
+    }
+
+    fprintf(stdout, "\n");
+}
+
+void print_latency_dist (int rank)
+{
+    if (rank) {
+        return;
+    }
+
+    if (options.adaptive) {
+        fprintf(stdout, "%*.*f", FIELD_WIDTH, FLOAT_PRECISION,
+                adaptive_state.ci);
+        omb_result_field("ci95_pct", adaptive_state.ci);
+    }
+
+    if (options.show_percentiles) {
+        fprintf(stdout, "%*.*f%*.*f%*.*f%*.*f",
+                FIELD_WIDTH, FLOAT_PRECISION, lat_percentile(0.50),
+                FIELD_WIDTH, FLOAT_PRECISION, lat_percentile(0.90),
+                FIELD_WIDTH, FLOAT_PRECISION, lat_percentile(0.99),
+                FIELD_WIDTH, FLOAT_PRECISION, lat_percentile(0.999));
+        omb_result_field("p50_latency_us", lat_percentile(0.50));
+        omb_result_field("p90_latency_us", lat_percentile(0.90));
+        omb_result_field("p99_latency_us", lat_percentile(0.99));
+        omb_result_field("p99.9_latency_us", lat_percentile(0.999));
+    }
+    fprintf(stdout, "\n");
+
+    if (options.show_percentiles) {
+        print_latency_histogram();
+    }
+}
+
+/*
+ * The sizes selected with -m, in units of UNIT bytes (sizeof(float) for
+ * reductions).  The sweep itself is stateless so that threads can walk it
+ * independently.  With --refine, rank 0 then bisects the intervals whose
+ * metric departs from the trend of both neighbouring intervals by more than
+ * the threshold, and broadcasts each new size to the other ranks.
+ */
+#define REFINE_MAX_POINTS 256
+#define REFINE_RESOLUTION 64
+
+static struct {
+    int active;
+    int stalled;
+    int npoints;
+    size_t size[REFINE_MAX_POINTS];
+    double value[REFINE_MAX_POINTS];
+} refine_state;
+
+/* next byte size of the sweep after BYTES (-1 before the first) */
+static long long next_size_bytes (long long bytes)
+{
+    long long next;
+    int i;
+
+    if (SIZE_STEP_LIST == options.size_step) {
+        for (i = 0; i < options.size_list_len; i++) {
+            if ((long long)options.size_list[i] > bytes) {
+                return options.size_list[i];
+            }
+        }
+        return -1;
+    }
+
+    if (bytes < (long long)options.min_message_size) {
+        return options.min_message_size;
+    }
+
+    if (SIZE_STEP_LINEAR == options.size_step) {
+        next = options.min_message_size + ((bytes - options.min_message_size) /
+                (long long)options.size_step_value + 1) *
+            (long long)options.size_step_value;
+    } else {
+        /* each step rounds, so FACTOR < 2 still makes progress */
+        next = options.min_message_size;
+        while (next <= bytes) {
+            next = next ? MAX(next + 1,
+                    llround(next * options.size_step_value)) : 1;
+        }
+    }
+
+    return next <= (long long)options.max_message_size ? next : -1;
+}
+
+static int bytes_to_count (long long bytes, int unit)
+{
+    return unit > 1 ? MAX(1, bytes / unit) : bytes;
+}
+
+static void add_refine_point (size_t size, double value)
+{
+    int i, j;
+
+    if (REFINE_MAX_POINTS == refine_state.npoints) {
+        return;
+    }
+
+    for (i = 0; i < refine_state.npoints && refine_state.size[i] < size; i++);
+    if (i < refine_state.npoints && refine_state.size[i] == size) {
+        return;
+    }
+
+    for (j = refine_state.npoints; j > i; j--) {
+        refine_state.size[j] = refine_state.size[j - 1];
+        refine_state.value[j] = refine_state.value[j - 1];
+    }
+    refine_state.size[i] = size;
+    refine_state.value[i] = value;
+    refine_state.npoints++;
+}
+
+/* how far interval I departs from the slope of neighbouring interval J */
+static double refine_jump (int i, int j)
+{
+    double slope = (refine_state.value[j + 1] - refine_state.value[j]) /
+        ((double)refine_state.size[j + 1] - refine_state.size[j]);
+
+    return fabs(refine_state.value[i + 1] - refine_state.value[i] - slope *
+            ((double)refine_state.size[i + 1] - refine_state.size[i]));
+}
+
+/* midpoint of the first interval with a discontinuity, or -1 */
+static long long find_refine_size (int unit)
+{
+    double jump, scale;
+    size_t a, b, mid;
+    int i, n = refine_state.npoints;
+
+    if (n >= REFINE_MAX_POINTS) {
+        return -1;
+    }
+
+    for (i = 0; i + 1 < n; i++) {
+        a = refine_state.size[i];
+        b = refine_state.size[i + 1];
+        if (b - a < (size_t)MAX(2 * unit, 2) ||
+                b - a <= a / REFINE_RESOLUTION) {
+            continue;
+        }
+
+        /* a step breaks the trend seen from both sides */
+        jump = DBL_MAX;
+        if (i > 0) {
+            jump = MIN(jump, refine_jump(i, i - 1));
+        }
+        if (i + 2 < n) {
+            jump = MIN(jump, refine_jump(i, i + 1));
+        }
+        if (DBL_MAX == jump) {
+            continue;
+        }
+
+        scale = MAX(fabs(refine_state.value[i]),
+                fabs(refine_state.value[i + 1]));
+        if (jump > options.refine_threshold / 100.0 * scale) {
+            mid = a + (b - a) / 2;
+            mid -= mid % unit;
+            if (mid > a && mid < b) {
+                return mid;
+            }
+        }
+    }
+
+    return -1;
+}
+
+int first_message_size (int unit)
+{
+    refine_state.active = 0;
+    refine_state.stalled = 0;
+    refine_state.npoints = 0;
+
+    return next_message_size(-1, unit);
+}
+
+/* the size after SIZE, or a size past options.max_message_size at the end */
+int next_message_size (int size, int unit)
+{
+    long long bytes = size < 0 ? -1 : (long long)size * unit;
+    long long next = bytes;
+    double value;
+    int rank, recorded, added = 0;
+
+    /* a size the benchmark skipped leaves no record of its own */
+    if (options.refine_threshold > 0 && size >= 0 &&
+            omb_take_result(&recorded, &value) && recorded == bytes) {
+        add_refine_point(recorded, value);
+        added = 1;
+    }
+
+    /* bisecting again would only pick the size that was skipped */
+    if (refine_state.active && !added) {
+        refine_state.stalled = 1;
+    }
+
+    if (!refine_state.active) {
+        do {
+            next = next_size_bytes(next);
+        } while (next >= 0 && size >= 0 && bytes_to_count(next, unit) <= size);
+
+        if (next >= 0) {
+            return bytes_to_count(next, unit);
+        }
+        refine_state.active = (options.refine_threshold > 0);
+    }
+
+    if (refine_state.active) {
+        MPI_CHECK(MPI_Comm_rank(MPI_COMM_WORLD, &rank));
+        if (0 == rank) {
+            next = refine_state.stalled ? -1 : find_refine_size(unit);
+        }
+        MPI_CHECK(MPI_Bcast(&next, 1, MPI_LONG_LONG, 0, MPI_COMM_WORLD));
+        if (next >= 0) {
+            return next / unit;
+        }
+    }
+
+    return options.max_message_size / unit + 1;
+}
+
+/*
+ * Offset and drift of the local clock against rank 0 of the communicator the
+ * model was fitted on; synchronizing another group starts a new model.
+ * Every call to sync_clocks adds a few samples, each the ping-pong with the
+ * smallest round trip of its epoch so that queuing delays do not bias it.
+ * The offset is a least-squares line through all samples; its slope is only
+ * trusted once the samples span CLOCK_SYNC_MIN_SPAN, so drift needs repeated
+ * calls, which resync_clocks spaces CLOCK_RESYNC_INTERVAL apart.
+ */
+#define CLOCK_SYNC_EPOCHS 4
+#define CLOCK_SYNC_ROUNDS 25
+#define CLOCK_SYNC_HISTORY 256
+#define CLOCK_SYNC_MIN_SPAN 1.0
+#define CLOCK_RESYNC_INTERVAL 10.0
+#define CLOCK_SYNC_TAG 1001
+
+static double sync_time[CLOCK_SYNC_HISTORY];
+static double sync_offset[CLOCK_SYNC_HISTORY];
+static int sync_points = 0;
+static double clock_offset = 0.0, clock_drift = 0.0, clock_ref = 0.0;
+static double clock_error = 0.0, clock_last_sync = 0.0;
+static MPI_Group clock_group = MPI_GROUP_NULL;
+
+/* whether the model was fitted on the group of comm, in the same order */
+static int clock_model_matches (MPI_Comm comm)
+{
+    MPI_Group group;
+    int result = MPI_UNEQUAL;
+
+    if (MPI_GROUP_NULL == clock_group) {
+        return 0;
+    }
+
+    MPI_CHECK(MPI_Comm_group(comm, &group));
+    MPI_CHECK(MPI_Group_compare(group, clock_group, &result));
+    MPI_CHECK(MPI_Group_free(&group));
+
+    return MPI_IDENT == result;
+}
+
+static void add_sync_point (double t, double offset)
+{
+    if (CLOCK_SYNC_HISTORY == sync_points) {
+        memmove(sync_time, sync_time + 1, (sync_points - 1) * sizeof(double));
+        memmove(sync_offset, sync_offset + 1,
+                (sync_points - 1) * sizeof(double));
+        sync_points--;
+    }
+
+    sync_time[sync_points] = t;
+    sync_offset[sync_points] = offset;
+    sync_points++;
+}
+
+static void fit_clock_model (void)
+{
+    double mean_t = 0.0, mean_o = 0.0, var = 0.0, cov = 0.0;
+    int i;
+
+    for (i = 0; i < sync_points; i++) {
+        mean_t += sync_time[i];
+        mean_o += sync_offset[i];
+    }
+    mean_t /= sync_points;
+    mean_o /= sync_points;
+
+    for (i = 0; i < sync_points; i++) {
+        var += (sync_time[i] - mean_t) * (sync_time[i] - mean_t);
+        cov += (sync_time[i] - mean_t) * (sync_offset[i] - mean_o);
+    }
+
+    clock_ref = mean_t;
+    clock_offset = mean_o;
+    clock_drift = 0.0;
+    if (sync_time[sync_points - 1] - sync_time[0] >= CLOCK_SYNC_MIN_SPAN) {
+        clock_drift = cov / var;
+    }
+}
+
+void sync_clocks (MPI_Comm comm)
+{
+    MPI_Comm sync_comm;
+    double t_send, t_recv, t_root, rtt, min_rtt, best_t = 0.0, best_o = 0.0;
+    double error = 0.0;
+    int rank, numprocs, epoch, peer, i;
+
+    if (!clock_model_matches(comm)) {
+        if (MPI_GROUP_NULL != clock_group) {
+            MPI_CHECK(MPI_Group_free(&clock_group));
+        }
+        MPI_CHECK(MPI_Comm_group(comm, &clock_group));
+        sync_points = 0;
+        clock_offset = clock_drift = clock_ref = 0.0;
+    }
+
+    MPI_CHECK(MPI_Comm_dup(comm, &sync_comm));
+    MPI_CHECK(MPI_Comm_rank(sync_comm, &rank));
+    MPI_CHECK(MPI_Comm_size(sync_comm, &numprocs));
+
+    /* epochs are interleaved across peers so each rank's samples are spread
+     * over the whole synchronization */
+    for (epoch = 0; epoch < CLOCK_SYNC_EPOCHS; epoch++) {
+        for (peer = 1; peer < numprocs; peer++) {
+            if (0 == rank) {
+                for (i = 0; i < CLOCK_SYNC_ROUNDS; i++) {
+                    MPI_CHECK(MPI_Recv(&t_root, 1, MPI_DOUBLE, peer,
+                                CLOCK_SYNC_TAG, sync_comm, MPI_STATUS_IGNORE));
+                    t_root = MPI_Wtime();
+                    MPI_CHECK(MPI_Send(&t_root, 1, MPI_DOUBLE, peer,
+                                CLOCK_SYNC_TAG, sync_comm));
+                }
+            } else if (peer == rank) {
+                min_rtt = DBL_MAX;
+                for (i = 0; i < CLOCK_SYNC_ROUNDS; i++) {
+                    t_send = MPI_Wtime();
+                    MPI_CHECK(MPI_Send(&t_send, 1, MPI_DOUBLE, 0,
+                                CLOCK_SYNC_TAG, sync_comm));
+                    MPI_CHECK(MPI_Recv(&t_root, 1, MPI_DOUBLE, 0,
+                                CLOCK_SYNC_TAG, sync_comm, MPI_STATUS_IGNORE));
+                    t_recv = MPI_Wtime();
+
+                    rtt = t_recv - t_send;
+                    if (rtt < min_rtt) {
+                        min_rtt = rtt;
+                        best_t = (t_send + t_recv) / 2;
+                        best_o = t_root - best_t;
+                    }
+                }
+                add_sync_point(best_t, best_o);
+                error = MAX(error, min_rtt / 2);
+            }
+        }
+    }
+
+    if (rank) {
+        fit_clock_model();
+    }
+
+    MPI_CHECK(MPI_Allreduce(&error, &clock_error, 1, MPI_DOUBLE, MPI_MAX,
+                sync_comm));
+    MPI_CHECK(MPI_Comm_free(&sync_comm));
+    clock_last_sync = MPI_Wtime();
+}
+
+/*
+ * sync_clocks only when comm has no model yet or its last synchronization
+ * is older than CLOCK_RESYNC_INTERVAL, so callers can use it once per
+ * message size without paying the serialized ping-pongs every time.
+ */
+void resync_clocks (MPI_Comm comm)
+{
+    int stale = !clock_model_matches(comm) ||
+        MPI_Wtime() - clock_last_sync > CLOCK_RESYNC_INTERVAL;
+
+    MPI_CHECK(MPI_Allreduce(MPI_IN_PLACE, &stale, 1, MPI_INT, MPI_MAX, comm));
+    if (stale) {
+        sync_clocks(comm);
+    }
+}
+
+/* MPI_Wtime on the timeline of rank 0 of the synchronized communicator */
+double global_time (void)
+{
+    double t = MPI_Wtime();
+
+    return t + clock_offset + clock_drift * (t - clock_ref);
+}
+
+/* largest half round trip behind the last synchronization, in seconds */
+double clock_sync_error (void)
+{
+    return clock_error;
+}
+
+/* the number of windows can grow while the loop runs (adaptive iterations) */
+static void reserve_sync_windows (size_t len)
+{
+    size_t cap = MAX(len, 2 * sync_state.missed_len);
+
+    if (len <= sync_state.missed_len) {
+        return;
+    }
+
+    sync_state.missed = realloc(sync_state.missed, cap);
+    sync_state.missed_any = realloc(sync_state.missed_any, cap);
+    if (NULL == sync_state.missed || NULL == sync_state.missed_any) {
+        fprintf(stderr, "Could Not Allocate Memory for iteration sync\n");
+        MPI_CHECK(MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE));
+    }
+
+    memset(sync_state.missed + sync_state.missed_len, 0,
+            cap - sync_state.missed_len);
+    sync_state.missed_len = cap;
+}
+
+static void wait_sync_window (int window)
+{
+    double target = sync_state.start + window * sync_state.length;
+
+    if (global_time() > target) {
+        reserve_sync_windows(window + 1);
+        sync_state.missed[window] = 1;
+        return;
+    }
+
+    while (global_time() < target) {
+        cpu_relax();
+    }
+}
+
+static void setup_sync_windows (MPI_Comm comm)
+{
+    double local[2], global[2];
+
+    local[0] = sync_state.period_count ?
+        sync_state.period_sum / sync_state.period_count : 0.0;
+    local[1] = global_time();
+    MPI_CHECK(MPI_Allreduce(local, global, 2, MPI_DOUBLE, MPI_MAX, comm));
+
+    if (options.sync_window > 0) {
+        sync_state.length = options.sync_window * 1e-6;
+    } else if (global[0] > 0) {
+        sync_state.length = SYNC_WINDOW_SCALE * global[0] +
+            2 * clock_sync_error();
+    } else {
+        sync_state.length = SYNC_WINDOW_DEFAULT;
+    }
+
+    sync_state.start = global[1] + sync_state.length;
+    wait_sync_window(0);
+}
+
+void iteration_sync_begin (MPI_Comm comm)
+{
+    if (ITERATION_SYNC_WINDOW != options.iteration_sync) {
+        MPI_CHECK(MPI_Barrier(comm));
+        return;
+    }
+
+    reserve_sync_windows(options.iterations);
+    memset(sync_state.missed, 0, sync_state.missed_len);
+
+    /* the first size synchronizes the clocks, later ones only when stale */
+    resync_clocks(comm);
+
+    sync_state.period_sum = 0.0;
+    sync_state.period_count = 0;
+    sync_state.calls = 0;
+
+    if (0 == options.skip) {
+        setup_sync_windows(comm);
+    } else {
+        MPI_CHECK(MPI_Barrier(comm));
+        sync_state.last = MPI_Wtime();
+    }
+}
+
+/* call at the end of every warmup and timed iteration */
+void iteration_sync (MPI_Comm comm)
+{
+    int call;
+
+    if (ITERATION_SYNC_WINDOW != options.iteration_sync) {
+        MPI_CHECK(MPI_Barrier(comm));
+        return;
+    }
+
+    call = sync_state.calls++;
+
+    if (call < (int)options.skip) {
+        /* the first warmup iteration is usually an outlier */
+        if (call > 0) {
+            sync_state.period_sum += MPI_Wtime() - sync_state.last;
+            sync_state.period_count++;
+        }
+
+        if (call == (int)options.skip - 1) {
+            setup_sync_windows(comm);
+        } else {
+            MPI_CHECK(MPI_Barrier(comm));
+            sync_state.last = MPI_Wtime();
+        }
+    } else {
+        wait_sync_window(call - options.skip + 1);
+    }
+}
+
+void iteration_sync_end (MPI_Comm comm)
+{
+    size_t len = options.iterations, i;
+    int rank, missed = 0;
+
+    if (ITERATION_SYNC_WINDOW != options.iteration_sync) {
+        return;
+    }
+
+    reserve_sync_windows(len);
+
+    MPI_CHECK(MPI_Comm_rank(comm, &rank));
+    MPI_CHECK(MPI_Reduce(sync_state.missed, sync_state.missed_any, len,
+                MPI_UNSIGNED_CHAR, MPI_MAX, 0, comm));
+
+    if (0 == rank) {
+        for (i = 0; i < len; i++) {
+            missed += sync_state.missed_any[i];
+        }
+        sync_state.missed_pct = len ? 100.0 * missed / len : 0.0;
+    }
+}
+
+/*
+ * Global arrival and exit timestamps of every timed iteration.  Rank 0
+ * reduces them into the average skews reported next to the latency.
+ */
+enum {
+    SKEW_LAST_ARRIVAL_TO_EXIT,
+    SKEW_ARRIVAL,
+    SKEW_EXIT,
+    SKEW_LEN
+};
+
+static double *skew_samples = NULL;
+static double *skew_max = NULL, *skew_min = NULL;
+static size_t skew_samples_len = 0;
+static double skew_stats[SKEW_LEN];
+
+int allocate_skew_samples (void)
+{
+    skew_samples_len = MAX(options.iterations, options.iterations_large);
+
+    skew_samples = malloc(2 * skew_samples_len * sizeof(double));
+    skew_max = malloc(2 * skew_samples_len * sizeof(double));
+    skew_min = malloc(2 * skew_samples_len * sizeof(double));
+
+    return (NULL == skew_samples || NULL == skew_max || NULL == skew_min);
+}
+
+void free_skew_samples (void)
+{
+    free(skew_samples);
+    free(skew_max);
+    free(skew_min);
+    skew_samples = skew_max = skew_min = NULL;
+}
+
+/* arrival and exit in seconds on the global_time() timeline */
+void record_skew_sample (int iteration, double arrival, double exit)
+{
+    if ((size_t)iteration < skew_samples_len) {
+        skew_samples[2 * iteration] = arrival;
+        skew_samples[2 * iteration + 1] = exit;
+    }
+}
+
+void reduce_skew_samples (MPI_Comm comm, int count)
+{
+    int rank, i;
+
+    count = MIN((size_t)count, skew_samples_len);
+
+    MPI_CHECK(MPI_Comm_rank(comm, &rank));
+    MPI_CHECK(MPI_Reduce(skew_samples, skew_max, 2 * count, MPI_DOUBLE,
+                MPI_MAX, 0, comm));
+    MPI_CHECK(MPI_Reduce(skew_samples, skew_min, 2 * count, MPI_DOUBLE,
+                MPI_MIN, 0, comm));
+
+    memset(skew_stats, 0, sizeof(skew_stats));
+    if (rank || 0 == count) {
+        return;
+    }
+
+    for (i = 0; i < count; i++) {
+        skew_stats[SKEW_LAST_ARRIVAL_TO_EXIT] +=
+            skew_max[2 * i + 1] - skew_max[2 * i];
+        skew_stats[SKEW_ARRIVAL] += skew_max[2 * i] - skew_min[2 * i];
+        skew_stats[SKEW_EXIT] += skew_max[2 * i + 1] - skew_min[2 * i + 1];
+    }
+
+    for (i = 0; i < SKEW_LEN; i++) {
+        skew_stats[i] = skew_stats[i] * 1e6 / count;
+    }
+}
+
+void print_stats_pap (int rank, int size, double avg_time, double min_time,
+                      double max_time, int errors)
+{
+    if (rank) {
+        return;
+    }
+
+    fprintf(stdout, "%-*d", 10, size);
+    fprintf(stdout, "%*.*f", FIELD_WIDTH, FLOAT_PRECISION, avg_time);
+    if (options.validate) {
+        fprintf(stdout, "%*d", FIELD_WIDTH, errors);
+    }
+
+    if (options.show_full) {
+        fprintf(stdout, "%*.*f%*.*f%*lu",
+                FIELD_WIDTH, FLOAT_PRECISION, min_time,
+                FIELD_WIDTH, FLOAT_PRECISION, max_time,
+                12, options.iterations);
+    }
+
+    fprintf(stdout, "%*.*f%*.*f%*.*f",
+            FIELD_WIDTH, FLOAT_PRECISION, skew_stats[SKEW_LAST_ARRIVAL_TO_EXIT],
+            FIELD_WIDTH, FLOAT_PRECISION, skew_stats[SKEW_ARRIVAL],
+            FIELD_WIDTH, FLOAT_PRECISION, skew_stats[SKEW_EXIT]);
+
+    record_comm_size(MPI_COMM_WORLD);
+    omb_result_begin(size, options.iterations);
+    omb_result_metric("latency_us", avg_time);
+    omb_result_field("min_latency_us", min_time);
+    omb_result_field("max_latency_us", max_time);
+    omb_result_field("last_arrival_to_exit_us",
+            skew_stats[SKEW_LAST_ARRIVAL_TO_EXIT]);
+    omb_result_field("arrival_skew_us", skew_stats[SKEW_ARRIVAL]);
+    omb_result_field("exit_skew_us", skew_stats[SKEW_EXIT]);
+    if (options.validate) {
+        omb_result_field("errors", errors);
+    }
+    print_latency_dist(rank);
+    omb_result_end();
+
+    fflush(stdout);
+}
+
+/*
+ * Arrival delays come from a counter-based generator keyed on the rank (or
+ * node), the message size and the iteration, so every pattern is
+ * reproducible across runs, each message size sees its own delays, and the
+ * ranks of one node draw the same delay without communicating.
+ */
+#define ARRIVAL_NODE_KEY (1ULL << 32)
+#define ARRIVAL_TAIL_CAP 10.0
+#define ARRIVAL_PARETO_ALPHA 1.5
+
+static int arrival_rank = 0;
+static int arrival_late_rank = 0;
+static int arrival_node = 0;
+static double *arrival_trace = NULL;
+static int arrival_trace_len = 0;
+
+static uint64_t arrival_hash (uint64_t key, uint64_t counter)
+{
+    uint64_t z = key * 0x9e3779b97f4a7c15ULL + counter;
+
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+
+    return z ^ (z >> 31);
+}
+
+/* Uniform in (0, 1), two independent streams per size and iteration */
+static double arrival_random (uint64_t key, size_t size, int iteration,
+        int stream)
+{
+    uint64_t bits = arrival_hash(arrival_hash(key, size),
+            ((uint64_t)iteration << 1) | stream);
+
+    return ((bits >> 11) + 0.5) / 9007199254740992.0;
+}
+
+/*
+ * Rank 0 reads the trace and broadcasts it; each rank keeps its own column
+ * converted to seconds.  Rows are iterations, columns are ranks, values are
+ * delays in microseconds and lines starting with '#' are ignored.
+ */
+static int read_arrival_trace (int rank, int numprocs)
+{
+    char *line = NULL, *p, *end;
+    double *values = NULL, *tmp, value;
+    size_t len = 0, cap = 0, line_cap = 0;
+    int dims[2] = {0, 0}, cols, i;
+    FILE *fp;
+
+    if (0 == rank) {
+        if ((fp = fopen(options.arrival_trace, "r")) != NULL) {
+            while (dims[1] >= 0 && getline(&line, &line_cap, fp) > 0) {
+                if ('#' == line[0]) {
+                    continue;
+                }
+
+                for (cols = 0, p = line; ; p = end, cols++) {
+                    value = strtod(p, &end);
+                    if (end == p) {
+                        break;
+                    }
+                    if (len == cap) {
+                        cap = cap ? 2 * cap : 1024;
+                        if ((tmp = realloc(values, cap * sizeof(double))) ==
+                                NULL) {
+                            dims[1] = -1;
+                            break;
+                        }
+                        values = tmp;
+                    }
+                    values[len++] = value;
+                }
+
+                if (0 == cols || dims[1] < 0) {
+                    continue;
+                } else if (0 == dims[1]) {
+                    dims[1] = cols;
+                } else if (cols != dims[1]) {
+                    dims[1] = -1;
+                }
+                dims[0]++;
+            }
+            free(line);
+            fclose(fp);
+        }
+
+        if (dims[1] <= 0) {
+            fprintf(stderr, "Could not read arrival trace [%s]\n",
+                    options.arrival_trace);
+            dims[0] = 0;
+        }
+    }
+
+    MPI_CHECK(MPI_Bcast(dims, 2, MPI_INT, 0, MPI_COMM_WORLD));
+    if (0 == dims[0]) {
+        free(values);
+        return -1;
+    }
+
+    if (rank && (values = malloc(dims[0] * dims[1] * sizeof(double))) == NULL) {
+        MPI_CHECK(MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE));
+    }
+    MPI_CHECK(MPI_Bcast(values, dims[0] * dims[1], MPI_DOUBLE, 0,
+                MPI_COMM_WORLD));
+
+    if ((arrival_trace = malloc(dims[0] * sizeof(double))) == NULL) {
+        MPI_CHECK(MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE));
+    }
+    for (i = 0; i < dims[0]; i++) {
+        arrival_trace[i] = values[i * dims[1] + rank % dims[1]] * 1e-6;
+    }
+    arrival_trace_len = dims[0];
+    free(values);
+
+    return 0;
+}
+
+int init_arrival_pattern (int rank, int numprocs)
+{
+    arrival_rank = rank;
+    arrival_late_rank = (options.arrival_rank < 0) ? numprocs - 1 :
+        options.arrival_rank % numprocs;
+
+    if (ARRIVAL_NODE == options.arrival_pattern) {
+#if MPI_VERSION >= 3
+        MPI_Comm node_comm, leader_comm;
+        int local_rank;
+
+        MPI_CHECK(MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED,
+                    rank, MPI_INFO_NULL, &node_comm));
+        MPI_CHECK(MPI_Comm_rank(node_comm, &local_rank));
+        MPI_CHECK(MPI_Comm_split(MPI_COMM_WORLD, local_rank ? MPI_UNDEFINED : 0,
+                    rank, &leader_comm));
+        if (MPI_COMM_NULL != leader_comm) {
+            MPI_CHECK(MPI_Comm_rank(leader_comm, &arrival_node));
+            MPI_CHECK(MPI_Comm_free(&leader_comm));
+        }
+        MPI_CHECK(MPI_Bcast(&arrival_node, 1, MPI_INT, 0, node_comm));
+        MPI_CHECK(MPI_Comm_free(&node_comm));
+#else
+        arrival_node = rank;
+#endif
+    } else if (ARRIVAL_TRACE == options.arrival_pattern) {
+        return read_arrival_trace(rank, numprocs);
+    }
+
+    return 0;
+}
+
+void free_arrival_pattern (void)
+{
+    free(arrival_trace);
+    arrival_trace = NULL;
+    arrival_trace_len = 0;
+}
+
+/*
+ * Delay in seconds before this rank enters the collective of SIZE bytes in
+ * the given iteration.  Generated patterns scale with unit (the
+ * point-to-point latency) and options.max_imbalance_factor; traces are
+ * replayed as recorded.
+ */
+double arrival_delay (size_t size, int iteration, double unit)
+{
+    double max = options.max_imbalance_factor;
+    double factor = 0.0, u;
+
+    u = arrival_random(arrival_rank, size, iteration, 0);
+
+    switch (options.arrival_pattern) {
+        case ARRIVAL_DEFAULT:
+            if (1 == arrival_rank) {
+                factor = max;
+            } else if (arrival_rank) {
+                factor = u * max;
+            }
+            break;
+        case ARRIVAL_UNIFORM:
+            factor = u * max;
+            break;
+        case ARRIVAL_NORMAL:
+            factor = max / 2 + max / 6 * sqrt(-2.0 * log(u)) *
+                cos(2.0 * M_PI *
+                        arrival_random(arrival_rank, size, iteration, 1));
+            factor = MIN(MAX(factor, 0.0), max);
+            break;
+        case ARRIVAL_EXPONENTIAL:
+            factor = MIN(-max / 4 * log(u), ARRIVAL_TAIL_CAP * max);
+            break;
+        case ARRIVAL_PARETO:
+            factor = max / 8 * (pow(u, -1.0 / ARRIVAL_PARETO_ALPHA) - 1.0);
+            factor = MIN(factor, ARRIVAL_TAIL_CAP * max);
+            break;
+        case ARRIVAL_LATE:
+            factor = (arrival_rank == arrival_late_rank) ? max : 0.0;
+            break;
+        case ARRIVAL_NODE:
+            factor = arrival_random(ARRIVAL_NODE_KEY | arrival_node, size,
+                    iteration, 0) * max;
+            break;
+        case ARRIVAL_TRACE:
+            return arrival_trace[iteration % arrival_trace_len];
+    }
+
+    return factor * unit;
+}
+
+void print_arrival_pattern (int rank)
+{
+    static char const * const names[] = {
+        "default (rank 0 first, rank 1 last, others uniform)",
+        "uniform", "normal", "exponential", "pareto", "late", "per-node uniform",
+        "trace"
+    };
+
+    if (rank) {
+        return;
+    }
+
+    if (ARRIVAL_LATE == options.arrival_pattern) {
+        fprintf(stdout, "# Arrival pattern: late rank %d\n", arrival_late_rank);
+    } else if (ARRIVAL_TRACE == options.arrival_pattern) {
+        fprintf(stdout, "# Arrival pattern: trace %s (%d iterations)\n",
+                options.arrival_trace, arrival_trace_len);
+    } else {
+        fprintf(stdout, "# Arrival pattern: %s\n",
+                names[options.arrival_pattern]);
+    }
+    fflush(stdout);
+}
+
+/*
+ * Pair placement.  Rank 0 gathers the node and socket of every rank, builds
+ * the pairs and broadcasts them as a list of (initiator, responder) ranks.
+ * Nodes come from MPI_Comm_split_type and sockets from the physical package
+ * of the CPU each rank runs on when the pairs are built, so ranks should be
+ * pinned.  Ranks left without a partner sit out the timed loops.
+ */
+#define PAIRING_PACKAGE_PATH \
+    "/sys/devices/system/cpu/cpu%d/topology/physical_package_id"
+
+static int pairing_ready = 0;
+static int pair_count = 0;
+static int pair_partner_rank = -1;
+static int pair_initiator_flag = 0;
+static int pair_placement[3];
+
+static int current_socket (void)
+{
+    char path[128];
+    int cpu, socket = -1;
+    FILE *fp;
+
+    if ((cpu = sched_getcpu()) < 0) {
+        return -1;
+    }
+
+    snprintf(path, sizeof(path), PAIRING_PACKAGE_PATH, cpu);
+    if ((fp = fopen(path, "r")) != NULL) {
+        if (1 != fscanf(fp, "%d", &socket)) {
+            socket = -1;
+        }
+        fclose(fp);
+    }
+
+    return socket;
+}
+
+static int current_node (int rank)
+{
+    int node = rank;
+#if MPI_VERSION >= 3
+    MPI_Comm node_comm, leader_comm;
+    int local_rank;
+
+    MPI_CHECK(MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, rank,
+                MPI_INFO_NULL, &node_comm));
+    MPI_CHECK(MPI_Comm_rank(node_comm, &local_rank));
+    MPI_CHECK(MPI_Comm_split(MPI_COMM_WORLD, local_rank ? MPI_UNDEFINED : 0,
+                rank, &leader_comm));
+    if (MPI_COMM_NULL != leader_comm) {
+        MPI_CHECK(MPI_Comm_rank(leader_comm, &node));
+        MPI_CHECK(MPI_Comm_free(&leader_comm));
+    }
+    MPI_CHECK(MPI_Bcast(&node, 1, MPI_INT, 0, node_comm));
+    MPI_CHECK(MPI_Comm_free(&node_comm));
+#endif
+
+    return node;
+}
+
+/* whether ranks a and b (indices into topo) may form a pair */
+static int pair_allowed (int const *topo, int a, int b)
+{
+    int same_node = topo[2 * a] == topo[2 * b];
+    int same_socket = same_node && topo[2 * a + 1] == topo[2 * b + 1];
+
+    switch (options.pairing) {
+        case PAIRING_INTRA_SOCKET:
+            return same_socket;
+        case PAIRING_CROSS_SOCKET:
+            return same_node && !same_socket;
+        case PAIRING_CROSS_NODE:
+            return !same_node;
+        default:
+            return 1;
+    }
+}
+
+/*
+ * Pair each unused rank, in the given order, with the next unused rank that
+ * pair_allowed accepts.  Returns the number of pairs written to table.
+ */
+static int pair_greedy (int const *topo, int const *order, int numprocs,
+        int pairs, int *table)
+{
+    char *used = calloc(numprocs, 1);
+    int i, j, n = 0;
+
+    if (NULL == used) {
+        return 0;
+    }
+
+    for (i = 0; i < numprocs && n < pairs; i++) {
+        if (used[order[i]]) {
+            continue;
+        }
+
+        for (j = i + 1; j < numprocs; j++) {
+            if (!used[order[j]] && pair_allowed(topo, order[i], order[j])) {
+                used[order[i]] = used[order[j]] = 1;
+                table[2 * n] = order[i];
+                table[2 * n + 1] = order[j];
+                n++;
+                break;
+            }
+        }
+    }
+
+    free(used);
+
+    return n;
+}
+
+/* "A B" per line, initiator first; lines starting with '#' are ignored */
+static int read_pairing_map (int numprocs, int pairs, int *table)
+{
+    char line[256];
+    char *used = calloc(numprocs, 1);
+    int a, b, n = 0;
+    FILE *fp;
+
+    if (NULL == used || (fp = fopen(options.pairing_map, "r")) == NULL) {
+        free(used);
+        return -1;
+    }
+
+    while (n < pairs && fgets(line, sizeof(line), fp)) {
+        if ('#' == line[0]) {
+            continue;
+        }
+        if (2 != sscanf(line, "%d %d", &a, &b)) {
+            continue;
+        }
+        if (a < 0 || b < 0 || a >= numprocs || b >= numprocs || a == b ||
+                used[a] || used[b]) {
+            n = -1;
+            break;
+        }
+        used[a] = used[b] = 1;
+        table[2 * n] = a;
+        table[2 * n + 1] = b;
+        n++;
+    }
+
+    fclose(fp);
+    free(used);
+
+    return n;
+}
+
+static int build_pairs (int const *topo, int numprocs, int pairs, int *table)
+{
+    unsigned short xsubi[3];
+    int *order;
+    int i, j, tmp, n;
+
+    if (PAIRING_MAP == options.pairing) {
+        return read_pairing_map(numprocs, pairs, table);
+    }
+
+    if (PAIRING_BLOCK == options.pairing) {
+        for (i = 0; i < pairs; i++) {
+            table[2 * i] = i;
+            table[2 * i + 1] = i + pairs;
+        }
+        return pairs;
+    }
+
+    if ((order = malloc(numprocs * sizeof(int))) == NULL) {
+        return -1;
+    }
+
+    for (i = 0; i < numprocs; i++) {
+        order[i] = i;
+    }
+
+    if (PAIRING_RANDOM == options.pairing) {
+        xsubi[0] = 0x330e;
+        xsubi[1] = (unsigned short)options.pairing_seed;
+        xsubi[2] = (unsigned short)(options.pairing_seed >> 16);
+        for (i = numprocs - 1; i > 0; i--) {
+            j = (int)(erand48(xsubi) * (i + 1));
+            tmp = order[i];
+            order[i] = order[j];
+            order[j] = tmp;
+        }
+    }
+
+    n = pair_greedy(topo, order, numprocs, pairs, table);
+    free(order);
+
+    return n;
+}
+
+/*
+ * Collective over MPI_COMM_WORLD.  Builds up to pairs pairs with the
+ * placement selected by --pairing and returns how many were built, or -1
+ * (after rank 0 has printed why) if there are none.
+ */
+int init_pairing (int rank, int numprocs, int pairs)
+{
+    int local[2], *topo = NULL, *table;
+    int i, same_node, same_socket;
+
+    local[0] = current_node(rank);
+    local[1] = current_socket();
+
+    if ((table = malloc(2 * MAX(pairs, 1) * sizeof(int))) == NULL ||
+            (0 == rank && (topo = malloc(2 * numprocs * sizeof(int))) ==
+             NULL)) {
+        MPI_CHECK(MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE));
+    }
+
+    MPI_CHECK(MPI_Gather(local, 2, MPI_INT, topo, 2, MPI_INT, 0,
+                MPI_COMM_WORLD));
+
+    if (0 == rank) {
+        pair_count = build_pairs(topo, numprocs, pairs, table);
+
+        if (pair_count < 0 && PAIRING_MAP == options.pairing) {
+            fprintf(stderr, "Could not read pairing map [%s]\n",
+                    options.pairing_map);
+        } else if (pair_count <= 0) {
+            fprintf(stderr, "No pairs can be placed%s\n",
+                    PAIRING_INTRA_SOCKET == options.pairing ? " on one socket" :
+                    PAIRING_CROSS_SOCKET == options.pairing ?
+                    " across sockets of one node" :
+                    PAIRING_CROSS_NODE == options.pairing ? " across nodes" :
+                    "");
+        }
+
+        memset(pair_placement, 0, sizeof(pair_placement));
+        for (i = 0; i < pair_count; i++) {
+            same_node = topo[2 * table[2 * i]] == topo[2 * table[2 * i + 1]];
+            same_socket = same_node && topo[2 * table[2 * i] + 1] ==
+                topo[2 * table[2 * i + 1] + 1];
+            pair_placement[same_socket ? 0 : same_node ? 1 : 2]++;
+        }
+        free(topo);
+    }
+
+    MPI_CHECK(MPI_Bcast(&pair_count, 1, MPI_INT, 0, MPI_COMM_WORLD));
+    if (pair_count <= 0) {
+        free(table);
+        return -1;
+    }
+    MPI_CHECK(MPI_Bcast(table, 2 * pair_count, MPI_INT, 0, MPI_COMM_WORLD));
+
+    pair_partner_rank = -1;
+    pair_initiator_flag = 0;
+    for (i = 0; i < pair_count; i++) {
+        if (table[2 * i] == rank) {
+            pair_partner_rank = table[2 * i + 1];
+            pair_initiator_flag = 1;
+        } else if (table[2 * i + 1] == rank) {
+            pair_partner_rank = table[2 * i];
+        }
+    }
+    pairing_ready = 1;
+    free(table);
+
+    return pair_count;
+}
+
+/* Partner of this rank, or -1 if it has none */
+int pair_partner (void)
+{
+    return pair_partner_rank;
+}
+
+/* Whether this rank sends first in its pair */
+int pair_initiator (void)
+{
+    return pair_initiator_flag;
+}
+
+/* Sender side for buffer placement, before or after init_pairing */
+static int pair_sender_side (int rank, int pairs)
+{
+    return pairing_ready ? pair_initiator_flag : rank < pairs;
+}
+
+void print_pairing (int rank)
+{
+    static char const * const names[] = {
+        "block", "intra-socket", "cross-socket", "cross-node", "random", "map"
+    };
+
+    if (rank) {
+        return;
+    }
+
+    fprintf(stdout, "# Pairing: %s", names[options.pairing]);
+    if (PAIRING_RANDOM == options.pairing) {
+        fprintf(stdout, " (seed %lu)", options.pairing_seed);
+    } else if (PAIRING_MAP == options.pairing) {
+        fprintf(stdout, " %s", options.pairing_map);
+    }
+    fprintf(stdout, ", %d pairs: %d intra-socket, %d cross-socket, "
+            "%d cross-node\n", pair_count, pair_placement[0],
+            pair_placement[1], pair_placement[2]);
+    fflush(stdout);
+}
+
+/*
+ * Pin the calling thread for --pin-threads.  Thread index goes to the
+ * index-th CPU of the list given on the command line, or with auto to the
+ * index-th CPU the process may run on, wrapping around in both cases.
+ * Returns the CPU or -1 if the thread was not pinned.
+ */
+int pin_thread (int index)
+{
+    cpu_set_t allowed, mask;
+    char const * p;
+    int cpu = -1, count, i;
+
+    if (!options.pin_threads) {
+        return -1;
+    }
+
+    if (options.thread_cpus) {
+        for (count = 1, p = options.thread_cpus; *p; p++) {
+            count += ',' == *p;
+        }
+        for (i = index % count, p = options.thread_cpus; i; p++) {
+            i -= ',' == *p;
+        }
+        cpu = atoi(p);
+    } else {
+        if (sched_getaffinity(0, sizeof(allowed), &allowed)) {
+            return -1;
+        }
+        count = CPU_COUNT(&allowed);
+        for (i = 0, index %= count; i < CPU_SETSIZE; i++) {
+            if (CPU_ISSET(i, &allowed) && 0 == index--) {
+                cpu = i;
+                break;
+            }
+        }
+    }
+
+    if (cpu < 0 || cpu >= CPU_SETSIZE) {
+        return -1;
+    }
+
+    CPU_ZERO(&mask);
+    CPU_SET(cpu, &mask);
+    if (pthread_setaffinity_np(pthread_self(), sizeof(mask), &mask)) {
+        return -1;
+    }
+
+    return cpu;
+}
+
+/*
+ * Wait for the other threads of this process, let thread 0 synchronize the
+ * processes of comm, then release all threads together.
+ */
+void sync_threads (struct spin_barrier * barrier, MPI_Comm comm, int index,
+        int * sense)
+{
+    spin_barrier_wait(barrier, sense);
+    if (0 == index) {
+        MPI_CHECK(MPI_Barrier(comm));
+    }
+    spin_barrier_wait(barrier, sense);
+}
+
+/*
+ * Persistent Requests
+ */
+void init_persistent_requests (char ** buf, int size, int peer, int tag,
+        int send, int count, MPI_Request * req)
+{
+    char * b;
+    int j;
+
+    for (j = 0; j < count; j++) {
+        b = (options.buf_num == SINGLE) ? buf[0] : buf[j];
+
+        if (send) {
+            MPI_CHECK(MPI_Send_init(b, size, MPI_CHAR, peer, tag,
+                        MPI_COMM_WORLD, req + j));
+        } else {
+            MPI_CHECK(MPI_Recv_init(b, size, MPI_CHAR, peer, tag,
+                        MPI_COMM_WORLD, req + j));
+        }
+    }
+}
+
+void free_persistent_requests (int count, MPI_Request * req)
+{
+    int j;
+
+    for (j = 0; j < count; j++) {
+        MPI_CHECK(MPI_Request_free(req + j));
+    }
+}
+
+#ifdef HAVE_MPI_PSEND_INIT
+/*
+ * With --ready threads, partition p of every request is marked ready by
+ * thread p % options.partitions; the calling thread is thread 0 and the
+ * others sleep on a condition variable until the next round starts.
+ */
+static struct {
+    pthread_mutex_t lock;
+    pthread_cond_t start;
+    pthread_cond_t done;
+    struct partition_set * set;
+    pthread_t threads[MAX_NUM_THREADS];
+    int index[MAX_NUM_THREADS];
+    int count;
+    unsigned long round;
+    int pending;
+    int stop;
+} partition_pool = {PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER,
+    PTHREAD_COND_INITIALIZER};
+
+/* partition p of a non-partitioned set travels on its own tag */
+static void ready_partition (struct partition_set * set, int r, int p)
+{
+    if (set->partitioned) {
+        MPI_CHECK(MPI_Pready(p, set->req[r]));
+    } else {
+        MPI_CHECK(MPI_Isend(set->buf + (size_t)p * set->chunk, set->chunk,
+                MPI_CHAR, set->peer, set->tag + p, set->comm,
+                &set->req[r * options.partitions + p]));
+    }
+}
+
+static void ready_partition_share (struct partition_set * set, int first,
+        int step)
+{
+    int r, p;
+
+    for (r = 0; r < set->count; r++) {
+        for (p = first; p < options.partitions; p += step) {
+            ready_partition(set, r, p);
+        }
+    }
+}
+
+static void * partition_worker (void * arg)
+{
+    int index = *(int *)arg;
+    unsigned long round = 0;
+    struct partition_set * set;
+
+    pthread_mutex_lock(&partition_pool.lock);
+    for (;;) {
+        while (partition_pool.round == round && !partition_pool.stop) {
+            pthread_cond_wait(&partition_pool.start, &partition_pool.lock);
+        }
+        if (partition_pool.stop) {
+            break;
+        }
+        round = partition_pool.round;
+        set = partition_pool.set;
+        pthread_mutex_unlock(&partition_pool.lock);
+
+        ready_partition_share(set, index, partition_pool.count);
+
+        pthread_mutex_lock(&partition_pool.lock);
+        if (0 == --partition_pool.pending) {
+            pthread_cond_signal(&partition_pool.done);
+        }
+    }
+    pthread_mutex_unlock(&partition_pool.lock);
+
+    return NULL;
+}
+
+/*
+ * Start the readiness threads of a process that sends (SEND non-zero);
+ * returns non-zero if there are too many
+ */
+int init_partition_threads (int send)
+{
+    int i;
+
+    partition_pool.count = READY_THREADS == options.ready_mode ?
+        options.partitions : 1;
+    if (partition_pool.count > MAX_NUM_THREADS) {
+        return 1;
+    }
+    if (!send) {
+        partition_pool.count = 1;
+    }
+
+    partition_pool.round = 0;
+    partition_pool.pending = 0;
+    partition_pool.stop = 0;
+
+    for (i = 1; i < partition_pool.count; i++) {
+        partition_pool.index[i] = i;
+        if (pthread_create(&partition_pool.threads[i], NULL, partition_worker,
+                    &partition_pool.index[i])) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+void free_partition_threads (void)
+{
+    int i;
+
+    pthread_mutex_lock(&partition_pool.lock);
+    partition_pool.stop = 1;
+    pthread_cond_broadcast(&partition_pool.start);
+    pthread_mutex_unlock(&partition_pool.lock);
+
+    for (i = 1; i < partition_pool.count; i++) {
+        pthread_join(partition_pool.threads[i], NULL);
+    }
+}
+
+/*
+ * COUNT messages of SIZE bytes to or from BUF, each split into
+ * options.partitions partitions: partitioned requests, or one MPI_Isend or
+ * MPI_Irecv per partition with PARTITIONED zero, partition p on tag
+ * TAG + p. A remainder of SIZE that does not fill a partition is not
+ * transferred.
+ */
+void init_partition_set (struct partition_set * set, char * buf, int size,
+        int peer, int tag, int send, int count, int partitioned)
+{
+    int r;
+
+    set->partitioned = partitioned;
+    set->send = send;
+    set->count = count;
+    set->chunk = size / options.partitions;
+    set->peer = peer;
+    set->tag = tag;
+    set->buf = buf;
+    set->comm = MPI_COMM_WORLD;
+    set->req = malloc(sizeof(MPI_Request) * count *
+            (partitioned ? 1 : options.partitions));
+
+    if (NULL == set->req) {
+        fprintf(stderr, "Error allocating partition requests\n");
+        MPI_CHECK(MPI_Abort(MPI_COMM_WORLD, 1));
+    }
+
+    for (r = 0; partitioned && r < count; r++) {
+        if (send) {
+            MPI_CHECK(MPI_Psend_init(buf, options.partitions, set->chunk,
+                    MPI_CHAR, peer, tag, set->comm, MPI_INFO_NULL,
+                    &set->req[r]));
+        } else {
+            MPI_CHECK(MPI_Precv_init(buf, options.partitions, set->chunk,
+                    MPI_CHAR, peer, tag, set->comm, MPI_INFO_NULL,
+                    &set->req[r]));
+        }
+    }
+}
+
+/* Start the requests; receives are posted here, sends only when ready */
+void start_partitions (struct partition_set * set)
+{
+    int r, p;
+
+    if (set->partitioned) {
+        MPI_CHECK(MPI_Startall(set->count, set->req));
+        return;
+    }
+
+    for (r = 0; !set->send && r < set->count; r++) {
+        for (p = 0; p < options.partitions; p++) {
+            MPI_CHECK(MPI_Irecv(set->buf + (size_t)p * set->chunk, set->chunk,
+                    MPI_CHAR, set->peer, set->tag + p, set->comm,
+                    &set->req[r * options.partitions + p]));
+        }
+    }
+}
+
+/* Mark every partition of a send set ready, in the order of --ready */
+void ready_partitions (struct partition_set * set)
+{
+    int r, p;
+
+    if (READY_STAGGERED == options.ready_mode) {
+        for (r = 0; r < set->count; r++) {
+            for (p = options.partitions - 1; p >= 0; p--) {
+                ready_partition(set, r, p);
+            }
+        }
+        return;
+    }
+
+    pthread_mutex_lock(&partition_pool.lock);
+    partition_pool.set = set;
+    partition_pool.pending = partition_pool.count - 1;
+    partition_pool.round++;
+    pthread_cond_broadcast(&partition_pool.start);
+    pthread_mutex_unlock(&partition_pool.lock);
+
+    ready_partition_share(set, 0, partition_pool.count);
+
+    pthread_mutex_lock(&partition_pool.lock);
+    while (partition_pool.pending) {
+        pthread_cond_wait(&partition_pool.done, &partition_pool.lock);
+    }
+    pthread_mutex_unlock(&partition_pool.lock);
+}
+
+/* Complete the requests; partitioned receives consume partitions in order */
+void wait_partitions (struct partition_set * set)
+{
+    int r, p, flag;
+
+    if (!set->partitioned) {
+        MPI_CHECK(MPI_Waitall(set->count * options.partitions, set->req,
+                MPI_STATUSES_IGNORE));
+        return;
+    }
+
+    for (r = 0; !set->send && r < set->count; r++) {
+        for (p = 0; p < options.partitions; p++) {
+            do {
+                MPI_CHECK(MPI_Parrived(set->req[r], p, &flag));
+            } while (!flag);
+        }
+    }
+
+    MPI_CHECK(MPI_Waitall(set->count, set->req, MPI_STATUSES_IGNORE));
+}
+
+void free_partition_set (struct partition_set * set)
+{
+    int r;
+
+    for (r = 0; set->partitioned && r < set->count; r++) {
+        MPI_CHECK(MPI_Request_free(&set->req[r]));
+    }
+
+    free(set->req);
+    set->req = NULL;
+}
+#endif /* #ifdef HAVE_MPI_PSEND_INIT */
+
+#if MPI_VERSION >= 2
+/*
+ * Derived Datatypes
+ *
+ * Every datatype describes the same layout, nblocks blocks of
+ * options.ddt_block bytes that start options.ddt_stride bytes apart, so all
+ * of them can be compared with packing the blocks by memcpy.
+ */
+char const * ddt_constructor[DDT_NUM_TYPES] = {
+    "MPI_Type_vector",
+    "MPI_Type_indexed",
+    "MPI_Type_create_subarray",
+    "MPI_Type_create_struct"
+};
+
+/*
+ * Bytes spanned by the blocks of the largest message. options.max_message_size
+ * is lowered until they fit options.max_mem_limit and the int displacements
+ * and counts of the datatype constructors.
+ */
+size_t ddt_extent (void)
+{
+    size_t limit = MIN(options.max_mem_limit, (size_t)INT_MAX);
+    size_t nblocks = options.max_message_size / options.ddt_block;
+
+    if (nblocks > limit / options.ddt_stride) {
+        nblocks = limit / options.ddt_stride;
+        options.max_message_size = nblocks * options.ddt_block;
+    }
+
+    return nblocks * options.ddt_stride;
+}
+
+MPI_Datatype create_ddt (enum ddt_type type, int nblocks)
+{
+    int block = options.ddt_block, stride = options.ddt_stride;
+    int sizes[2], subsizes[2], starts[2] = {0, 0};
+    int *lens = NULL, *displs = NULL;
+    int i, n = 0, dsize = sizeof(double), rest = block % dsize;
+    MPI_Aint *offsets = NULL;
+    MPI_Datatype *types = NULL, ddt = MPI_DATATYPE_NULL;
+
+    switch (type) {
+        case DDT_VECTOR:
+            MPI_CHECK(MPI_Type_vector(nblocks, block, stride, MPI_CHAR, &ddt));
+            break;
+        case DDT_INDEXED:
+            lens = malloc(nblocks * sizeof(int));
+            displs = malloc(nblocks * sizeof(int));
+            if (NULL == lens || NULL == displs) {
+                break;
+            }
+            for (i = 0; i < nblocks; i++) {
+                lens[i] = block;
+                displs[i] = i * stride;
+            }
+            MPI_CHECK(MPI_Type_indexed(nblocks, lens, displs, MPI_CHAR, &ddt));
+            break;
+        case DDT_SUBARRAY:
+            /* the first block columns of an nblocks x stride array */
+            sizes[0] = subsizes[0] = nblocks;
+            sizes[1] = stride;
+            subsizes[1] = block;
+            MPI_CHECK(MPI_Type_create_subarray(2, sizes, subsizes, starts,
+                    MPI_ORDER_C, MPI_CHAR, &ddt));
+            break;
+        case DDT_STRUCT:
+            /* each block as MPI_DOUBLEs followed by the remaining MPI_CHARs */
+            lens = malloc(2 * nblocks * sizeof(int));
+            offsets = malloc(2 * nblocks * sizeof(MPI_Aint));
+            types = malloc(2 * nblocks * sizeof(MPI_Datatype));
+            if (NULL == lens || NULL == offsets || NULL == types) {
+                break;
+            }
+            for (i = 0; i < nblocks; i++) {
+                if (block >= dsize) {
+                    lens[n] = block / dsize;
+                    offsets[n] = (MPI_Aint)i * stride;
+                    types[n++] = MPI_DOUBLE;
+                }
+                if (rest) {
+                    lens[n] = rest;
+                    offsets[n] = (MPI_Aint)i * stride + block - rest;
+                    types[n++] = MPI_CHAR;
+                }
+            }
+            MPI_CHECK(MPI_Type_create_struct(n, lens, offsets, types, &ddt));
+            break;
+        default:
+            break;
+    }
+
+    free(lens);
+    free(displs);
+    free(offsets);
+    free(types);
+
+    if (MPI_DATATYPE_NULL == ddt) {
+        fprintf(stderr, "Could Not Allocate Memory for datatype\n");
+        MPI_CHECK(MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE));
+    }
+
+    MPI_CHECK(MPI_Type_commit(&ddt));
+
+    return ddt;
+}
+
+/* copy nblocks strided blocks of src to contiguous dst */
+void pack_blocks (char * dst, char const * src, int nblocks)
+{
+    int i;
+
+    for (i = 0; i < nblocks; i++) {
+        memcpy(dst + i * options.ddt_block, src + i * options.ddt_stride,
+                options.ddt_block);
+    }
+}
+
+/* copy contiguous src to nblocks strided blocks of dst */
+void unpack_blocks (char * dst, char const * src, int nblocks)
+{
+    int i;
+
+    for (i = 0; i < nblocks; i++) {
+        memcpy(dst + i * options.ddt_stride, src + i * options.ddt_block,
+                options.ddt_block);
+    }
+}
+#endif /* #if MPI_VERSION >= 2 */
+
+/*
+ * Blocking Collectives
+ *
+ * One call of each blocking collective on MPI_COMM_WORLD, rooted at rank 0.
+ * The standalone latency tests and osu_coll_suite time these same calls.
+ */
+void coll_allgather (struct coll_args const * args)
+{
+    MPI_CHECK(MPI_Allgather(args->sendbuf, args->count, MPI_CHAR,
+                args->recvbuf, args->count, MPI_CHAR, MPI_COMM_WORLD));
+}
+
+void coll_allgatherv (struct coll_args const * args)
+{
+    MPI_CHECK(MPI_Allgatherv(args->sendbuf, args->count, MPI_CHAR,
+                args->recvbuf, args->counts, args->displs, MPI_CHAR,
+                MPI_COMM_WORLD));
+}
+
+void coll_allreduce (struct coll_args const * args)
+{
+    MPI_CHECK(MPI_Allreduce(args->sendbuf, args->recvbuf, args->count,
+                MPI_FLOAT, MPI_SUM, MPI_COMM_WORLD));
+}
+
+void coll_alltoall (struct coll_args const * args)
+{
+    MPI_CHECK(MPI_Alltoall(args->sendbuf, args->count, MPI_CHAR,
+                args->recvbuf, args->count, MPI_CHAR, MPI_COMM_WORLD));
+}
+
+void coll_alltoallv (struct coll_args const * args)
+{
+    MPI_CHECK(MPI_Alltoallv(args->sendbuf, args->counts, args->displs,
+                MPI_CHAR, args->recvbuf, args->counts, args->displs, MPI_CHAR,
+                MPI_COMM_WORLD));
+}
+
+void coll_barrier (struct coll_args const * args)
+{
+    MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
+}
+
+void coll_bcast (struct coll_args const * args)
+{
+    MPI_CHECK(MPI_Bcast(args->sendbuf, args->count, MPI_CHAR, 0,
+                MPI_COMM_WORLD));
+}
+
+void coll_gather (struct coll_args const * args)
+{
+    MPI_CHECK(MPI_Gather(args->sendbuf, args->count, MPI_CHAR, args->recvbuf,
+                args->count, MPI_CHAR, 0, MPI_COMM_WORLD));
 }
 
-void print_stats (int rank, int size, double avg_time, double min_time, double max_time)
+void coll_gatherv (struct coll_args const * args)
 {
-    if (rank) {
-        return;
-    }
+    MPI_CHECK(MPI_Gatherv(args->sendbuf, args->count, MPI_CHAR, args->recvbuf,
+                args->counts, args->displs, MPI_CHAR, 0, MPI_COMM_WORLD));
+}
 
-    if (options.show_size) {
-        fprintf(stdout, "%-*d", 10, size);
-        fprintf(stdout, "%*.*f", FIELD_WIDTH, FLOAT_PRECISION, avg_time);
-    } else {
-        fprintf(stdout, "%*.*f", 17, FLOAT_PRECISION, avg_time);
-    }
+void coll_reduce (struct coll_args const * args)
+{
+    MPI_CHECK(MPI_Reduce(args->sendbuf, args->recvbuf, args->count, MPI_FLOAT,
+                MPI_SUM, 0, MPI_COMM_WORLD));
+}
 
-    if (options.show_full) {
-        fprintf(stdout, "%*.*f%*.*f%*lu\n",
-                FIELD_WIDTH, FLOAT_PRECISION, min_time,
-                FIELD_WIDTH, FLOAT_PRECISION, max_time,
-                12, options.iterations);
-    } else {
-        fprintf(stdout, "\n");
-    }
+void coll_reduce_scatter (struct coll_args const * args)
+{
+    MPI_CHECK(MPI_Reduce_scatter(args->sendbuf, args->recvbuf, args->counts,
+                MPI_FLOAT, MPI_SUM, MPI_COMM_WORLD));
+}
 
-    fflush(stdout);
+void coll_scatter (struct coll_args const * args)
+{
+    MPI_CHECK(MPI_Scatter(args->sendbuf, args->count, MPI_CHAR, args->recvbuf,
+                args->count, MPI_CHAR, 0, MPI_COMM_WORLD));
 }
 
-void print_stats_validate(int rank, int size, double avg_time, double min_time,
-            double max_time, int errors)
+void coll_scatterv (struct coll_args const * args)
 {
-    if (rank) {
-        return;
-    }
+    MPI_CHECK(MPI_Scatterv(args->sendbuf, args->counts, args->displs,
+                MPI_CHAR, args->recvbuf, args->count, MPI_CHAR, 0,
+                MPI_COMM_WORLD));
+}
 
-    if (options.show_size) {
-        fprintf(stdout, "%-*d", 10, size);
-        fprintf(stdout, "%*.*f", FIELD_WIDTH, FLOAT_PRECISION, avg_time);
-    } else {
-        fprintf(stdout, "%*.*f", 17, FLOAT_PRECISION, avg_time);
+/* count elements from and to every rank, placed one after another */
+void coll_counts_uniform (struct coll_args * args, int numprocs)
+{
+    int i;
+
+    for (i = 0; i < numprocs; i++) {
+        args->counts[i] = args->count;
+        args->displs[i] = i * args->count;
     }
+}
 
-    if (options.show_full) {
-        fprintf(stdout, "%*.*f%*.*f%*lu",
-                FIELD_WIDTH, FLOAT_PRECISION, min_time,
-                FIELD_WIDTH, FLOAT_PRECISION, max_time,
-                12, options.iterations);
+/* count elements split over all ranks, the first ones taking the remainder */
+void coll_counts_split (struct coll_args * args, int numprocs)
+{
+    int i;
+
+    for (i = 0; i < numprocs; i++) {
+        if (args->count < numprocs) {
+            args->counts[i] = (i < args->count) ? 1 : 0;
+        } else {
+            args->counts[i] = args->count / numprocs +
+                ((i < args->count % numprocs) ? 1 : 0);
+        }
     }
-    fprintf(stdout, "%*d\n", FIELD_WIDTH, errors);
-    fflush(stdout);
 }
 
 void set_buffer_pt2pt (void * buffer, int rank, enum accel_type type, int data, size_t size)
@@ -802,7 +3199,8 @@ void set_buffer_pt2pt (void * buffer, int rank, enum accel_type type, int data,
     char buf_type = 'H';
 
     if (options.bench == MBW_MR) {
-        buf_type = (rank < options.pairs) ? options.src : options.dst;
+        buf_type = pair_sender_side(rank, options.pairs) ? options.src :
+            options.dst;
     } else {
         buf_type = (rank == 0) ? options.src : options.dst;
     }
@@ -1008,17 +3406,467 @@ int validate_alltoall(char *buffer, size_t size, int rank, int num_procs, int it
     return errors;
 } 
 
+/*
+ * Host Buffer Placement
+ *
+ * With any --page-policy, --numa or --prefault the host buffers of the
+ * allocate_memory_* helpers come from mmap instead of posix_memalign, so the
+ * page size and NUMA node can be chosen before the first touch. Mappings are
+ * remembered so that free_host_buffer can tell them from heap buffers.
+ */
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif
+#ifndef MAP_HUGE_2MB
+#define MAP_HUGE_2MB (21 << MAP_HUGE_SHIFT)
+#endif
+#ifndef MAP_HUGE_1GB
+#define MAP_HUGE_1GB (30 << MAP_HUGE_SHIFT)
+#endif
+
+/* from <numaif.h>; mbind is called directly to avoid linking libnuma */
+#define OMB_MPOL_BIND 2
+#define OMB_MPOL_INTERLEAVE 3
+#define OMB_MAX_NUMA_NODES 1024
+
+struct host_mapping {
+    void *addr;
+    size_t len;
+    struct host_mapping *next;
+};
+
+static struct host_mapping *host_mappings = NULL;
+
+/* Parse a node list such as "0-3,6" from sysfs into mask */
+static int read_numa_nodes (unsigned long * mask)
+{
+    FILE *fp = fopen("/sys/devices/system/node/online", "r");
+    int first, last, n, count = 0;
+    char sep;
+
+    memset(mask, 0, OMB_MAX_NUMA_NODES / 8);
+    if (NULL == fp) {
+        return 0;
+    }
+
+    while (fscanf(fp, "%d", &first) == 1) {
+        last = first;
+        if (fscanf(fp, "%c", &sep) == 1 && '-' == sep) {
+            if (fscanf(fp, "%d", &last) != 1) {
+                break;
+            }
+            if (fscanf(fp, "%c", &sep) != 1) {
+                sep = '\n';
+            }
+        }
+        for (n = first; n <= last && n < OMB_MAX_NUMA_NODES; n++) {
+            mask[n / (8 * sizeof(long))] |= 1UL << (n % (8 * sizeof(long)));
+            count++;
+        }
+        if (',' != sep) {
+            break;
+        }
+    }
+
+    fclose(fp);
+
+    return count;
+}
+
+static int numa_node_online (unsigned long const * mask, int node)
+{
+    return node >= 0 && node < OMB_MAX_NUMA_NODES &&
+        (mask[node / (8 * sizeof(long))] >> (node % (8 * sizeof(long)))) & 1;
+}
+
+static int bind_host_buffer (void * addr, size_t len)
+{
+    unsigned long online[OMB_MAX_NUMA_NODES / (8 * sizeof(long))];
+    unsigned long mask[OMB_MAX_NUMA_NODES / (8 * sizeof(long))];
+    unsigned cpu = 0, local = 0;
+    int node = options.numa_node, mode = OMB_MPOL_BIND;
+
+    if (0 == read_numa_nodes(online)) {
+        fprintf(stderr, "Could not read the online NUMA nodes\n");
+        return 1;
+    }
+
+#ifdef SYS_getcpu
+    syscall(SYS_getcpu, &cpu, &local, NULL);
+#endif
+
+    switch (options.numa_policy) {
+        case NUMA_LOCAL:
+            node = local;
+            break;
+        case NUMA_REMOTE:
+            /* the next online node after the local one, wrapping around */
+            for (node = (local + 1) % OMB_MAX_NUMA_NODES;
+                    !numa_node_online(online, node) && node != (int)local;
+                    node = (node + 1) % OMB_MAX_NUMA_NODES);
+            if (node == (int)local) {
+                fprintf(stderr, "--numa remote needs a second NUMA node\n");
+                return 1;
+            }
+            break;
+        case NUMA_INTERLEAVE:
+            mode = OMB_MPOL_INTERLEAVE;
+            break;
+        default:
+            break;
+    }
+
+    if (OMB_MPOL_INTERLEAVE == mode) {
+        memcpy(mask, online, sizeof(mask));
+    } else if (numa_node_online(online, node)) {
+        memset(mask, 0, sizeof(mask));
+        mask[node / (8 * sizeof(long))] = 1UL << (node % (8 * sizeof(long)));
+    } else {
+        fprintf(stderr, "NUMA node %d is not online\n", node);
+        return 1;
+    }
+
+#ifdef SYS_mbind
+    if (syscall(SYS_mbind, addr, len, mode, mask, OMB_MAX_NUMA_NODES + 1, 0)) {
+        perror("mbind");
+        return 1;
+    }
+
+    return 0;
+#else
+    fprintf(stderr, "--numa is not supported on this platform\n");
+    return 1;
+#endif
+}
+
+int allocate_host_buffer (void ** buffer, size_t size)
+{
+    size_t page = sysconf(_SC_PAGESIZE), base_page = page, len, off;
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+    struct host_mapping *map;
+    char *addr, *aligned;
+
+    if (PAGE_DEFAULT == options.page_policy &&
+            NUMA_NONE == options.numa_policy && !options.prefault) {
+        return posix_memalign(buffer, page, size);
+    }
+
+    switch (options.page_policy) {
+        case PAGE_THP:
+            page = 1 << 21;
+            break;
+        case PAGE_HUGE_2M:
+            page = 1 << 21;
+            flags |= MAP_HUGETLB | MAP_HUGE_2MB;
+            break;
+        case PAGE_HUGE_1G:
+            page = 1 << 30;
+            flags |= MAP_HUGETLB | MAP_HUGE_1GB;
+            break;
+        default:
+            break;
+    }
+
+    /* pages must not be faulted before mbind places them */
+    if (options.prefault && NUMA_NONE == options.numa_policy) {
+        flags |= MAP_POPULATE;
+    }
+
+    len = (MAX(size, 1) + page - 1) / page * page;
+
+    if (PAGE_THP == options.page_policy) {
+        /* over-map and trim so the buffer starts on a 2M boundary */
+        addr = mmap(NULL, len + page, PROT_READ | PROT_WRITE, flags, -1, 0);
+        if (MAP_FAILED != addr) {
+            aligned = (char *)align_buffer(addr, page);
+            if (aligned > addr) {
+                munmap(addr, aligned - addr);
+            }
+            munmap(aligned + len, addr + page - aligned);
+            addr = aligned;
+            madvise(addr, len, MADV_HUGEPAGE);
+        }
+    } else {
+        addr = mmap(NULL, len, PROT_READ | PROT_WRITE, flags, -1, 0);
+    }
+
+    if (MAP_FAILED == addr) {
+        fprintf(stderr, "Could not map %zu bytes%s\n", len,
+                flags & MAP_HUGETLB ? " of hugetlbfs pages" : "");
+        perror("mmap");
+        return 1;
+    }
+
+    if (NUMA_NONE != options.numa_policy && bind_host_buffer(addr, len)) {
+        munmap(addr, len);
+        return 1;
+    }
+
+    if (options.prefault && NUMA_NONE != options.numa_policy) {
+        for (off = 0; off < len; off += base_page) {
+            ((volatile char *)addr)[off] = 0;
+        }
+    }
+
+    map = malloc(sizeof(struct host_mapping));
+    if (NULL == map) {
+        munmap(addr, len);
+        return 1;
+    }
+    map->addr = addr;
+    map->len = len;
+    map->next = host_mappings;
+    host_mappings = map;
+
+    *buffer = addr;
+
+    return 0;
+}
+
+void free_host_buffer (void * buffer)
+{
+    struct host_mapping **prev, *map;
+
+    if (NULL == buffer) {
+        return;
+    }
+
+    for (prev = &host_mappings; *prev; prev = &(*prev)->next) {
+        if ((*prev)->addr == buffer) {
+            map = *prev;
+            *prev = map->next;
+            munmap(map->addr, map->len);
+            free(map);
+            return;
+        }
+    }
+
+    free(buffer);
+}
+
+/*
+ * Cache State
+ */
+int allocate_cache_pool (size_t max_size)
+{
+    size_t stride = MAX(max_size, 1);
+#ifdef CACHE_FLUSH_INSN
+    int evict = CACHE_COLD == options.cache_state;
+#else
+    int evict = CACHE_HOT != options.cache_state;
+#endif
+
+    cache_pool.len = evict ? 2 * cache_llc_size() : 0;
+    if (FRESH_POOL == options.fresh_buffers) {
+        cache_pool.len = MAX(cache_pool.len, options.fresh_pool_size);
+    }
+
+    if (0 == cache_pool.len) {
+        return 0;
+    }
+
+    stride = (stride + MESSAGE_ALIGNMENT_MR - 1) / MESSAGE_ALIGNMENT_MR *
+        MESSAGE_ALIGNMENT_MR;
+    cache_pool.len = MAX(cache_pool.len, 2 * stride);
+
+    if (allocate_host_buffer((void **)&cache_pool.base, cache_pool.len)) {
+        return 1;
+    }
+
+    /* fault the pool in so that the cold pass does not time page faults */
+    memset(cache_pool.base, 0, cache_pool.len);
+
+    return 0;
+}
+
+void free_cache_pool (void)
+{
+    free_host_buffer(cache_pool.base);
+    cache_pool.base = NULL;
+    free(cache_pool.fresh);
+    free(cache_pool.fresh_len);
+    cache_pool.fresh = NULL;
+    cache_pool.fresh_len = NULL;
+    cache_pool.fresh_max = 0;
+}
+
+static size_t cache_line_size (void)
+{
+    long line = 0;
+
+#ifdef _SC_LEVEL1_DCACHE_LINESIZE
+    line = sysconf(_SC_LEVEL1_DCACHE_LINESIZE);
+#endif
+
+    return line > 0 ? line : 64;
+}
+
+/*
+ * SIZE-byte slot INDEX of the pool, with slots ALIGN bytes apart.  The slot
+ * count is rounded down to a power of two and an odd multiplier scatters
+ * consecutive indices over it, so a slot is reused only after every other
+ * slot and the prefetchers cannot run ahead of the sequence.
+ */
+static void * pool_slot (int index, size_t size, size_t align)
+{
+    size_t stride = (MAX(size, 1) + align - 1) / align * align;
+    size_t slots = cache_pool.len / stride;
+
+    while (slots & (slots - 1)) {
+        slots &= slots - 1;
+    }
+
+    return cache_pool.base +
+        ((size_t)index * 2654435761UL & (slots - 1)) * stride;
+}
+
+/*
+ * Slot INDEX for a SIZE-byte buffer of the cold pass.  Slots are packed at
+ * cache-line stride, so a small buffer is reused only after the whole pool
+ * has been touched, not after a few KB.
+ */
+void * cache_buffer (int index, size_t size)
+{
+    return pool_slot(index, size, cache_line_size());
+}
+
+void flush_cache (void const * buffer, size_t size)
+{
+#ifdef CACHE_FLUSH_INSN
+    char const *p = buffer, *end = p + size;
+    size_t line = cache_line_size();
+
+    for (p -= (uintptr_t)p % line; p < end; p += line) {
+#if defined(__SSE2__)
+        _mm_clflush(p);
+#else
+        __asm__ __volatile__("dc civac, %0" : : "r" (p) : "memory");
+#endif
+    }
+
+#if defined(__SSE2__)
+    _mm_mfence();
+#else
+    __asm__ __volatile__("dsb ish" : : : "memory");
+#endif
+#else
+    memset(cache_pool.base, 0, cache_pool.len);
+#endif
+}
+
+void set_cold_latency (double latency)
+{
+    cache_pool.latency = latency;
+}
+
+static void release_fresh_buffer (int i)
+{
+    if (FRESH_MMAP == options.fresh_buffers) {
+        munmap(cache_pool.fresh[i], cache_pool.fresh_len[i]);
+    } else {
+        free(cache_pool.fresh[i]);
+    }
+    cache_pool.fresh_held -= cache_pool.fresh_len[i];
+}
+
+/*
+ * Buffer INDEX of the fresh-buffer pass. Buffers from malloc and mmap are
+ * written once so that page faults stay out of the timed region, leaving the
+ * registration by the library as the cost of the first use.
+ */
+void * fresh_buffer (int index, size_t size)
+{
+    void *buffer = NULL;
+    int held;
+
+    /* registration is per page, so fresh slots start on new pages */
+    if (FRESH_POOL == options.fresh_buffers) {
+        return pool_slot(index, size, MESSAGE_ALIGNMENT_MR);
+    }
+
+    /* past the memory limit, drop the oldest buffers but the last one */
+    while (cache_pool.fresh_held + MAX(size, 1) > options.max_mem_limit &&
+            cache_pool.fresh_first < cache_pool.fresh_count - 1) {
+        release_fresh_buffer(cache_pool.fresh_first++);
+    }
+
+    if (cache_pool.fresh_count == cache_pool.fresh_max) {
+        held = cache_pool.fresh_count - cache_pool.fresh_first;
+        if (held < cache_pool.fresh_max / 2) {
+            memmove(cache_pool.fresh, cache_pool.fresh +
+                    cache_pool.fresh_first, held * sizeof(void *));
+            memmove(cache_pool.fresh_len, cache_pool.fresh_len +
+                    cache_pool.fresh_first, held * sizeof(size_t));
+            cache_pool.fresh_first = 0;
+            cache_pool.fresh_count = held;
+        } else {
+            cache_pool.fresh_max = MAX(2 * cache_pool.fresh_max, 64);
+            cache_pool.fresh = realloc(cache_pool.fresh,
+                    cache_pool.fresh_max * sizeof(void *));
+            cache_pool.fresh_len = realloc(cache_pool.fresh_len,
+                    cache_pool.fresh_max * sizeof(size_t));
+            if (NULL == cache_pool.fresh || NULL == cache_pool.fresh_len) {
+                fprintf(stderr, "Could Not Allocate Memory for fresh buffers\n");
+                MPI_CHECK(MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE));
+            }
+        }
+    }
+
+    switch (options.fresh_buffers) {
+        case FRESH_MMAP:
+            buffer = mmap(NULL, MAX(size, 1), PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (MAP_FAILED == buffer) {
+                buffer = NULL;
+            }
+            break;
+        default:
+            buffer = malloc(MAX(size, 1));
+            break;
+    }
+
+    if (NULL == buffer) {
+        fprintf(stderr, "Could Not Allocate Memory for fresh buffers\n");
+        MPI_CHECK(MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE));
+    }
+
+    memset(buffer, index, size);
+
+    cache_pool.fresh[cache_pool.fresh_count] = buffer;
+    cache_pool.fresh_len[cache_pool.fresh_count] = MAX(size, 1);
+    cache_pool.fresh_held += MAX(size, 1);
+    cache_pool.fresh_count++;
+
+    return buffer;
+}
+
+/* Release the buffers of the fresh-buffer pass once it has finished */
+void free_fresh_buffers (void)
+{
+    int i;
+
+    for (i = cache_pool.fresh_first; i < cache_pool.fresh_count; i++) {
+        release_fresh_buffer(i);
+    }
+
+    cache_pool.fresh_first = 0;
+    cache_pool.fresh_count = 0;
+}
+
+void set_fresh_latency (double latency)
+{
+    cache_pool.fresh_latency = latency;
+}
+
 int allocate_memory_coll (void ** buffer, size_t size, enum accel_type type)
 {
     if (options.target == CPU || options.target == BOTH) {
         allocate_host_arrays();
     }
 
-    size_t alignment = sysconf(_SC_PAGESIZE);
-
     switch (type) {
         case NONE:
-            return posix_memalign(buffer, alignment, size);
+            return allocate_host_buffer(buffer, size);
 #ifdef _ENABLE_CUDA_
         case CUDA:
             CUDA_CHECK(cudaMalloc(buffer, size));
@@ -1142,9 +3990,7 @@ int allocate_managed_buffer_size (char ** buffer, size_t size)
 }
 int allocate_memory_pt2pt_mul (char ** sbuf, char ** rbuf, int rank, int pairs)
 {
-    unsigned long align_size = sysconf(_SC_PAGESIZE);
-
-    if (rank < pairs) {
+    if (pair_sender_side(rank, pairs)) {
         if ('D' == options.src) {
             if (allocate_device_buffer(sbuf)) {
                 fprintf(stderr, "Error allocating cuda memory\n");
@@ -1166,12 +4012,12 @@ int allocate_memory_pt2pt_mul (char ** sbuf, char ** rbuf, int rank, int pairs)
                 return 1;
             }
         } else {
-            if (posix_memalign((void**)sbuf, align_size, options.max_message_size)) {
+            if (allocate_host_buffer((void**)sbuf, options.max_message_size)) {
                 fprintf(stderr, "Error allocating host memory\n");
                 return 1;
             }
 
-            if (posix_memalign((void**)rbuf, align_size, options.max_message_size)) {
+            if (allocate_host_buffer((void**)rbuf, options.max_message_size)) {
                 fprintf(stderr, "Error allocating host memory\n");
                 return 1;
             }
@@ -1201,12 +4047,12 @@ int allocate_memory_pt2pt_mul (char ** sbuf, char ** rbuf, int rank, int pairs)
                 return 1;
             }
         } else {
-            if (posix_memalign((void**)sbuf, align_size, options.max_message_size)) {
+            if (allocate_host_buffer((void**)sbuf, options.max_message_size)) {
                 fprintf(stderr, "Error allocating host memory\n");
                 return 1;
             }
 
-            if (posix_memalign((void**)rbuf, align_size, options.max_message_size)) {
+            if (allocate_host_buffer((void**)rbuf, options.max_message_size)) {
                 fprintf(stderr, "Error allocating host memory\n");
                 return 1;
             }
@@ -1221,7 +4067,6 @@ int allocate_memory_pt2pt_mul (char ** sbuf, char ** rbuf, int rank, int pairs)
 int allocate_memory_pt2pt_mul_size (char ** sbuf, char ** rbuf, int rank, int pairs, size_t allocate_size)
 {
     size_t size;
-    unsigned long align_size = sysconf(_SC_PAGESIZE);
 
     if (allocate_size == 0) {
         size = 1;
@@ -1229,7 +4074,7 @@ int allocate_memory_pt2pt_mul_size (char ** sbuf, char ** rbuf, int rank, int pa
         size = allocate_size;
     }
 
-    if (rank < pairs) {
+    if (pair_sender_side(rank, pairs)) {
         if ('D' == options.src) {
             if (allocate_device_buffer(sbuf)) {
                 fprintf(stderr, "Error allocating cuda memory\n");
@@ -1251,12 +4096,12 @@ int allocate_memory_pt2pt_mul_size (char ** sbuf, char ** rbuf, int rank, int pa
                 return 1;
             }
         } else {
-            if (posix_memalign((void**)sbuf, align_size, size)) {
+            if (allocate_host_buffer((void**)sbuf, size)) {
                 fprintf(stderr, "Error allocating host memory\n");
                 return 1;
             }
 
-            if (posix_memalign((void**)rbuf, align_size, size)) {
+            if (allocate_host_buffer((void**)rbuf, size)) {
                 fprintf(stderr, "Error allocating host memory\n");
                 return 1;
             }
@@ -1286,12 +4131,12 @@ int allocate_memory_pt2pt_mul_size (char ** sbuf, char ** rbuf, int rank, int pa
                 return 1;
             }
         } else {
-            if (posix_memalign((void**)sbuf, align_size, size)) {
+            if (allocate_host_buffer((void**)sbuf, size)) {
                 fprintf(stderr, "Error allocating host memory\n");
                 return 1;
             }
 
-            if (posix_memalign((void**)rbuf, align_size, size)) {
+            if (allocate_host_buffer((void**)rbuf, size)) {
                 fprintf(stderr, "Error allocating host memory\n");
                 return 1;
             }
@@ -1305,8 +4150,6 @@ int allocate_memory_pt2pt_mul_size (char ** sbuf, char ** rbuf, int rank, int pa
 
 int allocate_memory_pt2pt (char ** sbuf, char ** rbuf, int rank)
 {
-    unsigned long align_size = sysconf(_SC_PAGESIZE);
-
     switch (rank) {
         case 0:
             if ('D' == options.src) {
@@ -1330,12 +4173,12 @@ int allocate_memory_pt2pt (char ** sbuf, char ** rbuf, int rank)
                     return 1;
                 }
             } else {
-                if (posix_memalign((void**)sbuf, align_size, options.max_message_size)) {
+                if (allocate_host_buffer((void**)sbuf, options.max_message_size)) {
                     fprintf(stderr, "Error allocating host memory\n");
                     return 1;
                 }
 
-                if (posix_memalign((void**)rbuf, align_size, options.max_message_size)) {
+                if (allocate_host_buffer((void**)rbuf, options.max_message_size)) {
                     fprintf(stderr, "Error allocating host memory\n");
                     return 1;
                 }
@@ -1363,12 +4206,12 @@ int allocate_memory_pt2pt (char ** sbuf, char ** rbuf, int rank)
                     return 1;
                 }
             } else {
-                if (posix_memalign((void**)sbuf, align_size, options.max_message_size)) {
+                if (allocate_host_buffer((void**)sbuf, options.max_message_size)) {
                     fprintf(stderr, "Error allocating host memory\n");
                     return 1;
                 }
 
-                if (posix_memalign((void**)rbuf, align_size, options.max_message_size)) {
+                if (allocate_host_buffer((void**)rbuf, options.max_message_size)) {
                     fprintf(stderr, "Error allocating host memory\n");
                     return 1;
                 }
@@ -1382,7 +4225,6 @@ int allocate_memory_pt2pt (char ** sbuf, char ** rbuf, int rank)
 int allocate_memory_pt2pt_size (char ** sbuf, char ** rbuf, int rank, size_t allocate_size)
 {
     size_t size;
-    unsigned long align_size = sysconf(_SC_PAGESIZE);
 
     if (allocate_size == 0) {
         size = 1;
@@ -1413,12 +4255,12 @@ int allocate_memory_pt2pt_size (char ** sbuf, char ** rbuf, int rank, size_t all
                     return 1;
                 }
             } else {
-                if (posix_memalign((void**)sbuf, align_size, size)) {
+                if (allocate_host_buffer((void**)sbuf, size)) {
                     fprintf(stderr, "Error allocating host memory\n");
                     return 1;
                 }
 
-                if (posix_memalign((void**)rbuf, align_size, size)) {
+                if (allocate_host_buffer((void**)rbuf, size)) {
                     fprintf(stderr, "Error allocating host memory\n");
                     return 1;
                 }
@@ -1446,12 +4288,12 @@ int allocate_memory_pt2pt_size (char ** sbuf, char ** rbuf, int rank, size_t all
                     return 1;
                 }
             } else {
-                if (posix_memalign((void**)sbuf, align_size, size)) {
+                if (allocate_host_buffer((void**)sbuf, size)) {
                     fprintf(stderr, "Error allocating host memory\n");
                     return 1;
                 }
 
-                if (posix_memalign((void**)rbuf, align_size, size)) {
+                if (allocate_host_buffer((void**)rbuf, size)) {
                     fprintf(stderr, "Error allocating host memory\n");
                     return 1;
                 }
@@ -1490,11 +4332,11 @@ void allocate_memory_one_sided(int rank, char **user_buf,
         CHECK(allocate_device_buffer_one_sided(win_base, size));
         set_device_memory(*win_base, 'a', size);
     } else {
-        CHECK(posix_memalign((void **)user_buf, page_size, size));
+        CHECK(allocate_host_buffer((void **)user_buf, size));
         memset(*user_buf, 'a', size);
         /* only explicitly allocate buffer for win_base when NOT using MPI_Win_allocate */
         if (type != WIN_ALLOCATE) {
-            CHECK(posix_memalign((void **)win_base, page_size, size));
+            CHECK(allocate_host_buffer((void **)win_base, size));
             memset(*win_base, 'a', size);
         }
     }
@@ -1510,10 +4352,11 @@ void allocate_memory_one_sided(int rank, char **user_buf,
             MPI_CHECK(MPI_Win_create_dynamic(MPI_INFO_NULL, MPI_COMM_WORLD, win));
             MPI_CHECK(MPI_Win_attach(*win, (void *)*win_base, size));
             MPI_CHECK(MPI_Get_address(*win_base, &disp_local));
+            /* only ranks 0 and 1 pair up; others exchange disp_local as needed */
             if(rank == 0){
                 MPI_CHECK(MPI_Send(&disp_local, 1, MPI_AINT, 1, 1, MPI_COMM_WORLD));
                 MPI_CHECK(MPI_Recv(&disp_remote, 1, MPI_AINT, 1, 1, MPI_COMM_WORLD, &reqstat));
-            } else {
+            } else if (rank == 1) {
                 MPI_CHECK(MPI_Recv(&disp_remote, 1, MPI_AINT, 0, 1, MPI_COMM_WORLD, &reqstat));
                 MPI_CHECK(MPI_Send(&disp_local, 1, MPI_AINT, 0, 1, MPI_COMM_WORLD));
             }
@@ -1535,7 +4378,7 @@ void free_buffer (void * buffer, enum accel_type type)
 {
     switch (type) {
         case NONE:
-            free(buffer);
+            free_host_buffer(buffer);
             break;
         case MANAGED:
         case CUDA:
@@ -1746,25 +4589,17 @@ void free_memory (void * sbuf, void * rbuf, int rank)
                 free_device_buffer(sbuf);
                 free_device_buffer(rbuf);
             } else {
-                if (sbuf) {
-                    free(sbuf);
-                }
-                if (rbuf) {
-                    free(rbuf);
-                }
+                free_host_buffer(sbuf);
+                free_host_buffer(rbuf);
             }
             break;
-        case 1:
+        default:
             if ('D' == options.dst || 'M' == options.dst) {
                 free_device_buffer(sbuf);
                 free_device_buffer(rbuf);
             } else {
-                if (sbuf) {
-                    free(sbuf);
-                }
-                if (rbuf) {
-                    free(rbuf);
-                }
+                free_host_buffer(sbuf);
+                free_host_buffer(rbuf);
             }
             break;
     }
@@ -1772,21 +4607,21 @@ void free_memory (void * sbuf, void * rbuf, int rank)
 
 void free_memory_pt2pt_mul (void * sbuf, void * rbuf, int rank, int pairs)
 {
-    if (rank < pairs) {
+    if (pair_sender_side(rank, pairs)) {
         if ('D' == options.src || 'M' == options.src) {
             free_device_buffer(sbuf);
             free_device_buffer(rbuf);
         } else {
-            free(sbuf);
-            free(rbuf);
+            free_host_buffer(sbuf);
+            free_host_buffer(rbuf);
         }
     } else {
         if ('D' == options.dst || 'M' == options.dst) {
             free_device_buffer(sbuf);
             free_device_buffer(rbuf);
         } else {
-            free(sbuf);
-            free(rbuf);
+            free_host_buffer(sbuf);
+            free_host_buffer(rbuf);
         }
     }
 }
@@ -2057,16 +4892,16 @@ void allocate_atomic_memory(int rank,
             set_device_memory(*cbuf, 'a', size);
         }
     } else {
-        CHECK(posix_memalign((void **)sbuf, page_size, size));
+        CHECK(allocate_host_buffer((void **)sbuf, size));
         memset(*sbuf, 'a', size);
         if (type != WIN_ALLOCATE) {
-            CHECK(posix_memalign((void **)win_base, page_size, size));
+            CHECK(allocate_host_buffer((void **)win_base, size));
             memset(*win_base, 'b', size);
         }
-        CHECK(posix_memalign((void **)tbuf, page_size, size));
+        CHECK(allocate_host_buffer((void **)tbuf, size));
         memset(*tbuf, 'c', size);
         if (cbuf != NULL) {
-            CHECK(posix_memalign((void **)cbuf, page_size, size));
+            CHECK(allocate_host_buffer((void **)cbuf, size));
             memset(*cbuf, 'a', size);
         }
     }
@@ -2122,14 +4957,12 @@ void free_atomic_memory (void *sbuf, void *win_baseptr, void *tbuf, void *cbuf,
             free_device_buffer(cbuf);
         }
     } else {
-        free(sbuf);
+        free_host_buffer(sbuf);
         if (win_type != WIN_ALLOCATE) {
-            free(win_baseptr);
-        }
-        free(tbuf);
-        if (cbuf != NULL) {
-            free(cbuf);
+            free_host_buffer(win_baseptr);
         }
+        free_host_buffer(tbuf);
+        free_host_buffer(cbuf);
     }
 }
 
@@ -26,6 +26,33 @@ do {                                                             \
 extern MPI_Aint disp_remote;
 extern MPI_Aint disp_local;
 
+/*
+ * Blocking Collectives
+ */
+struct coll_args {
+    void *sendbuf;
+    void *recvbuf;
+    int count;          /* elements per rank, MPI_CHAR or MPI_FLOAT */
+    int *counts;        /* per-rank counts and displacements, v variants */
+    int *displs;
+};
+
+void coll_allgather (struct coll_args const * args);
+void coll_allgatherv (struct coll_args const * args);
+void coll_allreduce (struct coll_args const * args);
+void coll_alltoall (struct coll_args const * args);
+void coll_alltoallv (struct coll_args const * args);
+void coll_barrier (struct coll_args const * args);
+void coll_bcast (struct coll_args const * args);
+void coll_gather (struct coll_args const * args);
+void coll_gatherv (struct coll_args const * args);
+void coll_reduce (struct coll_args const * args);
+void coll_reduce_scatter (struct coll_args const * args);
+void coll_scatter (struct coll_args const * args);
+void coll_scatterv (struct coll_args const * args);
+void coll_counts_uniform (struct coll_args * args, int numprocs);
+void coll_counts_split (struct coll_args * args, int numprocs);
+
 /*
  * Non-blocking Collectives
  */
@@ -77,9 +104,128 @@ void print_stats_nbc (int rank, int size, double ovrl, double cpu, double avg_co
                       double min_comm, double max_comm,
                       double wait, double init, double test);
 
+/*
+ * Latency Distribution
+ */
+int allocate_latency_samples (void);
+void free_latency_samples (void);
+void record_latency_sample (double latency);
+void reduce_latency_samples (MPI_Comm comm);
+void print_latency_dist (int rank);
+void adaptive_begin (void);
+void adaptive_check (MPI_Comm comm, int i);
+
+/*
+ * Message Sizes
+ */
+int first_message_size (int unit);
+int next_message_size (int size, int unit);
+
+/*
+ * Clock Synchronization
+ */
+void sync_clocks (MPI_Comm comm);
+void resync_clocks (MPI_Comm comm);
+double global_time (void);
+double clock_sync_error (void);
+
+/*
+ * Iteration Synchronization
+ */
+void iteration_sync_begin (MPI_Comm comm);
+void iteration_sync (MPI_Comm comm);
+void iteration_sync_end (MPI_Comm comm);
+
+/*
+ * Arrival and Exit Skew
+ */
+int allocate_skew_samples (void);
+void free_skew_samples (void);
+void record_skew_sample (int iteration, double arrival, double exit);
+void reduce_skew_samples (MPI_Comm comm, int count);
+void print_stats_pap (int rank, int size, double avg_time, double min_time,
+                      double max_time, int errors);
+
+/*
+ * Arrival Patterns
+ */
+int init_arrival_pattern (int rank, int numprocs);
+void free_arrival_pattern (void);
+double arrival_delay (size_t size, int iteration, double unit);
+void print_arrival_pattern (int rank);
+
+/*
+ * Pair Placement
+ */
+int init_pairing (int rank, int numprocs, int pairs);
+int pair_partner (void);
+int pair_initiator (void);
+void print_pairing (int rank);
+
+/*
+ * Thread Placement
+ */
+int pin_thread (int index);
+void sync_threads (struct spin_barrier * barrier, MPI_Comm comm, int index,
+        int * sense);
+
+/*
+ * Persistent Requests
+ */
+void init_persistent_requests (char ** buf, int size, int peer, int tag,
+        int send, int count, MPI_Request * req);
+void free_persistent_requests (int count, MPI_Request * req);
+
+#ifdef HAVE_MPI_PSEND_INIT
+/*
+ * Partitioned Communication
+ */
+struct partition_set {
+    int partitioned;
+    int send;
+    int count;
+    int chunk;
+    int peer;
+    int tag;
+    char * buf;
+    MPI_Comm comm;
+    MPI_Request * req;
+};
+
+int init_partition_threads (int send);
+void free_partition_threads (void);
+void init_partition_set (struct partition_set * set, char * buf, int size,
+        int peer, int tag, int send, int count, int partitioned);
+void start_partitions (struct partition_set * set);
+void ready_partitions (struct partition_set * set);
+void wait_partitions (struct partition_set * set);
+void free_partition_set (struct partition_set * set);
+#endif
+
+#if MPI_VERSION >= 2
+/*
+ * Derived Datatypes
+ */
+extern char const * ddt_constructor[DDT_NUM_TYPES];
+size_t ddt_extent (void);
+MPI_Datatype create_ddt (enum ddt_type type, int nblocks);
+void pack_blocks (char * dst, char const * src, int nblocks);
+void unpack_blocks (char * dst, char const * src, int nblocks);
+#endif
+
 /*
  * Memory Management
  */
+int allocate_host_buffer (void ** buffer, size_t size);
+void free_host_buffer (void * buffer);
+int allocate_cache_pool (size_t max_size);
+void free_cache_pool (void);
+void * cache_buffer (int index, size_t size);
+void flush_cache (void const * buffer, size_t size);
+void set_cold_latency (double latency);
+void * fresh_buffer (int index, size_t size);
+void free_fresh_buffers (void);
+void set_fresh_latency (double latency);
 int allocate_memory_coll (void ** buffer, size_t size, enum accel_type type);
 void free_buffer (void * buffer, enum accel_type type);
 void set_buffer (void * buffer, enum accel_type type, int data, size_t size);
@@ -70,6 +70,12 @@ min_time, double max_time, int iterations)
         }
 
         fflush(stdout);
+
+        omb_result_begin(size, iterations);
+        omb_result_field("latency_us", avg_time);
+        omb_result_field("min_latency_us", min_time);
+        omb_result_field("max_latency_us", max_time);
+        omb_result_end();
     }
 }
 
@@ -97,6 +103,11 @@ void print_usage_pgas(int rank, const char * prog, int has_size)
         fprintf(stdout, "                      the MIN/MAX latency and number of ITERATIONS are\n");
         fprintf(stdout, "                      printed out in addition to the AVERAGE latency.\n");
 
+        fprintf(stdout, "  --output-format    : Also write results as json or csv records.\n");
+        fprintf(stdout, "                       By default, $OMB_OUTPUT_FORMAT or text.\n");
+        fprintf(stdout, "  --output-file      : Append json or csv records to FILE.\n");
+        fprintf(stdout, "                       By default, $OMB_OUTPUT_FILE or stdout.\n");
+
         fprintf(stdout, "  -h, --help         : Print this help.\n");
         fprintf(stdout, "  -v, --version      : Print version info.\n");
         fprintf(stdout, "\n");